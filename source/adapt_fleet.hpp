@@ -0,0 +1,374 @@
+﻿#pragma once
+//  ---------------------------------------------
+//  Adapt the files of all the machine folders
+//  found in a directory tree, each one to the
+//  machine type declared in its MachSettings.udt,
+//  or update them all to a newer MachSettings.udt
+//  ---------------------------------------------
+//  #include "adapt_fleet.hpp" // app::adapt_fleet(), app::update_fleet()
+//  ---------------------------------------------
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <optional>
+#include <format>
+#include <filesystem> // std::filesystem
+
+#include "string_utilities.hpp" // str::to_lower
+#include "options_set.hpp" // MG::options_set
+#include "thread_pool.hpp" // MG::thread_pool
+#include "adapt_udt_file.hpp" // app::overlay_udt_for(), app::extract_mach_data_from()
+#include "adapt_parax_file.hpp" // app::overlay_parax_for()
+#include "handle_output_file.hpp" // app::replace_file_with()
+
+namespace fs = std::filesystem;
+using namespace std::literals; // "..."sv
+
+
+namespace app //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+/////////////////////////////////////////////////////////////////////////////
+// The files of a machine folder in a fleet:
+//   <machine>/userdata/MachSettings.udt
+//   <machine>/param/par2kax.txt
+class FleetMachine final
+{
+ private:
+    fs::path m_udt_path;
+    fs::path m_parax_path;
+
+ public:
+    [[nodiscard]] const fs::path& udt_path() const noexcept { return m_udt_path; }
+    void set_udt_path(const fs::path& pth) { m_udt_path = pth; }
+
+    [[nodiscard]] const fs::path& parax_path() const noexcept { return m_parax_path; }
+    void set_parax_path(const fs::path& pth) { m_parax_path = pth; }
+};
+
+
+//---------------------------------------------------------------------------
+[[nodiscard]] std::vector<FleetMachine> collect_fleet_machines(const fs::path& fleet_dir)
+{
+    std::map<fs::path, FleetMachine> machs_by_dir; // Sorted for a stable report
+
+    for( const auto& entry : fs::recursive_directory_iterator(fleet_dir, fs::directory_options::skip_permission_denied) )
+       {
+        if( not entry.is_regular_file() )
+           {
+            continue;
+           }
+        const fs::path& pth = entry.path();
+        const std::string fnam{ str::to_lower(pth.filename().string()) };
+        const std::string dirnam{ str::to_lower(pth.parent_path().filename().string()) };
+        if( fnam=="machsettings.udt"sv and dirnam=="userdata"sv )
+           {
+            machs_by_dir[pth.parent_path().parent_path()].set_udt_path(pth);
+           }
+        else if( fnam=="par2kax.txt"sv and dirnam=="param"sv )
+           {
+            machs_by_dir[pth.parent_path().parent_path()].set_parax_path(pth);
+           }
+       }
+
+    std::vector<FleetMachine> machs;
+    machs.reserve( machs_by_dir.size() );
+    for( auto& [dir, mach] : machs_by_dir )
+       {
+        machs.push_back( std::move(mach) );
+       }
+    return machs;
+}
+
+
+//---------------------------------------------------------------------------
+// Write the adapted file in a temporary that will replace the original
+[[nodiscard]] fs::path write_adapted_temp(const sipro::TxtFile& file, const fs::path& orig_path, const sipro::TxtOverlay& overlay, const MG::options_set& options, const std::string_view add_info ={})
+{
+    fs::path temp_path = orig_path.parent_path() / std::format("~{}.tmp"sv, orig_path.filename().string());
+    file.write_to(temp_path.string(), overlay, options, add_info);
+    return temp_path;
+}
+
+
+//---------------------------------------------------------------------------
+// Adapt the files of a machine folder, returning the report lines
+[[nodiscard]] std::string adapt_fleet_machine( const FleetMachine& fleet_mach,
+                                               const macotec::ParamsDB* const udt_db,
+                                               const macotec::ParamsDB* const parax_db,
+                                               const MG::options_set& options,
+                                               fnotify_t const& notify_issue )
+{
+    std::string report;
+    if( fleet_mach.udt_path().empty() )
+       {
+        notify_issue( std::format("{}: no userdata/MachSettings.udt to infer the machine from", fleet_mach.parax_path().string()) );
+        return report;
+       }
+
+    macotec::MachineData mach_data;
+    std::optional<fs::path> adapted_udt;
+       {
+        const udt::File udt_file(fleet_mach.udt_path().string(), std::ref(notify_issue));
+        mach_data = extract_mach_data_from(udt_file);
+        if( not mach_data or mach_data.is_incomplete() )
+           {
+            notify_issue( std::format("{}: can't infer a complete machine type from {}", udt_file.path(), machname_field_label) );
+            return report;
+           }
+        if( udt_db )
+           {
+            sipro::TxtOverlay overlay;
+            overlay_udt_for(udt_file, *udt_db, mach_data, overlay, notify_issue);
+            adapted_udt = write_adapted_temp(udt_file, fleet_mach.udt_path(), overlay, options);
+            report += std::format("  {}: {}, modified {} values, {} issues\n", udt_file.path(), mach_data.string(), overlay.modified_values_count(), overlay.mod_issues().size());
+           }
+       } // Original file no more mapped in memory
+    if( adapted_udt )
+       {
+        replace_file_with(fleet_mach.udt_path(), *adapted_udt);
+       }
+
+    if( parax_db and not fleet_mach.parax_path().empty() )
+       {
+        std::optional<fs::path> adapted_parax;
+           {
+            const parax::File parax_file(fleet_mach.parax_path().string(), notify_issue);
+            sipro::TxtOverlay overlay;
+            overlay_parax_for(parax_file, *parax_db, mach_data, overlay, notify_issue);
+            adapted_parax = write_adapted_temp(parax_file, fleet_mach.parax_path(), overlay, options, std::format("Machine: {}", mach_data.string()));
+            report += std::format("  {}: {}, modified {} values, {} issues\n", parax_file.path(), mach_data.string(), overlay.modified_values_count(), overlay.mod_issues().size());
+           }
+        replace_file_with(fleet_mach.parax_path(), *adapted_parax);
+       }
+
+    return report;
+}
+
+
+//---------------------------------------------------------------------------
+// Adapt all the MachSettings.udt and par2kax.txt found in the fleet
+// directory, parsing the overlays databases just once. Each machine
+// folder is an independent task scheduled on a thread pool
+template<typename FPRINT>
+void adapt_fleet( const std::string& fleet_dir,
+                  const std::string& udt_db_file,
+                  const std::string& parax_db_file,
+                  const MG::options_set& options,
+                  FPRINT const& verbose_print,
+                  fnotify_t const& notify_issue )
+{
+    const std::vector<FleetMachine> fleet_machs = collect_fleet_machines(fleet_dir);
+    verbose_print("  Found {} machine folders in {}\n", fleet_machs.size(), fleet_dir);
+
+    // [Parameters DBs]
+    std::optional<macotec::ParamsDB> udt_db, parax_db;
+    if( not udt_db_file.empty() )
+       {
+        udt_db.emplace(udt_db_file, notify_issue, macotec::ParamsDB::parsing::indexed);
+        verbose_print("  udt DB: {}\n", udt_db->info_string());
+       }
+    if( not parax_db_file.empty() )
+       {
+        parax_db.emplace(parax_db_file, notify_issue, macotec::ParamsDB::parsing::indexed);
+        verbose_print("  parax DB: {}\n", parax_db->info_string());
+       }
+
+    const fnotify_t notify_issue_mt = MG::make_thread_safe(notify_issue);
+    std::vector<std::string> reports( fleet_machs.size() );
+       {
+        MG::thread_pool pool;
+        for( std::size_t i=0; i<fleet_machs.size(); ++i )
+           {
+            pool.submit([&, i]
+               {
+                try{
+                    reports[i] = adapt_fleet_machine(fleet_machs[i], udt_db ? &*udt_db : nullptr, parax_db ? &*parax_db : nullptr, options, notify_issue_mt);
+                   }
+                catch( std::exception& e )
+                   {
+                    notify_issue_mt( std::format("{}: {}", fleet_machs[i].udt_path().string(), e.what()) );
+                   }
+               });
+           }
+        pool.wait();
+       }
+
+    for( const auto& report : reports )
+       {
+        verbose_print("{}", report);
+       }
+}
+
+
+
+//---------------------------------------------------------------------------
+// Update the udt file of a machine folder, returning the report line
+[[nodiscard]] std::string update_fleet_machine( const FleetMachine& fleet_mach,
+                                                const udt::File& new_udt_file,
+                                                const udt::File::RenameIndex& rename_index,
+                                                const MG::options_set& options,
+                                                fnotify_t const& notify_issue )
+{
+    std::string report;
+    std::optional<fs::path> updated_udt;
+       {
+        const udt::File old_udt_file(fleet_mach.udt_path().string(), std::ref(notify_issue));
+        sipro::TxtOverlay overlay; // Just the differences from the shared template
+        new_udt_file.overwrite_values_from(old_udt_file, overlay, &rename_index);
+        updated_udt = write_adapted_temp(new_udt_file, fleet_mach.udt_path(), overlay, options);
+        report = std::format("  {}: modified {} values, {} issues\n", old_udt_file.path(), overlay.modified_values_count(), overlay.mod_issues().size());
+       } // Original file no more mapped in memory
+    replace_file_with(fleet_mach.udt_path(), *updated_udt);
+    return report;
+}
+
+
+//---------------------------------------------------------------------------
+// Update all the MachSettings.udt found in the fleet directory to a
+// newer one. The template and its index for the renames detection
+// are built once and shared read-only by the concurrent merges
+template<typename FPRINT>
+void update_fleet( const std::string& template_file,
+                   const std::string& fleet_dir,
+                   const MG::options_set& options,
+                   FPRINT const& verbose_print,
+                   fnotify_t const& notify_issue )
+{
+    std::vector<FleetMachine> fleet_machs = collect_fleet_machines(fleet_dir);
+    std::erase_if(fleet_machs, [&template_file](const FleetMachine& fleet_mach){ return fleet_mach.udt_path().empty() or fs::equivalent(fleet_mach.udt_path(), template_file); });
+    verbose_print("  Found {} MachSettings.udt in {}\n", fleet_machs.size(), fleet_dir);
+
+    const udt::File new_udt_file(template_file, std::ref(notify_issue));
+    const udt::File::RenameIndex rename_index(new_udt_file);
+    verbose_print("  New udt: {}\n", new_udt_file.info_string());
+
+    const fnotify_t notify_issue_mt = MG::make_thread_safe(notify_issue);
+    std::vector<std::string> reports( fleet_machs.size() );
+       {
+        MG::thread_pool pool;
+        for( std::size_t i=0; i<fleet_machs.size(); ++i )
+           {
+            pool.submit([&, i]
+               {
+                try{
+                    reports[i] = update_fleet_machine(fleet_machs[i], new_udt_file, rename_index, options, notify_issue_mt);
+                   }
+                catch( std::exception& e )
+                   {
+                    notify_issue_mt( std::format("{}: {}", fleet_machs[i].udt_path().string(), e.what()) );
+                   }
+               });
+           }
+        pool.wait();
+       }
+
+    for( const auto& report : reports )
+       {
+        verbose_print("{}", report);
+       }
+}
+
+}//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+#ifdef TEST_UNITS ///////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+static ut::suite<"adapt_fleet"> adapt_fleet_tests = []
+{////////////////////////////////////////////////////////////////////////////
+
+struct issues_t final { int num=0; void operator()(std::string&& msg) noexcept {++num; ut::log << msg << '\n';}; };
+
+ut::test("app::adapt_fleet()") = []
+   {
+    test::TemporaryDirectory tmp_dir;
+
+    const auto create_udt = [&tmp_dir](const std::string_view mach_dir, const std::string_view mach)
+       {
+        fs::create_directories(tmp_dir.path() / mach_dir / "userdata");
+        return tmp_dir.create_file( std::format("{}/userdata/MachSettings.udt", mach_dir),
+                                    std::format("va0 = \"{}\" # Mandatory field 'vaMachName'\n"
+                                                "vn123 = 0 # Should be overwritten 'vnType'\n", mach) );
+       };
+    const auto udt1 = create_udt("m1/sde", "ActiveHP-6.0/4.6"sv);
+    const auto udt2 = create_udt("m2/sde", "ActiveW-4.9/3.2"sv);
+    const auto udt_template = tmp_dir.create_file("MachSettings.udt", "vn123 = 0 # Not in a machine folder 'vnType'\n"sv);
+
+    fs::create_directories(tmp_dir.path() / "m1/sde/param");
+    const auto parax = tmp_dir.create_file("m1/sde/param/par2kax.txt",
+        "[StartEthercatAx]\n"
+        "  Name = \"Xr\"\n"
+        "  InvDir = 0\n"
+        "[EndEthercatAx]\n"sv);
+
+    const auto udt_db = tmp_dir.create_file("udt-overlays.txt",
+        "HP:{\n"
+        "    \"common\": { vnType: 11 }\n"
+        "    \"cut-bridge\" : { \"6.0\": { vnType: 11 } }\n"
+        "    \"algn-span\" : { \"4.6\": { vnType: 11 } }\n"
+        "   }\n"
+        "W:{\n"
+        "    \"common\": { vnType: 10 }\n"
+        "    \"cut-bridge\" : { \"4.9\": { vnType: 10 } }\n"
+        "    \"algn-span\" : { \"3.2\": { vnType: 10 } }\n"
+        "   }\n"sv);
+    const auto parax_db = tmp_dir.create_file("parax-overlays.txt",
+        "HP:{\n"
+        "    common: { Xr: { InvDir = 1 } }\n"
+        "   }\n"sv);
+
+    issues_t issues;
+    app::adapt_fleet( tmp_dir.path().string(), udt_db.path().string(), parax_db.path().string(), {}, [](const std::string_view, const auto&...){}, std::ref(issues) );
+    ut::expect( ut::that % issues.num==0 ) << "no issues expected\n";
+
+    issues_t reparse_issues;
+    check_field(udt::File(udt1.path().string(), std::ref(reparse_issues)), "vn123"sv, "11"sv, "Should be overwritten"sv, "vnType"sv);
+    check_field(udt::File(udt2.path().string(), std::ref(reparse_issues)), "vn123"sv, "10"sv, "Should be overwritten"sv, "vnType"sv);
+    check_field(udt::File(udt_template.path().string(), std::ref(reparse_issues)), "vn123"sv, "0"sv, "Not in a machine folder"sv, "vnType"sv);
+    parax::File adapted_parax(parax.path().string(), std::ref(reparse_issues));
+    check_field(adapted_parax, "Xr"sv, "InvDir"sv, "1"sv);
+    ut::expect( ut::that % reparse_issues.num==0 ) << "no issues expected\n";
+
+    ut::expect( fs::exists(udt1.path().string() + ".bck") ) << "original should be backed up\n";
+   };
+
+
+ut::test("app::update_fleet()") = []
+   {
+    test::TemporaryDirectory tmp_dir;
+
+    const auto create_udt = [&tmp_dir](const std::string_view mach_dir, const std::string_view val)
+       {
+        fs::create_directories(tmp_dir.path() / mach_dir / "userdata");
+        return tmp_dir.create_file( std::format("{}/userdata/MachSettings.udt", mach_dir),
+                                    std::format("va0 = \"ActiveW-4.9/3.2\" # Mandatory field 'vaMachName'\n"
+                                                "vn100 = {} # Comment 'Previous'\n", val) );
+       };
+    const auto udt1 = create_udt("m1/sde", "1"sv);
+    const auto udt2 = create_udt("m2/sde", "2"sv);
+    const auto udt_template = tmp_dir.create_file("MachSettings.udt",
+        "va0 = \"\" # Mandatory field 'vaMachName'\n"
+        "vn100 = 0 # Comment mod 'Renamed'\n"
+        "vn101 = 0 # Added 'New'\n"sv);
+
+    issues_t issues;
+    app::update_fleet( udt_template.path().string(), tmp_dir.path().string(), {}, [](const std::string_view, const auto&...){}, std::ref(issues) );
+    ut::expect( ut::that % issues.num==0 ) << "no issues expected\n";
+
+    issues_t reparse_issues;
+    const udt::File updated1(udt1.path().string(), std::ref(reparse_issues));
+    check_field(updated1, "vn100"sv, "1"sv, "Comment mod"sv, "Renamed"sv);
+    check_field(updated1, "vn101"sv, "0"sv, "Added"sv, "New"sv);
+    check_field(udt::File(udt2.path().string(), std::ref(reparse_issues)), "vn100"sv, "2"sv, "Comment mod"sv, "Renamed"sv);
+    check_field(udt::File(udt_template.path().string(), std::ref(reparse_issues)), "vn100"sv, "0"sv, "Comment mod"sv, "Renamed"sv);
+    ut::expect( ut::that % reparse_issues.num==0 ) << "no issues expected\n";
+    ut::expect( fs::exists(udt2.path().string() + ".bck") ) << "original should be backed up\n";
+   };
+
+};///////////////////////////////////////////////////////////////////////////
+#endif // TEST_UNITS ////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
@@ -9,6 +9,8 @@
 #include <format>
 
 #include "options_set.hpp" // MG::options_set
+#include "parallel_for.hpp" // MG::parallel_for()
+#include "mach_outputs.hpp" // app::MachOutputs
 #include "macotec_parameters_database.hpp" // macotec::ParamsDB
 #include "parax_file_descriptor.hpp" // parax::File
 
@@ -18,60 +20,128 @@ namespace app //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 {
 
 //---------------------------------------------------------------------------
-template<typename FPRINT>
-void adapt_parax( const std::string& target_file,
-                  const std::string& db_file,
-                  const std::string& out_path,
-                  const macotec::MachineData& mach_data,
-                  const MG::options_set& options,
-                  FPRINT const& verbose_print,
-                  fnotify_t const& notify_issue )
+// Collect in the overlay the modifications of an already extracted
+// machine parax DB (db_path is just for the messages)
+void overlay_parax_for( const parax::File& parax_file,
+                        const MG::vectmap<std::string_view, macotec::ParamsGroups>& mach_parax_db,
+                        const std::string_view db_path,
+                        sipro::TxtOverlay& overlay,
+                        fnotify_t const& notify_issue )
 {
-    // [The parax file to adapt]
-    parax::File parax_file(target_file, notify_issue);
-
-    // [Parameters DB]
-    const macotec::ParamsDB db{ db_file, notify_issue };
-    const auto mach_parax_db = db.extract_parax_db_for(mach_data, notify_issue);
-
-    verbose_print( "  parax file: {}\n"
-                   "  DB: {}\n",
-                   parax_file.info_string(),
-                   db.info_string() );
-
     // Overwrite values from database
     for( const auto& [axid, db_axfields] : mach_parax_db )
        {
         if( const auto par_ax_fields = parax_file.get_fields_of_axis(axid) )
            {
-            for( const auto group_ref : db_axfields )
+            for( const auto& group : db_axfields )
                {
-                for( const auto& [nam, db_field] : group_ref.get().childs() )
+                for( const auto& [nam, db_field] : group )
                    {
                     if( not db_field.has_value() )
                        {// All nodes at this level should be value fields
-                        notify_issue( std::format("Axis field {}.{} hasn't a value in {}", axid, nam, db_file) );
+                        notify_issue( std::format("Axis field {}.{} hasn't a value in {}", axid, nam, db_path) );
                        }
-                    else if( const auto par_field = parax_file.get_field_by_varname(*par_ax_fields,nam) )
+                    else if( const auto par_field = parax::File::get_field_by_varname(*par_ax_fields,nam) )
                        {
-                        par_field->modify_value( db_field.value() );
+                        if( not db_field.same_value_as(overlay.value_of(*par_field)) )
+                           {// Skipping the no-op writes (also 4282.0 over 4282)
+                            overlay.modify_value( *par_field, db_field.value() );
+                           }
                        }
                     else
                        {
-                        parax_file.add_mod_issue( std::format("Axis parameter not found: {}={}", nam, db_field.value()) );
+                        overlay.add_mod_issue( std::format("Axis parameter not found: {}={}", nam, db_field.value()) );
                        }
                    }
                }
            }
         else
            {
-            parax_file.add_mod_issue( std::format("Axis not found here: {}", axid) );
+            overlay.add_mod_issue( std::format("Axis not found here: {}", axid) );
            }
        }
+}
+
+
+//---------------------------------------------------------------------------
+// Collect in the overlay the modifications to adapt the parax file to a machine
+void overlay_parax_for( const parax::File& parax_file,
+                        const macotec::ParamsDB& db,
+                        const macotec::MachineData& mach_data,
+                        sipro::TxtOverlay& overlay,
+                        fnotify_t const& notify_issue )
+{
+    overlay_parax_for(parax_file, db.extract_parax_db_for(mach_data, notify_issue), db.path(), overlay, notify_issue);
+}
+
+
+//---------------------------------------------------------------------------
+template<typename FPRINT>
+void adapt_parax( const std::string& target_file,
+                  const std::string& db_file,
+                  const std::string& out_path,
+                  const macotec::MachineData& mach_data,
+                  const MG::options_set& options,
+                  FPRINT const& verbose_print,
+                  fnotify_t const& notify_issue )
+{
+    // [The parax file to adapt]
+    const parax::File parax_file(target_file, notify_issue);
+
+    // [Parameters DB]
+    const macotec::ParamsDB db{ db_file, notify_issue, macotec::ParamsDB::parsing::lazy }; // Just a machine
+
+    verbose_print( "  parax file: {}\n"
+                   "  DB: {}\n",
+                   parax_file.info_string(),
+                   db.info_string() );
+
+    sipro::TxtOverlay overlay;
+    overlay_parax_for(parax_file, db, mach_data, overlay, notify_issue);
+
+    verbose_print("  Modified {} values, {} issues\n", overlay.modified_values_count(), overlay.mod_issues().size());
+
+    parax_file.write_to( out_path, overlay, options, std::format("Machine: {}", mach_data.string()) );
+}
+
+
+//---------------------------------------------------------------------------
+// Adapt a parax file to many machines, target and DB are parsed just once
+// and each output is written concurrently (verbose_print must tolerate it)
+template<typename FPRINT>
+void adapt_parax( const std::string& target_file,
+                  const std::string& db_file,
+                  const MachOutputs& mach_outputs,
+                  const MG::options_set& options,
+                  FPRINT const& verbose_print,
+                  fnotify_t const& notify_issue )
+{
+    // [The parax file to adapt]
+    const parax::File parax_file(target_file, notify_issue);
 
-    verbose_print("  Modified {} values, {} issues\n", parax_file.modified_values_count(), parax_file.mod_issues().size());
+    // [Parameters DB]
+    const macotec::ParamsDB db{ db_file, notify_issue, macotec::ParamsDB::parsing::indexed }; // Many machines
 
-    parax_file.write_to( out_path, options, std::format("Machine: {}", mach_data.string()) );
+    verbose_print( "  parax file: {}\n"
+                   "  DB: {}\n",
+                   parax_file.info_string(),
+                   db.info_string() );
+
+    const fnotify_t notify_issue_mt = MG::make_thread_safe(notify_issue);
+    MG::parallel_for(mach_outputs.size(), [&](const std::size_t idx)
+       {
+        const MachOutput& mach_out = mach_outputs[idx];
+        try{
+            sipro::TxtOverlay overlay;
+            overlay_parax_for(parax_file, db, mach_out.mach_data(), overlay, notify_issue_mt);
+            parax_file.write_to( mach_out.path(), overlay, options, std::format("Machine: {}", mach_out.mach_data().string()) );
+            verbose_print("  {}: modified {} values, {} issues => {}\n", mach_out.mach_data().string(), overlay.modified_values_count(), overlay.mod_issues().size(), mach_out.path());
+           }
+        catch( std::exception& e )
+           {
+            notify_issue_mt( std::format("{}: {}", mach_out.mach_data().string(), e.what()) );
+           }
+       });
 }
 
 }//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
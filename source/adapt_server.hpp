@@ -0,0 +1,421 @@
+﻿#pragma once
+//  ---------------------------------------------
+//  A resident process that serves adapt and
+//  update requests through a unix domain socket,
+//  keeping the parameters databases in memory
+//  ---------------------------------------------
+//  #include "adapt_server.hpp" // app::serve(), app::request_to_server()
+//  ---------------------------------------------
+#include <string>
+#include <string_view>
+#include <vector>
+#include <charconv> // std::from_chars
+#include <stdexcept> // std::runtime_error, std::invalid_argument
+#include <format>
+#include <print>
+#include <filesystem> // std::filesystem
+
+#include "os-detect.hpp" // POSIX
+#include "unix_socket.hpp" // sys::unix_socket
+#include "issues_collector.hpp" // MG::issues
+#include "string_write.hpp" // MG::string_write
+#include "arguments.hpp" // app::Arguments
+#include "params_db_cache.hpp" // app::ParamsDBCache
+#include "adapt_udt_file.hpp" // app::overlay_mach_name(), app::overlay_udt_for()
+#include "adapt_parax_file.hpp" // app::overlay_parax_for()
+#include "handle_output_file.hpp" // app::is_temp()
+
+namespace fs = std::filesystem;
+using namespace std::literals; // "..."sv
+
+
+namespace app //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+inline constexpr std::string_view stop_server_arg = "--stop-server"sv;
+
+//---------------------------------------------------------------------------
+[[nodiscard]] std::vector<std::string_view> split_lines(std::string_view sv)
+{
+    std::vector<std::string_view> lines;
+    while( not sv.empty() )
+       {
+        const std::size_t i = sv.find('\n');
+        lines.push_back( sv.substr(0, i) );
+        sv.remove_prefix( i==std::string_view::npos ? sv.size() : i+1 );
+       }
+    return lines;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// The client working directory in the first line, then the
+// program arguments, one per line
+class ServerRequest final
+{
+ private:
+    std::string m_cwd;
+    std::vector<std::string> m_args;
+
+ public:
+    ServerRequest(std::string&& cwd, std::vector<std::string>&& args) noexcept
+      : m_cwd{std::move(cwd)}
+      , m_args{std::move(args)}
+       {}
+
+    [[nodiscard]] static ServerRequest parse(const std::string_view sv)
+       {
+        const std::vector<std::string_view> lines = split_lines(sv);
+        if( lines.empty() )
+           {
+            throw std::runtime_error("Empty request");
+           }
+        return ServerRequest{ std::string{lines.front()}, std::vector<std::string>(lines.begin()+1, lines.end()) };
+       }
+
+    [[nodiscard]] const std::string& cwd() const noexcept { return m_cwd; }
+    [[nodiscard]] const std::vector<std::string>& args() const noexcept { return m_args; }
+    [[nodiscard]] bool is_stop() const noexcept { return m_args.size()==1 and m_args.front()==stop_server_arg; }
+
+    [[nodiscard]] std::string string() const
+       {
+        std::string s{ m_cwd };
+        for( const auto& arg : m_args )
+           {
+            s += '\n';
+            s += arg;
+           }
+        return s;
+       }
+};
+
+
+/////////////////////////////////////////////////////////////////////////////
+// The exit code in the first line, then the messages, an empty line
+// and finally the output path or the adapted content
+class ServerResponse final
+{
+ private:
+    int m_exit_code = 0;
+    std::vector<std::string> m_messages;
+    std::string m_output;
+
+ public:
+    [[nodiscard]] static ServerResponse parse(std::string_view sv)
+       {
+        ServerResponse resp;
+        const auto next_line = [&sv]() -> std::string_view
+           {
+            const std::size_t i = sv.find('\n');
+            if( i==std::string_view::npos )
+               {
+                throw std::runtime_error("Truncated server response");
+               }
+            const std::string_view line = sv.substr(0, i);
+            sv.remove_prefix(i+1);
+            return line;
+           };
+        const std::string_view code = next_line();
+        if( std::from_chars(code.data(), code.data()+code.size(), resp.m_exit_code).ec!=std::errc{} )
+           {
+            throw std::runtime_error( std::format("Invalid server response: {}", code) );
+           }
+        while( true )
+           {
+            const std::string_view line = next_line();
+            if( line.empty() ) break;
+            resp.m_messages.emplace_back(line);
+           }
+        resp.m_output = sv;
+        return resp;
+       }
+
+    [[nodiscard]] int exit_code() const noexcept { return m_exit_code; }
+    void set_exit_code(const int code) noexcept { m_exit_code = code; }
+
+    [[nodiscard]] const std::vector<std::string>& messages() const noexcept { return m_messages; }
+    void add_message(std::string&& msg) { m_messages.push_back( std::move(msg) ); }
+
+    [[nodiscard]] const std::string& output() const noexcept { return m_output; }
+    void set_output(std::string&& out) noexcept { m_output = std::move(out); }
+
+    [[nodiscard]] std::string string() const
+       {
+        std::string s{ std::format("{}\n", m_exit_code) };
+        for( const auto& msg : m_messages )
+           {
+            for( const char ch : msg ) s += ch=='\n' ? ' ' : ch; // Keep one line each
+            s += '\n';
+           }
+        s += '\n';
+        s += m_output;
+        return s;
+       }
+};
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Serves the requests one at a time: the working directory of
+// the process is temporarily switched to the client's one
+class AdaptServer final
+{
+ private:
+    ParamsDBCache m_db_cache;
+
+    class current_path_guard final
+       {
+        private:
+            fs::path m_prev_path;
+        public:
+            explicit current_path_guard(const fs::path& pth)
+              : m_prev_path{ fs::current_path() }
+               {
+                fs::current_path(pth);
+               }
+            ~current_path_guard() noexcept
+               {
+                std::error_code ec;
+                fs::current_path(m_prev_path, ec);
+               }
+            current_path_guard(const current_path_guard&) = delete;
+            current_path_guard& operator=(const current_path_guard&) = delete;
+       };
+
+ public:
+    [[nodiscard]] const ParamsDBCache& db_cache() const noexcept { return m_db_cache; }
+
+    //-----------------------------------------------------------------------
+    [[nodiscard]] ServerResponse respond_to(const ServerRequest& request)
+       {
+        ServerResponse resp;
+        try{
+            const current_path_guard cwd_guard{ request.cwd() };
+
+            std::vector<const char*> argv{ app::name.data() };
+            for( const auto& arg : request.args() )
+               {
+                argv.push_back( arg.c_str() );
+               }
+            Arguments args;
+            args.parse(static_cast<int>(argv.size()), argv.data());
+
+            MG::issues issues;
+            resp.set_output( run(args, std::ref(issues)) );
+            for( const auto& issue : issues )
+               {
+                resp.add_message( std::format("! {}", issue) );
+               }
+            resp.set_exit_code( issues.size()>0 ? 1 : 0 );
+           }
+        catch( parse::error& e )
+           {
+            resp.add_message( std::format("!! [{}:{}] {}", e.file(), e.line(), e.what()) );
+            resp.set_exit_code(2);
+           }
+        catch( std::exception& e )
+           {
+            resp.add_message( std::format("!! {}", e.what()) );
+            resp.set_exit_code(2);
+           }
+        return resp;
+       }
+
+ private:
+    //-----------------------------------------------------------------------
+    // Returns the output path, or the content when not explicitly given
+    [[nodiscard]] std::string run(const Arguments& args, fnotify_t const& notify_issue)
+       {
+        const JobUnit& job = args.job();
+        if( job.is_update_udt() )
+           {
+            const udt::File new_udt_file(job.target_file().path().string(), notify_issue);
+            const udt::File old_udt_file(job.db_file().path().string(), notify_issue);
+            sipro::TxtOverlay overlay;
+            new_udt_file.overwrite_values_from( old_udt_file, overlay );
+            return write_output(new_udt_file, overlay, args.options(), job.out_path());
+           }
+        else if( job.is_adapt_udt() and not job.is_multi_mach() )
+           {
+            const udt::File udt_file(job.target_file().path().string(), notify_issue);
+            CachedParamsDB& db = m_db_cache.get(job.db_file().path(), notify_issue);
+            sipro::TxtOverlay overlay;
+            const macotec::MachineData mach_data = overlay_mach_name(udt_file, job.mach_data(), overlay, notify_issue);
+            overlay_udt_for(udt_file, db.udt_db_for(mach_data, notify_issue), db.path(), overlay, notify_issue);
+            return write_output(udt_file, overlay, args.options(), job.out_path());
+           }
+        else if( job.is_adapt_parax() and not job.is_multi_mach() )
+           {
+            const parax::File parax_file(job.target_file().path().string(), notify_issue);
+            CachedParamsDB& db = m_db_cache.get(job.db_file().path(), notify_issue);
+            sipro::TxtOverlay overlay;
+            overlay_parax_for(parax_file, db.parax_db_for(job.mach_data(), notify_issue), db.path(), overlay, notify_issue);
+            return write_output(parax_file, overlay, args.options(), job.out_path(), std::format("Machine: {}", job.mach_data().string()));
+           }
+        throw std::invalid_argument("Only single adapt or update requests are served");
+       }
+
+    //-----------------------------------------------------------------------
+    [[nodiscard]] static std::string write_output(const sipro::TxtFile& file, const sipro::TxtOverlay& overlay, const MG::options_set& options, const fs::path& out_path, const std::string_view add_info ={})
+       {
+        if( is_temp(out_path) )
+           {// Output not given, respond with the content
+            MG::string_write out;
+            file.write_to(out, overlay, options, add_info);
+            return out.str();
+           }
+        file.write_to(out_path.string(), overlay, options, add_info);
+        return fs::absolute(out_path).string();
+       }
+};
+
+
+//---------------------------------------------------------------------------
+// Serve the requests until a stop one
+template<typename FPRINT>
+void serve(const std::string& socket_path, FPRINT const& verbose_print)
+{
+  #if defined(POSIX)
+    const sys::unix_socket listener = sys::unix_socket::listen_on(socket_path);
+    verbose_print("  Listening on {}\n", socket_path);
+
+    AdaptServer server;
+    bool stop = false;
+    while( not stop )
+       {
+        try{
+            const sys::unix_socket conn = listener.accept();
+            const ServerRequest request = ServerRequest::parse( conn.receive_all() );
+            ServerResponse resp;
+            if( request.is_stop() )
+               {
+                stop = true;
+                resp.set_output("Server stopped\n");
+               }
+            else
+               {
+                resp = server.respond_to(request);
+               }
+            conn.send_all( resp.string() );
+            verbose_print("  Served request ({} args) with exit code {}, {} DBs loaded {} times\n", request.args().size(), resp.exit_code(), server.db_cache().size(), server.db_cache().loads_count());
+           }
+        catch( std::exception& e )
+           {// Don't let a single client bring down the server
+            verbose_print("  Request failed: {}\n", e.what());
+           }
+       }
+
+    std::error_code ec;
+    fs::remove(socket_path, ec);
+  #else
+    throw std::runtime_error( std::format("Server mode needs unix domain sockets, unavailable here ({})", socket_path) );
+  #endif
+}
+
+
+//---------------------------------------------------------------------------
+// Forward the arguments to a running server and print its response
+[[nodiscard]] int request_to_server(const std::string& socket_path, std::vector<std::string> args)
+{
+  #if defined(POSIX)
+    const sys::unix_socket conn = sys::unix_socket::connect_to(socket_path);
+    conn.send_all( ServerRequest{fs::current_path().string(), std::move(args)}.string() );
+    conn.shutdown_send();
+    const ServerResponse resp = ServerResponse::parse( conn.receive_all() );
+    for( const auto& msg : resp.messages() )
+       {
+        std::print("{}\n", msg);
+       }
+    std::print("{}", resp.output());
+    return resp.exit_code();
+  #else
+    throw std::runtime_error( std::format("Server mode needs unix domain sockets, unavailable here ({})", socket_path) );
+  #endif
+}
+
+}//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+#ifdef TEST_UNITS ///////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+#include <thread> // std::jthread
+#include <atomic>
+/////////////////////////////////////////////////////////////////////////////
+static ut::suite<"adapt_server"> adapt_server_tests = []
+{////////////////////////////////////////////////////////////////////////////
+
+ut::test("app::ServerResponse") = []
+   {
+    app::ServerResponse resp;
+    resp.set_exit_code(1);
+    resp.add_message("! first\nissue");
+    resp.add_message("! second");
+    resp.set_output("line1\n\nline3\n");
+
+    const app::ServerResponse parsed = app::ServerResponse::parse( resp.string() );
+    ut::expect( ut::that % parsed.exit_code()==1 );
+    ut::expect( ut::fatal(ut::that % parsed.messages().size()==2u) );
+    ut::expect( ut::that % parsed.messages()[0]=="! first issue"sv );
+    ut::expect( ut::that % parsed.output()=="line1\n\nline3\n"sv );
+   };
+
+ut::test("app::AdaptServer") = []
+   {
+    test::TemporaryDirectory tmp_dir;
+    const auto udt = tmp_dir.create_file("MachSettings.udt",
+        "va0 = \"ActiveHP-6.0/4.6\" # Mandatory field 'vaMachName'\n"
+        "vn123 = 0 # Should be overwritten 'vnType'\n"sv);
+    const auto db = tmp_dir.create_file("udt-overlays.txt",
+        "HP:{\n"
+        "    \"common\": { vnType: 11 }\n"
+        "   }\n"sv);
+    const auto out = tmp_dir.decl_file("out.udt");
+    const std::string cwd{ tmp_dir.path().string() };
+
+    app::AdaptServer server;
+    app::ServerResponse resp = server.respond_to( app::ServerRequest{std::string{cwd}, {"--tgt", "MachSettings.udt", "--db", "udt-overlays.txt", "--mach", "ActiveHP-6.0/4.6"}} );
+    ut::expect( ut::that % resp.exit_code()==0 );
+    ut::expect( resp.output().contains("vn123 = 11 # Should be overwritten 'vnType'"sv) ) << "should respond with adapted content\n";
+
+    resp = server.respond_to( app::ServerRequest{std::string{cwd}, {"--tgt", "MachSettings.udt", "--db", "udt-overlays.txt", "--mach", "ActiveHP-6.0/4.6", "--out", "out.udt"}} );
+    ut::expect( ut::that % resp.exit_code()==0 );
+    ut::expect( ut::that % resp.output()==out.path().string() ) << "should respond with output path\n";
+    ut::expect( out.exists() );
+    ut::expect( ut::that % server.db_cache().loads_count()==1u ) << "DB should be parsed once\n";
+
+    resp = server.respond_to( app::ServerRequest{std::string{cwd}, {"--tgt", "not-existing.udt"}} );
+    ut::expect( ut::that % resp.exit_code()==2 );
+    ut::expect( ut::that % resp.messages().size()==1u );
+   };
+
+#if defined(POSIX)
+ut::test("app::serve()") = []
+   {
+    test::TemporaryDirectory tmp_dir;
+    const auto udt = tmp_dir.create_file("MachSettings.udt",
+        "va0 = \"ActiveHP-6.0/4.6\" # Mandatory field 'vaMachName'\n"
+        "vn123 = 0 # Should be overwritten 'vnType'\n"sv);
+    const auto db = tmp_dir.create_file("udt-overlays.txt",
+        "HP:{\n"
+        "    \"common\": { vnType: 11 }\n"
+        "   }\n"sv);
+    const auto out = tmp_dir.decl_file("out.udt");
+    const std::string sock_path = (tmp_dir.path() / "server.sock").string();
+
+    std::atomic<bool> listening{false};
+    std::jthread server([&sock_path, &listening]{ app::serve(sock_path, [&listening](const std::string_view, const auto&...){ listening = true; }); });
+    while( not listening ) std::this_thread::yield(); // First print after listen
+
+    const int ret = app::request_to_server(sock_path, {"--tgt", udt.path().string(), "--db", db.path().string(), "--mach", "ActiveHP-6.0/4.6", "--out", out.path().string()});
+    ut::expect( ut::that % ret==0 );
+    ut::expect( out.content().contains("vn123 = 11 # Should be overwritten 'vnType'"sv) );
+
+    ut::expect( ut::that % app::request_to_server(sock_path, {std::string{app::stop_server_arg}})==0 );
+   };
+#endif
+
+};///////////////////////////////////////////////////////////////////////////
+#endif // TEST_UNITS ////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
@@ -11,6 +11,8 @@
 
 #include "string_utilities.hpp" // str::unquoted, str::quoted
 #include "options_set.hpp" // MG::options_set
+#include "parallel_for.hpp" // MG::parallel_for()
+#include "mach_outputs.hpp" // app::MachOutputs
 #include "macotec_parameters_database.hpp" // macotec::ParamsDB
 #include "udt_file_descriptor.hpp" // udt::File
 
@@ -22,41 +24,92 @@ inline constexpr std::string_view machname_field_label = "vaMachName"sv;
 
 
 //---------------------------------------------------------------------------
-template<typename FPRINT>
-void adapt_udt( const std::string& target_file,
-                const std::string& db_file,
-                const std::string& out_path,
-                macotec::MachineData mach_data,
-                const MG::options_set& options,
-                FPRINT const& verbose_print,
-                fnotify_t const& notify_issue )
+// Ensure that a machine type can be superimposed to the udt file
+void check_mach_name_field_of(const udt::File& udt_file, fnotify_t const& notify_issue)
 {
-    // [The UDT file to adapt]
-    udt::File udt_file(target_file, std::ref(notify_issue));
+    if( const auto vaMachName = udt_file.get_field_by_label(machname_field_label) )
+       {
+        // Better check if the target file has already superimposed options
+        macotec::MachineData udt_mach_data;
+        try{
+            udt_mach_data.assign( str::unquoted(vaMachName->value()) );
+           }
+        catch( std::exception& e )
+           {
+            notify_issue( std::format("{} has an invalid vaMachName `{}`: {}", udt_file.path(), vaMachName->value(), e.what()) );
+           }
+        if( not udt_mach_data.options().is_empty() )
+           {
+            throw std::runtime_error( std::format("{} has already options: {}", udt_file.path(), udt_mach_data.options().string()) );
+           }
+       }
+    else
+       {
+        notify_issue( std::format("{} hasn't field vaMachName", udt_file.path()) );
+       }
+}
 
-    if( mach_data )
-       {// I have the machine data
-        if( const auto vaMachName = udt_file.get_field_by_label(machname_field_label) )
+
+//---------------------------------------------------------------------------
+// Collect in the overlay the modifications of an already extracted
+// machine udt DB (db_path is just for the messages)
+void overlay_udt_for( const udt::File& udt_file,
+                      const macotec::ParamsGroups& mach_udt_db,
+                      const std::string_view db_path,
+                      sipro::TxtOverlay& overlay,
+                      fnotify_t const& notify_issue )
+{
+    // Overwrite values from database
+    for( const auto& group : mach_udt_db )
+       {
+        for( const auto& [nam, db_field] : group )
            {
-            // Better check if the target file has already superimposed options
-            macotec::MachineData udt_mach_data;
-            try{
-                udt_mach_data.assign( str::unquoted(vaMachName->value()) );
+            if( not db_field.has_value() )
+               {// All nodes at this level should be value fields
+                notify_issue( std::format("Node {} hasn't a value in {}", nam, db_path) );
                }
-            catch( std::exception& e )
+            else if( const auto udt_field = udt_file.get_field_by_label(nam) )
                {
-                notify_issue( std::format("{} has an invalid vaMachName `{}`: {}", target_file, vaMachName->value(), e.what()) );
+                if( not db_field.same_value_as(overlay.value_of(*udt_field)) )
+                   {// Skipping the no-op writes (also 4282.0 over 4282)
+                    overlay.modify_value( *udt_field, db_field.value() );
+                   }
                }
-            if( not udt_mach_data.options().is_empty() )
+            else
                {
-                throw std::runtime_error( std::format("{} has already options: {}", target_file, udt_mach_data.options().string()) );
+                overlay.add_mod_issue( std::format("Not found: {}={}", nam, db_field.value()) );
                }
-            // Overwrite the specified machine type in the file
-            vaMachName->modify_value( str::quoted(mach_data.string()) );
            }
-        else
-           {
-            notify_issue( std::format("{} hasn't field vaMachName", target_file) );
+       }
+}
+
+
+//---------------------------------------------------------------------------
+// Collect in the overlay the modifications to adapt the udt file to a machine
+void overlay_udt_for( const udt::File& udt_file,
+                      const macotec::ParamsDB& db,
+                      const macotec::MachineData& mach_data,
+                      sipro::TxtOverlay& overlay,
+                      fnotify_t const& notify_issue )
+{
+    overlay_udt_for(udt_file, db.extract_udt_db_for(mach_data, notify_issue), db.path(), overlay, notify_issue);
+}
+
+
+//---------------------------------------------------------------------------
+// Superimpose the given machine type to the udt file, when not given
+// returns the one declared in the file
+[[nodiscard]] macotec::MachineData overlay_mach_name( const udt::File& udt_file,
+                                                      macotec::MachineData mach_data,
+                                                      sipro::TxtOverlay& overlay,
+                                                      fnotify_t const& notify_issue )
+{
+    if( mach_data )
+       {// I have the machine data
+        check_mach_name_field_of(udt_file, notify_issue);
+        if( const auto vaMachName = udt_file.get_field_by_label(machname_field_label) )
+           {// Overwrite the specified machine type in the file
+            overlay.modify_value( *vaMachName, str::quoted(mach_data.string()) );
            }
        }
     else
@@ -67,42 +120,99 @@ void adapt_udt( const std::string& target_file,
            }
         else
            {
-            throw std::runtime_error( std::format("Can't infer machine from: {}", target_file) );
+            throw std::runtime_error( std::format("Can't infer machine from: {}", udt_file.path()) );
            }
        }
+    return mach_data;
+}
+
+
+//---------------------------------------------------------------------------
+// Collect in the overlay the modifications to adapt the udt file to a
+// machine, when not given is the machine type declared in the file
+void overlay_adapted_udt( const udt::File& udt_file,
+                          const macotec::ParamsDB& db,
+                          const macotec::MachineData& mach_data,
+                          sipro::TxtOverlay& overlay,
+                          fnotify_t const& notify_issue )
+{
+    overlay_udt_for(udt_file, db, overlay_mach_name(udt_file, mach_data, overlay, notify_issue), overlay, notify_issue);
+}
+
+
+//---------------------------------------------------------------------------
+template<typename FPRINT>
+void adapt_udt( const std::string& target_file,
+                const std::string& db_file,
+                const std::string& out_path,
+                const macotec::MachineData& mach_data,
+                const MG::options_set& options,
+                FPRINT const& verbose_print,
+                fnotify_t const& notify_issue )
+{
+    // [The UDT file to adapt]
+    const udt::File udt_file(target_file, std::ref(notify_issue));
 
     // [Parameters DB]
-    const macotec::ParamsDB db{ db_file, notify_issue };
-    const auto mach_udt_db = db.extract_udt_db_for(mach_data, notify_issue);
+    const macotec::ParamsDB db{ db_file, notify_issue, macotec::ParamsDB::parsing::lazy }; // Just a machine
 
     verbose_print("  udt file: {}\n"
                   "  DB: {}\n",
                   udt_file.info_string(),
                   db.info_string());
 
-    // Overwrite values from database
-    for( const auto group_ref : mach_udt_db )
+    sipro::TxtOverlay overlay;
+    overlay_adapted_udt(udt_file, db, mach_data, overlay, notify_issue);
+
+    verbose_print("  Modified {} values, {} issues\n", overlay.modified_values_count(), overlay.mod_issues().size());
+
+    udt_file.write_to( out_path, overlay, options );
+}
+
+
+//---------------------------------------------------------------------------
+// Adapt an udt file to many machines, target and DB are parsed just once
+// and each output is written concurrently (verbose_print must tolerate it)
+template<typename FPRINT>
+void adapt_udt( const std::string& target_file,
+                const std::string& db_file,
+                const MachOutputs& mach_outputs,
+                const MG::options_set& options,
+                FPRINT const& verbose_print,
+                fnotify_t const& notify_issue )
+{
+    // [The UDT file to adapt]
+    const udt::File udt_file(target_file, std::ref(notify_issue));
+    check_mach_name_field_of(udt_file, notify_issue);
+    const auto vaMachName = udt_file.get_field_by_label(machname_field_label);
+
+    // [Parameters DB]
+    const macotec::ParamsDB db{ db_file, notify_issue, macotec::ParamsDB::parsing::indexed }; // Many machines
+
+    verbose_print("  udt file: {}\n"
+                  "  DB: {}\n",
+                  udt_file.info_string(),
+                  db.info_string());
+
+    const fnotify_t notify_issue_mt = MG::make_thread_safe(notify_issue);
+    MG::parallel_for(mach_outputs.size(), [&](const std::size_t idx)
        {
-        for( const auto& [nam, db_field] : group_ref.get().childs() )
-           {
-            if( not db_field.has_value() )
-               {// All nodes at this level should be value fields
-                notify_issue( std::format("Node {} hasn't a value in {}", nam, db_file) );
-               }
-            else if( const auto udt_field = udt_file.get_field_by_label(nam) )
+        const MachOutput& mach_out = mach_outputs[idx];
+        try{
+            sipro::TxtOverlay overlay;
+            if( vaMachName )
                {
-                udt_field->modify_value( db_field.value() );
-               }
-            else
-               {
-                udt_file.add_mod_issue( std::format("Not found: {}={}", nam, db_field.value()) );
+                overlay.modify_value( *vaMachName, str::quoted(mach_out.mach_data().string()) );
                }
+            overlay_udt_for(udt_file, db, mach_out.mach_data(), overlay, notify_issue_mt);
+            udt_file.write_to( mach_out.path(), overlay, options );
+            verbose_print("  {}: modified {} values, {} issues => {}\n", mach_out.mach_data().string(), overlay.modified_values_count(), overlay.mod_issues().size(), mach_out.path());
            }
-       }
-
-    verbose_print("  Modified {} values, {} issues\n", udt_file.modified_values_count(), udt_file.mod_issues().size());
-
-    udt_file.write_to( out_path, options );
+        catch( std::exception& e )
+           {
+            notify_issue_mt( std::format("{}: {}", mach_out.mach_data().string(), e.what()) );
+           }
+       });
 }
 
 
@@ -138,7 +248,7 @@ bool update_udt( const std::string& template_file,
     // The machine type shouldn't be explicitly given
 
     // [The template UDT file (newest)]
-    udt::File new_udt_file(template_file, notify_issue);
+    const udt::File new_udt_file(template_file, notify_issue);
 
     // [The original UDT file to upgrade (oldest)]
     const udt::File old_udt_file(old_file, notify_issue);
@@ -151,12 +261,15 @@ bool update_udt( const std::string& template_file,
                   old_udt_file.info_string(),
                   new_udt_file.info_string());
 
-    // Overwrite values in newest file using the old as database
-    new_udt_file.overwrite_values_from( old_udt_file );
+    // Overwrite values in newest file using the old as database,
+    // the index spares a scan of the template for each missing field
+    const udt::File::RenameIndex rename_index(new_udt_file);
+    sipro::TxtOverlay overlay;
+    new_udt_file.overwrite_values_from( old_udt_file, overlay, &rename_index );
 
-    verbose_print("  Modified {} values, {} issues\n", new_udt_file.modified_values_count(), new_udt_file.mod_issues().size());
+    verbose_print("  Modified {} values, {} issues\n", overlay.modified_values_count(), overlay.mod_issues().size());
 
-    new_udt_file.write_to( out_path, options );
+    new_udt_file.write_to( out_path, overlay, options );
 
     return same_mach;
 }
@@ -327,6 +440,60 @@ ut::test("app::adapt_udt()") = []
     check_field(adapted_udt, "vq2501"sv, "hp-4.6"sv, "Should be overwritten"sv, "vqAlgn"sv);
    };
 
+
+ut::test("app::adapt_udt() for multiple machines") = []
+   {
+    test::TemporaryDirectory tmp_dir;
+
+    const auto udt = tmp_dir.create_file("test.udt",
+        "va0 = \"W\" # Mandatory field 'vaMachName'\n"
+        "vn123 = 0 # Should be overwritten 'vnType'\n"
+        "vq1000 = 0 # Should be overwritten 'vqOpt'\n"
+        "vq2500 = none # Should be overwritten 'vqCut'\n"
+        "vq2501 = none # Should be overwritten 'vqAlgn'\n"sv);
+
+    const auto db = tmp_dir.create_file("overlays.txt",
+        "W,HP: {\n"
+        "    \"+fast\": { vqOpt: 2 }\n"
+        "   }\n"
+        "HP:{\n"
+        "    \"common\": { vnType: 11 }\n"
+        "    \"cut-bridge\" : { \"6.0\": { vqCut: hp-6.0 } }\n"
+        "    \"algn-span\" : { \"4.6\": { vqAlgn: hp-4.6 } }\n"
+        "   }\n"
+        "W:{\n"
+        "    \"common\": { vnType: 10 }\n"
+        "    \"cut-bridge\" : { \"4.9\": { vqCut: w-4.9 } }\n"
+        "    \"algn-span\" : { \"3.2\": { vqAlgn: w-3.2 } }\n"
+        "   }\n"sv);
+
+    const auto out_hp = tmp_dir.decl_file("out-hp.udt");
+    const auto out_w = tmp_dir.decl_file("out-w.udt");
+    const app::MachOutputs mach_outputs = { app::MachOutput{macotec::MachineData{"HP/6.0/4.6/(fast)"sv}, out_hp.path().string()},
+                                            app::MachOutput{macotec::MachineData{"W/4.9/3.2"sv}, out_w.path().string()} };
+
+    issues_t adapt_issues;
+    app::adapt_udt( udt.path().string(), db.path().string(), mach_outputs, {}, [](const std::string_view, const auto&...){}, std::ref(adapt_issues) );
+    ut::expect( ut::that % adapt_issues.num==0 ) << "no issues expected\n";
+    ut::expect( ut::fatal(fs::exists(out_hp.path()) and fs::exists(out_w.path())) );
+
+    issues_t reparse_issues;
+    const udt::File adapted_hp(out_hp.path().string(), std::ref(reparse_issues));
+    check_field(adapted_hp, "va0"sv, "\"ActiveHP-6.0/4.6-(fast)\""sv, "Mandatory field"sv, "vaMachName"sv);
+    check_field(adapted_hp, "vn123"sv, "11"sv, "Should be overwritten"sv, "vnType"sv);
+    check_field(adapted_hp, "vq1000"sv, "2"sv, "Should be overwritten"sv, "vqOpt"sv);
+    check_field(adapted_hp, "vq2500"sv, "hp-6.0"sv, "Should be overwritten"sv, "vqCut"sv);
+    check_field(adapted_hp, "vq2501"sv, "hp-4.6"sv, "Should be overwritten"sv, "vqAlgn"sv);
+
+    const udt::File adapted_w(out_w.path().string(), std::ref(reparse_issues));
+    check_field(adapted_w, "va0"sv, "\"ActiveW-4.9/3.2\""sv, "Mandatory field"sv, "vaMachName"sv);
+    check_field(adapted_w, "vn123"sv, "10"sv, "Should be overwritten"sv, "vnType"sv);
+    check_field(adapted_w, "vq1000"sv, "0"sv, "Should be overwritten"sv, "vqOpt"sv);
+    check_field(adapted_w, "vq2500"sv, "w-4.9"sv, "Should be overwritten"sv, "vqCut"sv);
+    check_field(adapted_w, "vq2501"sv, "w-3.2"sv, "Should be overwritten"sv, "vqAlgn"sv);
+    ut::expect( ut::that % reparse_issues.num==0 ) << "no issues expected\n";
+   };
+
 };///////////////////////////////////////////////////////////////////////////
 #endif // TEST_UNITS ////////////////////////////////////////////////////////
 /////////////////////////////////////////////////////////////////////////////
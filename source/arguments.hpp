@@ -4,7 +4,10 @@
 //  ---------------------------------------------
 //  #include "arguments.hpp" // app::Arguments
 //  ---------------------------------------------
+#include <string>
 #include <string_view>
+#include <vector>
+#include <ranges> // std::views::split
 #include <filesystem> // std::filesystem
 #include <format>
 #include <print>
@@ -26,17 +29,38 @@ namespace app //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 class Arguments final
 {
  private:
-    JobUnit m_job;
+    std::vector<JobUnit> m_jobs{1}; // More when given more target/db pairs
     MG::options_set m_options;
     std::string m_outpath;
+    std::string m_jobs_manifest;
+    std::string m_overlays_cache; // Directory of the resolved udt overlays
+    std::string m_compile_db; // Json DB to be compiled
+    std::vector<std::string> m_query_fields; // Effective values to tell
+    std::string m_server_socket;
+    std::string m_client_socket;
+    std::vector<std::string> m_client_args; // Forwarded to the server
+    bool m_watch = false; // Adapt again when inputs change
+    bool m_db_coverage = false; // Report the fields set by the DB
     bool m_verbose = false; // More info to stdout
     bool m_quiet = false; // No user interaction
 
  public:
-    [[nodiscard]] const auto& job() const noexcept { return m_job; }
+    [[nodiscard]] const auto& job() const noexcept { return m_jobs.front(); }
+    [[nodiscard]] const auto& jobs() const noexcept { return m_jobs; }
+    [[nodiscard]] bool is_multi_job() const noexcept { return m_jobs.size()>1; }
     [[nodiscard]] const auto& options() const noexcept { return m_options; }
+    [[nodiscard]] const auto& jobs_manifest() const noexcept { return m_jobs_manifest; }
+    [[nodiscard]] const auto& overlays_cache() const noexcept { return m_overlays_cache; }
+    [[nodiscard]] const auto& compile_db() const noexcept { return m_compile_db; }
+    [[nodiscard]] const auto& compiled_db_path() const noexcept { return m_outpath; }
+    [[nodiscard]] const auto& query_fields() const noexcept { return m_query_fields; }
+    [[nodiscard]] const auto& server_socket() const noexcept { return m_server_socket; }
+    [[nodiscard]] const auto& client_socket() const noexcept { return m_client_socket; }
+    [[nodiscard]] const auto& client_args() const noexcept { return m_client_args; }
+    [[nodiscard]] bool watch() const noexcept { return m_watch; }
+    [[nodiscard]] bool db_coverage() const noexcept { return m_db_coverage; }
     [[nodiscard]] bool verbose() const noexcept { return m_verbose; }
-    [[nodiscard]] bool quiet() const noexcept { return m_quiet; }
+    [[nodiscard]] bool quiet() const noexcept { return m_quiet or job().is_filter(); } // No interaction in a pipeline
 
  public:
     //-----------------------------------------------------------------------
@@ -61,31 +85,105 @@ class Arguments final
                         m_outpath = str;
                        }
                     else if( arg=="--target"sv or arg=="--tgt"sv or arg=="-tgt"sv )
-                       {
+                       {// Can be repeated, the n-th target pairs with the n-th db
+                        const std::string_view str = args.get_next_value_of(arg);
+                        job_lacking([](const JobUnit& job){ return static_cast<bool>(job.target_file()); }).set_target_file(str);
+                       }
+                    else if( arg=="--stdin"sv or arg=="-stdin"sv )
+                       {// The name tells the type of the target read from stdin
                         const std::string_view str = args.get_next_value_of(arg);
-                        if( m_job.target_file() )
+                        if( job().target_file() )
                            {
-                            throw std::invalid_argument( std::format("Target file was already set to {}", m_job.target_file().path().string()) );
+                            throw std::invalid_argument( std::format("Target file was already set to {}", job().target_file().path().string()) );
                            }
-                        m_job.set_target_file(str);
+                        m_jobs.front().set_target_stdin(str);
                        }
                     else if( arg=="--db"sv or arg=="-db"sv )
                        {
                         const std::string_view str = args.get_next_value_of(arg);
-                        if( m_job.db_file() )
+                        job_lacking([](const JobUnit& job){ return static_cast<bool>(job.db_file()); }).set_db_file(str);
+                       }
+                    else if( arg=="--parax-db"sv or arg=="-parax-db"sv )
+                       {
+                        const std::string_view str = args.get_next_value_of(arg);
+                        if( job().parax_db_file() )
                            {
-                            throw std::invalid_argument( std::format("DB file was already set to {}", m_job.db_file().path().string()) );
+                            throw std::invalid_argument( std::format("par2kax DB file was already set to {}", job().parax_db_file().path().string()) );
                            }
-                        m_job.set_db_file(str);
+                        m_jobs.front().set_parax_db_file(str);
                        }
-                    else if( arg=="--machine"sv or arg=="--mach"sv or arg=="-m"sv or arg=="-mach"sv )
+                    else if( arg=="--jobs"sv or arg=="-jobs"sv )
+                       {
+                        const std::string_view str = args.get_next_value_of(arg);
+                        if( not m_jobs_manifest.empty() )
+                           {
+                            throw std::invalid_argument( std::format("Jobs manifest was already set to {}", m_jobs_manifest) );
+                           }
+                        if( not fs::exists(str) )
+                           {
+                            throw std::invalid_argument( std::format("Jobs manifest not found: {}", str) );
+                           }
+                        m_jobs_manifest = str;
+                       }
+                    else if( arg=="--overlays-cache"sv or arg=="-overlays-cache"sv )
+                       {
+                        const std::string_view str = args.get_next_value_of(arg);
+                        if( not m_overlays_cache.empty() )
+                           {
+                            throw std::invalid_argument( std::format("Overlays cache was already set to {}", m_overlays_cache) );
+                           }
+                        m_overlays_cache = str;
+                       }
+                    else if( arg=="--compile-db"sv or arg=="-compile-db"sv )
+                       {
+                        const std::string_view str = args.get_next_value_of(arg);
+                        if( not m_compile_db.empty() )
+                           {
+                            throw std::invalid_argument( std::format("DB to compile was already set to {}", m_compile_db) );
+                           }
+                        m_compile_db = str;
+                       }
+                    else if( arg=="--query"sv or arg=="-query"sv )
+                       {// Comma separated, can be repeated
+                        for( const auto field_name : std::views::split(args.get_next_value_of(arg), ',') )
+                           {
+                            if( not field_name.empty() ) m_query_fields.emplace_back( std::string_view{field_name} );
+                           }
+                       }
+                    else if( arg=="--fleet"sv or arg=="-fleet"sv )
                        {
                         const std::string_view str = args.get_next_value_of(arg);
-                        if( m_job.mach_data() )
+                        if( not job().fleet_dir().empty() )
                            {
-                            throw std::invalid_argument( std::format("Machine type was already set to {}", m_job.mach_data().string()) );
+                            throw std::invalid_argument( std::format("Fleet directory was already set to {}", job().fleet_dir().string()) );
                            }
-                        m_job.set_mach_data(str);
+                        m_jobs.front().set_fleet_dir(str);
+                       }
+                    else if( arg=="--server"sv or arg=="-server"sv )
+                       {
+                        const std::string_view str = args.get_next_value_of(arg);
+                        if( not m_server_socket.empty() )
+                           {
+                            throw std::invalid_argument( std::format("Server socket was already set to {}", m_server_socket) );
+                           }
+                        m_server_socket = str;
+                       }
+                    else if( arg=="--client"sv or arg=="-client"sv )
+                       {// The remaining arguments are for the server
+                        m_client_socket = args.get_next_value_of(arg);
+                        for( args.next(); args.has_data(); args.next() )
+                           {
+                            m_client_args.emplace_back( args.current() );
+                           }
+                        break;
+                       }
+                    else if( arg=="--machine"sv or arg=="--mach"sv or arg=="-m"sv or arg=="-mach"sv )
+                       {// Can be repeated to adapt for multiple machines
+                        m_jobs.front().add_mach_data( args.get_next_value_of(arg) );
+                       }
+                    else if( arg=="--machs"sv or arg=="-machs"sv )
+                       {
+                        m_jobs.front().add_machs_from_file( args.get_next_value_of(arg) );
                        }
                     else if( arg=="--options"sv or arg=="-p"sv )
                        {
@@ -123,8 +221,81 @@ class Arguments final
     //-----------------------------------------------------------------------
     void check_and_postprocess()
        {
-        m_job.detect_task();
-        m_job.ensure_out_path(m_outpath);
+        if( not m_client_socket.empty() )
+           {
+            return;
+           }
+        if( not m_compile_db.empty() )
+           {
+            if( job().target_file() or job().db_file() or job().parax_db_file() or not job().machs().empty() or not job().fleet_dir().empty() or not m_jobs_manifest.empty() or not m_server_socket.empty() or m_watch )
+               {
+                throw std::invalid_argument("Compiling a DB is a task on its own");
+               }
+            if( m_outpath.empty() )
+               {
+                m_outpath = fs::path(m_compile_db).replace_extension(".m32db").string();
+               }
+            return;
+           }
+        if( m_db_coverage )
+           {
+            if( not m_query_fields.empty() or job().parax_db_file() or not job().machs().empty() or not job().fleet_dir().empty() or not m_outpath.empty() or not m_jobs_manifest.empty() or not m_server_socket.empty() or m_watch or job().is_filter() )
+               {
+                throw std::invalid_argument("The DB coverage needs just a DB and possibly a target");
+               }
+            if( not job().db_file() or not job().db_file().is_txt() )
+               {
+                throw std::invalid_argument("The DB coverage needs a parameters DB");
+               }
+            return;
+           }
+        if( not m_query_fields.empty() )
+           {
+            if( job().target_file() or job().parax_db_file() or not job().fleet_dir().empty() or not m_outpath.empty() or not m_jobs_manifest.empty() or not m_server_socket.empty() or m_watch )
+               {
+                throw std::invalid_argument("A query needs just a DB and the machines");
+               }
+            if( not job().db_file() or not job().db_file().is_txt() or job().machs().empty() )
+               {
+                throw std::invalid_argument("A query needs a parameters DB and at least a machine");
+               }
+            return;
+           }
+        if( not m_server_socket.empty() )
+           {
+            if( job().target_file() or job().db_file() or job().parax_db_file() or not job().machs().empty() or not job().fleet_dir().empty() or not m_outpath.empty() or not m_jobs_manifest.empty() )
+               {
+                throw std::invalid_argument("The server jobs are given by its clients");
+               }
+            return;
+           }
+        if( not m_jobs_manifest.empty() )
+           {
+            if( job().target_file() or job().db_file() or job().parax_db_file() or not job().machs().empty() or not job().fleet_dir().empty() or not m_outpath.empty() )
+               {
+                throw std::invalid_argument("The jobs are all specified in the manifest");
+               }
+            return;
+           }
+        if( is_multi_job() )
+           {
+            check_and_postprocess_pairs();
+            return;
+           }
+        if( job().is_filter() and (m_watch or not job().fleet_dir().empty()) )
+           {
+            throw std::invalid_argument("Reading from stdin is just for a single adaptation or update");
+           }
+        m_jobs.front().detect_task();
+        m_jobs.front().ensure_out_path(m_outpath);
+        if( m_watch and (not (job().is_adapt_udt() or job().is_adapt_parax()) or job().is_multi_mach() or m_outpath.empty()) )
+           {
+            throw std::invalid_argument("Watch mode needs a single machine adaptation with an output file");
+           }
+        if( not m_overlays_cache.empty() and (not job().is_adapt_udt() or job().is_multi_mach() or job().is_filter() or m_watch) )
+           {
+            throw std::invalid_argument("The overlays cache is used just adapting an udt file for a single machine");
+           }
        }
 
     //-----------------------------------------------------------------------
@@ -141,19 +312,95 @@ class Arguments final
        {
         std::print( "\nUsage:\n"
                     "   {0} --tgt path/to/MachSettings.udt --db path/to/msetts_pars.txt --mach ActiveW-4.9/4.6-(no-buf,opp)\n"
+                    "   {0} --tgt path/to/MachSettings.udt --db path/to/msetts_pars.txt --machs path/to/machs.txt --out path/to/dir\n"
                     "   {0} --db path/to/old.udt --tgt path/to/new.udt\n"
-                    "       --db <path> (Specify parameters database json file or original file)\n"
+                    "   {0} --tgt path/to/MachSettings.udt --db path/to/msetts_pars.txt --tgt path/to/par2kax.txt --db path/to/par2kax_pars.txt --mach ActiveW-4.9/4.6\n"
+                    "   {0} --stdin MachSettings.udt --db /dev/fd/3 --mach ActiveW-4.9/4.6 < in.udt > out.udt\n"
+                    "   {0} --jobs path/to/jobs.txt\n"
+                    "   {0} --fleet path/to/machines --db path/to/msetts_pars.txt --parax-db path/to/par2kax_pars.txt\n"
+                    "   {0} --fleet path/to/machines --tgt path/to/new.udt\n"
+                    "   {0} --compile-db path/to/msetts_pars.txt --out path/to/msetts_pars.m32db\n"
+                    "   {0} --db path/to/msetts_pars.txt --mach ActiveHP-6.0/4.6-(lowe,fast) --query vqBlade_SpdMax,vnType\n"
+                    "   {0} --db path/to/msetts_pars.txt --tgt path/to/MachSettings.udt --db-coverage\n"
+                    "   {0} --server path/to/socket\n"
+                    "   {0} --client path/to/socket --tgt path/to/MachSettings.udt --db path/to/msetts_pars.txt --mach ActiveW-4.9/4.6\n"
+                    "       --client <socket> (Send the following arguments to a running server, --stop-server to stop it)\n"
+                    "       --compile-db <path> (Write the binary image of a json parameters database, usable as --db)\n"
+                    "       --db <path> (Specify parameters database json file, its compiled .m32db, or original file)\n"
+                    "       --db-coverage (Print the DB sections that set each field, and the fields of --tgt never set)\n"
+                    "       --fleet <dir> (Adapt all <machine>/userdata/MachSettings.udt and <machine>/param/par2kax.txt in place, or update them to --tgt)\n"
                     "       --help/-h (Print help info and abort)\n"
-                    "       --machine/--mach/-m (Specify machine type string)\n"
+                    "       --jobs <path> (Specify a manifest of independent jobs to run concurrently)\n"
+                    "       --machine/--mach/-m (Specify machine type string, can be repeated)\n"
+                    "       --machs <path> (Specify a file listing machine types, one per line)\n"
                     "       --options/-p (Specify comma separated options: no-timestamp)\n"
+                    "       --overlays-cache <dir> (Keep there the DB values resolved for a machine, reused until the DB changes)\n"
+                    "       --parax-db <path> (Specify par2kax.txt parameters database json file for a fleet)\n"
+                    "       --query <fields> (Print the values that the DB sets to the comma separated fields, or axis.param, of the machines)\n"
                     "       --quiet/-q (No user interaction)\n"
-                    "       --target/-tgt (Specify file to adapt or template)\n"
-                    "       --to/--out/-o (Specify output file)\n"
+                    "       --server <socket> (Serve adapt and update requests keeping the DBs in memory)\n"
+                    "       --stdin <name> (Read the target from stdin, named to tell its type, writing the result to stdout)\n"
+                    "       --target/-tgt (Specify file to adapt or template, can be repeated with --db)\n"
+                    "       --to/--out/-o (Specify output file, or directory when multiple machines)\n"
                     "       --verbose/-v (Print more info on stdout)\n"
+                    "       --watch (Adapt again each time the target or the DB are saved)\n"
                     "\n", app::name );
        }
 
  private:
+    //-----------------------------------------------------------------------
+    template<typename FHAS>
+    [[nodiscard]] JobUnit& job_lacking(FHAS const& has)
+       {
+        for( JobUnit& job : m_jobs )
+           {
+            if( not has(job) ) return job;
+           }
+        return m_jobs.emplace_back();
+       }
+
+    //-----------------------------------------------------------------------
+    // More target/db pairs adapted for the same machine, the outputs
+    // are named after the targets in the output directory, if given
+    void check_and_postprocess_pairs()
+       {
+        if( m_watch or not m_server_socket.empty() or job().is_filter() )
+           {
+            throw std::invalid_argument("A single target/db pair is expected");
+           }
+        if( job().machs().size()!=1 )
+           {
+            throw std::invalid_argument("A single machine is expected for more target/db pairs");
+           }
+        const macotec::MachineData mach_data = job().mach_data();
+        if( not m_outpath.empty() )
+           {
+            if( fs::exists(m_outpath) and not fs::is_directory(m_outpath) )
+               {
+                throw std::invalid_argument( std::format("Output \"{}\" must be a directory for more target/db pairs", m_outpath) );
+               }
+            fs::create_directories(m_outpath);
+           }
+        for( std::size_t i=0; i<m_jobs.size(); ++i )
+           {
+            JobUnit& job = m_jobs[i];
+            if( not job.target_file() or not job.db_file() )
+               {
+                throw std::invalid_argument( std::format("Target/db pair {} is incomplete", i+1) );
+               }
+            if( i>0 )
+               {
+                job.add_mach_data(mach_data);
+               }
+            job.detect_task();
+            if( not job.is_adapt_udt() and not job.is_adapt_parax() )
+               {
+                throw std::invalid_argument( std::format("Target/db pair {} isn't an adaptation", i+1) );
+               }
+            job.ensure_out_path( m_outpath.empty() ? std::string{} : (fs::path(m_outpath) / job.target_file().path().filename()).string() );
+           }
+       }
+
     //-----------------------------------------------------------------------
     void apply_switch(const std::string_view full_name, const char brief_name)
        {
@@ -161,6 +408,14 @@ class Arguments final
            {
             m_verbose = true;
            }
+        else if( full_name=="watch"sv )
+           {
+            m_watch = true;
+           }
+        else if( full_name=="db-coverage"sv )
+           {
+            m_db_coverage = true;
+           }
         else if( full_name=="quiet"sv or brief_name=='q' )
            {
             m_quiet = true;
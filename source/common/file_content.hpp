@@ -0,0 +1,178 @@
+﻿#pragma once
+//  ---------------------------------------------
+//  The whole content of a file in memory:
+//  mapped when is a regular file, otherwise
+//  read (pipes, standard input)
+//  ---------------------------------------------
+//  #include "file_content.hpp" // sys::file_content
+//  ---------------------------------------------
+#include <string>
+#include <string_view>
+#include <variant>
+#include <cstdio> // std::FILE, std::fread, std::fopen
+#include <stdexcept> // std::runtime_error
+#include <format>
+#include <filesystem> // std::filesystem::is_regular_file
+
+#include "os-detect.hpp" // MS_WINDOWS, POSIX
+#include "memory_mapped_file.hpp" // sys::memory_mapped_file
+
+#if defined(MS_WINDOWS)
+  #include <io.h> // _setmode, _fileno
+  #include <fcntl.h> // _O_BINARY
+#endif
+
+using namespace std::literals; // "..."sv
+
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+namespace sys //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+//---------------------------------------------------------------------------
+// Don't let the runtime translate the line breaks of the standard streams
+void set_binary_mode([[maybe_unused]] std::FILE* const f) noexcept
+{
+  #if defined(MS_WINDOWS)
+    ::_setmode(::_fileno(f), _O_BINARY);
+  #endif
+}
+
+
+//---------------------------------------------------------------------------
+[[nodiscard]] std::string read_all(std::FILE* const f, const std::string_view name)
+{
+    std::string content;
+    char chunk[4096];
+    std::size_t n;
+    while( (n = std::fread(chunk, 1, sizeof(chunk), f))>0 )
+       {
+        content.append(chunk, n);
+       }
+    if( std::ferror(f) )
+       {
+        throw std::runtime_error( std::format("Cannot read {}", name) );
+       }
+    return content;
+}
+
+
+//---------------------------------------------------------------------------
+void write_all(std::FILE* const f, const std::string_view content, const std::string_view name)
+{
+    if( std::fwrite(content.data(), 1, content.size(), f)!=content.size() or std::fflush(f)!=0 )
+       {
+        throw std::runtime_error( std::format("Cannot write to {}", name) );
+       }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+class file_content final
+{
+ private:
+    std::variant<std::string, memory_mapped_file> m_buf;
+
+ public:
+    explicit file_content(const std::string& pth)
+      : m_buf{ content_of(pth) }
+       {}
+
+    //-----------------------------------------------------------------------
+    [[nodiscard]] static file_content of_string(std::string&& content)
+       {
+        return file_content{ std::in_place_type<std::string>, std::move(content) };
+       }
+
+    //-----------------------------------------------------------------------
+    [[nodiscard]] static file_content of_stdin()
+       {
+        set_binary_mode(stdin);
+        return of_string( read_all(stdin, "stdin"sv) );
+       }
+
+    [[nodiscard]] std::string_view as_string_view() const noexcept
+       {
+        if( const auto* const mapped = std::get_if<memory_mapped_file>(&m_buf) )
+           {
+            return mapped->as_string_view();
+           }
+        return std::get<std::string>(m_buf);
+       }
+
+ private:
+    explicit file_content(std::in_place_type_t<std::string>, std::string&& content) noexcept
+      : m_buf{ std::move(content) }
+       {}
+
+    //-----------------------------------------------------------------------
+    [[nodiscard]] static std::variant<std::string, memory_mapped_file> content_of(const std::string& pth)
+       {
+        if( std::filesystem::is_regular_file(pth) )
+           {
+            return std::variant<std::string, memory_mapped_file>{ std::in_place_type<memory_mapped_file>, pth.c_str() };
+           }
+        // Not mappable: a pipe or a device, as /dev/fd/3
+        std::FILE* const f = std::fopen(pth.c_str(), "rb");
+        if( not f )
+           {
+            throw std::runtime_error( std::format("Couldn't open {}", pth) );
+           }
+        try{
+            std::string content = read_all(f, pth);
+            std::fclose(f);
+            return content;
+           }
+        catch(...)
+           {
+            std::fclose(f);
+            throw;
+           }
+       }
+};
+
+}//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+#ifdef TEST_UNITS ///////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+#if defined(POSIX)
+  #include <thread> // std::jthread
+  #include <sys/stat.h> // mkfifo
+#endif
+/////////////////////////////////////////////////////////////////////////////
+static ut::suite<"sys::file_content"> file_content_tests = []
+{////////////////////////////////////////////////////////////////////////////
+
+ut::test("regular file and buffer") = []
+   {
+    const std::string_view content = "123456"sv;
+    test::TemporaryFile file("~file_content.tmp", content);
+    ut::expect( ut::that % sys::file_content(file.path().string()).as_string_view()==content );
+    ut::expect( ut::that % sys::file_content::of_string(std::string{content}).as_string_view()==content );
+   };
+
+#if defined(POSIX)
+ut::test("pipe") = []
+   {
+    test::TemporaryDirectory tmp_dir;
+    const std::string fifo_path = (tmp_dir.path() / "fifo").string();
+    ut::expect( ut::fatal(ut::that % ::mkfifo(fifo_path.c_str(), 0600)==0) );
+
+    const std::string content(10000, 'x'); // More than a single chunk
+    std::jthread writer([&]
+       {
+        std::FILE* const f = std::fopen(fifo_path.c_str(), "wb");
+        sys::write_all(f, content, fifo_path);
+        std::fclose(f);
+       });
+    ut::expect( ut::that % sys::file_content(fifo_path).as_string_view()==content );
+   };
+#endif
+
+};///////////////////////////////////////////////////////////////////////////
+#endif // TEST_UNITS ////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
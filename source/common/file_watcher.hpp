@@ -0,0 +1,189 @@
+﻿#pragma once
+//  ---------------------------------------------
+//  Get notified when some files are written
+//  ---------------------------------------------
+//  #include "file_watcher.hpp" // sys::file_watcher
+//  ---------------------------------------------
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm> // std::ranges::find
+#include <chrono> // std::chrono::*
+#include <stdexcept> // std::runtime_error
+#include <format>
+#include <cstring> // std::strerror
+#include <cerrno> // errno
+#include <filesystem> // std::filesystem
+
+#include "os-detect.hpp" // MS_WINDOWS, POSIX
+
+#if defined(POSIX)
+  #include <sys/inotify.h> // inotify_*
+  #include <poll.h> // poll
+  #include <unistd.h> // read, close
+#endif
+
+namespace fs = std::filesystem;
+
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+namespace sys //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+#if defined(POSIX)
+
+/////////////////////////////////////////////////////////////////////////////
+// Watches the parent directories, so files replaced by
+// the editors with a rename are detected as well
+class file_watcher final
+{
+ private:
+    int m_fd = -1;
+    std::map<int, fs::path> m_dirs; // By watch descriptor
+    std::vector<fs::path> m_files;
+
+ public:
+    file_watcher()
+      : m_fd{ ::inotify_init1(IN_CLOEXEC) }
+       {
+        if( m_fd==-1 )
+           {
+            throw std::runtime_error( std::format("Cannot initialize inotify ({})", std::strerror(errno)) );
+           }
+       }
+
+    ~file_watcher() noexcept
+       {
+        ::close(m_fd);
+       }
+
+    file_watcher(const file_watcher&) = delete;
+    file_watcher& operator=(const file_watcher&) = delete;
+    file_watcher(file_watcher&&) = delete;
+    file_watcher& operator=(file_watcher&&) = delete;
+
+    //-----------------------------------------------------------------------
+    void add(const fs::path& pth)
+       {
+        const fs::path file_path = fs::absolute(pth).lexically_normal();
+        const fs::path dir_path = file_path.parent_path();
+        const int wd = ::inotify_add_watch(m_fd, dir_path.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+        if( wd==-1 )
+           {
+            throw std::runtime_error( std::format("Cannot watch {} ({})", dir_path.string(), std::strerror(errno)) );
+           }
+        m_dirs.insert_or_assign(wd, dir_path);
+        m_files.push_back(file_path);
+       }
+
+    //-----------------------------------------------------------------------
+    // Wait until some of the watched files are written, returning them.
+    // The events are collected until a pause of settle_ms, to get a save
+    // done in more steps just once. An empty list means timeout
+    [[nodiscard]] std::vector<fs::path> wait_changes(const int timeout_ms =-1, const int settle_ms =50)
+       {
+        std::vector<fs::path> changed;
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+        while( changed.empty() )
+           {
+            int wait_ms = -1;
+            if( timeout_ms>=0 )
+               {
+                wait_ms = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count());
+                if( wait_ms<0 ) break;
+               }
+            if( not wait_events(wait_ms) ) break;
+            collect_events(changed);
+           }
+        while( not changed.empty() and wait_events(settle_ms) )
+           {
+            collect_events(changed);
+           }
+        return changed;
+       }
+
+ private:
+    //-----------------------------------------------------------------------
+    [[nodiscard]] bool wait_events(const int timeout_ms) const
+       {
+        pollfd pfd{ .fd=m_fd, .events=POLLIN, .revents=0 };
+        int ret;
+        do{ ret = ::poll(&pfd, 1, timeout_ms); }
+        while( ret==-1 and errno==EINTR );
+        if( ret==-1 )
+           {
+            throw std::runtime_error( std::format("Cannot poll inotify ({})", std::strerror(errno)) );
+           }
+        return ret>0;
+       }
+
+    //-----------------------------------------------------------------------
+    void collect_events(std::vector<fs::path>& changed) const
+       {
+        alignas(inotify_event) char buf[4096];
+        const ssize_t len = ::read(m_fd, buf, sizeof(buf));
+        if( len<=0 )
+           {
+            return;
+           }
+        for( ssize_t i=0; i<len; )
+           {
+            const auto* const event = reinterpret_cast<const inotify_event*>(buf + i);
+            if( const auto it_dir = m_dirs.find(event->wd);
+                event->len>0 and it_dir!=m_dirs.end() )
+               {
+                const fs::path file_path = it_dir->second / event->name;
+                if( std::ranges::find(m_files, file_path)!=m_files.end() and
+                    std::ranges::find(changed, file_path)==changed.end() )
+                   {
+                    changed.push_back(file_path);
+                   }
+               }
+            i += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+           }
+       }
+};
+
+#endif
+
+}//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+#ifdef TEST_UNITS ///////////////////////////////////////////////////////////
+#if defined(POSIX) //////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+static ut::suite<"sys::file_watcher"> file_watcher_tests = []
+{////////////////////////////////////////////////////////////////////////////
+
+ut::test("written and replaced files") = []
+   {
+    test::TemporaryDirectory tmp_dir;
+    const auto watched = tmp_dir.create_file("watched.txt", "1"sv);
+    const auto other = tmp_dir.create_file("other.txt", "1"sv);
+
+    sys::file_watcher watcher;
+    watcher.add(watched.path());
+    ut::expect( watcher.wait_changes(0).empty() ) << "nothing changed yet\n";
+
+    std::ignore = tmp_dir.create_file("other.txt", "2"sv);
+    ut::expect( watcher.wait_changes(100).empty() ) << "not watched file\n";
+
+    std::ignore = tmp_dir.create_file("watched.txt", "2"sv);
+    std::vector<fs::path> changed = watcher.wait_changes(1000);
+    ut::expect( ut::fatal(ut::that % changed.size()==1u) );
+    ut::expect( fs::equivalent(changed.front(), watched.path()) );
+
+    // Saved with a rename, as many editors do
+    std::ignore = tmp_dir.create_file("~watched.tmp", "3"sv);
+    fs::rename(tmp_dir.path() / "~watched.tmp", watched.path());
+    changed = watcher.wait_changes(1000);
+    ut::expect( ut::that % changed.size()==1u );
+   };
+
+};///////////////////////////////////////////////////////////////////////////
+#endif // POSIX /////////////////////////////////////////////////////////////
+#endif // TEST_UNITS ////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
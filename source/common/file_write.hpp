@@ -5,12 +5,25 @@
 //  ---------------------------------------------
 #include <cassert>
 #include <string_view>
+#include <span>
 #include <cstdio> // std::fopen, ::fopen_s (Microsoft)
 #include <stdexcept> // std::runtime_error
 #include <format>
 
 #include "os-detect.hpp" // MS_WINDOWS, POSIX
 
+#if defined(POSIX)
+  #include <vector>
+  #include <algorithm> // std::min
+  #include <cerrno> // errno, EINTR
+  #include <cstring> // std::strerror
+  #include <climits> // IOV_MAX
+  #include <sys/uio.h> // ::writev, ::iovec
+  #ifndef IOV_MAX
+    #define IOV_MAX 1024
+  #endif
+#endif
+
 
 
 //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
@@ -88,6 +101,51 @@ class file_write final
         return *this;
        }
 
+    //-----------------------------------------------------------------------
+    // Write many pieces at once, where possible with a single system
+    // call that takes them where they are, without copying them
+    void write_all(const std::span<const std::string_view> fragments) const
+       {
+        assert(m_fstream!=nullptr);
+      #if defined(POSIX)
+        std::fflush(m_fstream); // What was streamed before comes first
+        std::vector<::iovec> iovs;
+        iovs.reserve(fragments.size());
+        for( const std::string_view sv : fragments )
+           {
+            if( not sv.empty() ) iovs.push_back({const_cast<char*>(sv.data()), sv.size()});
+           }
+        const int fd = ::fileno(m_fstream);
+        std::size_t i = 0;
+        while( i<iovs.size() )
+           {
+            const ::ssize_t written = ::writev(fd, iovs.data()+i, static_cast<int>(std::min<std::size_t>(iovs.size()-i, IOV_MAX)));
+            if( written<0 )
+               {
+                if( errno==EINTR ) continue;
+                throw std::runtime_error{ std::format("Cannot write to file ({})", std::strerror(errno)) };
+               }
+            // Skip what was written, a partial write can leave a piece in the middle
+            auto remaining = static_cast<std::size_t>(written);
+            while( i<iovs.size() and remaining>=iovs[i].iov_len )
+               {
+                remaining -= iovs[i].iov_len;
+                ++i;
+               }
+            if( remaining>0 )
+               {
+                iovs[i].iov_base = static_cast<char*>(iovs[i].iov_base) + remaining;
+                iovs[i].iov_len -= remaining;
+               }
+           }
+      #else
+        for( const std::string_view sv : fragments )
+           {
+            operator<<(sv);
+           }
+      #endif
+       }
+
  private:
     [[nodiscard]] static inline std::FILE* file_open( const char* const filename, const char* const mode ) noexcept
        {
@@ -123,6 +181,26 @@ ut::test("write and verify") = []
     ut::expect( ut::that % file.content() == content );
    };
 
+ut::test("write all") = []
+   {
+    test::TemporaryFile file("~file_write.tmp");
+    std::vector<std::string> pieces;
+    std::string expected = "head-";
+    for( int i=0; i<3000; ++i ) // More than IOV_MAX
+       {
+        pieces.push_back( std::format("{},", i) );
+        expected += pieces.back();
+       }
+    pieces.emplace_back(); // Empty ones are skipped
+    const std::vector<std::string_view> fragments(pieces.begin(), pieces.end());
+
+       {sys::file_write out{ file.path().string().c_str() };
+        out << "head-"sv;
+        out.write_all(fragments); }
+
+    ut::expect( ut::that % file.content() == expected );
+   };
+
 };///////////////////////////////////////////////////////////////////////////
 #endif // TEST_UNITS ////////////////////////////////////////////////////////
 /////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,161 @@
+﻿#pragma once
+//  ---------------------------------------------
+//  Open addressing index of the positions of
+//  elements kept in a contiguous array, looked
+//  up by a string key
+//  .No node allocations, lookups are cache local
+//  .The keys are not stored, just their hashes
+//  ---------------------------------------------
+//  #include "flat_hash_index.hpp" // MG::flat_hash_index
+//  ---------------------------------------------
+#include <cstdint> // std::uint32_t
+#include <string_view>
+#include <vector>
+#include <optional>
+#include <functional> // std::hash
+#include <bit> // std::bit_ceil
+#include <concepts> // std::invocable
+
+
+namespace MG //::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+/////////////////////////////////////////////////////////////////////////////
+// The caller provides the key of each position, usually
+// a field of the element in its own array
+class flat_hash_index final
+{
+ public:
+    using pos_type = std::uint32_t;
+
+ private:
+    struct slot_t final
+       {
+        std::uint32_t hash = 0;
+        pos_type pos = empty_pos;
+       };
+    static constexpr pos_type empty_pos = ~pos_type{0};
+
+    std::vector<slot_t> m_slots; // Linear probing, size is a power of two
+    std::size_t m_count = 0;
+
+ public:
+    flat_hash_index() noexcept =default;
+    explicit flat_hash_index(const std::size_t expected_count) { reserve(expected_count); }
+
+    [[nodiscard]] std::size_t size() const noexcept { return m_count; }
+    [[nodiscard]] bool is_empty() const noexcept { return m_count==0; }
+
+    //-----------------------------------------------------------------------
+    // Keeping the load factor at most 1/2
+    void reserve(const std::size_t count)
+       {
+        const std::size_t needed_slots = std::bit_ceil(2*count + 2);
+        if( needed_slots>m_slots.size() ) rehash(needed_slots);
+       }
+
+    //-----------------------------------------------------------------------
+    template<std::invocable<pos_type> FKEY>
+    [[nodiscard]] std::optional<pos_type> find(const std::string_view key, FKEY const& key_of) const noexcept
+       {
+        if( m_slots.empty() ) return {};
+        const std::uint32_t h = hash_of(key);
+        for( std::size_t i=h & mask(); m_slots[i].pos!=empty_pos; i=(i+1) & mask() )
+           {
+            if( m_slots[i].hash==h and std::string_view{key_of(m_slots[i].pos)}==key ) return m_slots[i].pos;
+           }
+        return {};
+       }
+
+    //-----------------------------------------------------------------------
+    // The position of the element with that key, the given one if new
+    template<std::invocable<pos_type> FKEY>
+    [[nodiscard]] pos_type find_or_insert(const std::string_view key, const pos_type pos, FKEY const& key_of)
+       {
+        reserve(m_count+1);
+        const std::uint32_t h = hash_of(key);
+        std::size_t i = h & mask();
+        for( ; m_slots[i].pos!=empty_pos; i=(i+1) & mask() )
+           {
+            if( m_slots[i].hash==h and std::string_view{key_of(m_slots[i].pos)}==key ) return m_slots[i].pos;
+           }
+        m_slots[i] = {h, pos};
+        ++m_count;
+        return pos;
+       }
+
+    void clear() noexcept
+       {
+        m_slots.assign(m_slots.size(), slot_t{});
+        m_count = 0;
+       }
+
+ private:
+    [[nodiscard]] std::size_t mask() const noexcept { return m_slots.size()-1; }
+
+    [[nodiscard]] static std::uint32_t hash_of(const std::string_view key) noexcept
+       {
+        return static_cast<std::uint32_t>( std::hash<std::string_view>{}(key) );
+       }
+
+    //-----------------------------------------------------------------------
+    // The stored hashes spare the keys access
+    void rehash(const std::size_t slots_count)
+       {
+        std::vector<slot_t> old_slots( slots_count );
+        old_slots.swap(m_slots);
+        for( const slot_t& slot : old_slots )
+           {
+            if( slot.pos==empty_pos ) continue;
+            std::size_t i = slot.hash & mask();
+            while( m_slots[i].pos!=empty_pos ) i = (i+1) & mask();
+            m_slots[i] = slot;
+           }
+       }
+};
+
+}//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+#ifdef TEST_UNITS ///////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+static ut::suite<"flat_hash_index"> flat_hash_index_tests = []
+{////////////////////////////////////////////////////////////////////////////
+
+ut::test("MG::flat_hash_index") = []
+   {
+    std::vector<std::string> keys;
+    MG::flat_hash_index index;
+    const auto key_of = [&keys](const MG::flat_hash_index::pos_type pos) noexcept -> const std::string& { return keys[pos]; };
+    ut::expect( not index.find("a"sv, key_of) ) << "empty index shouldn't find anything\n";
+
+    for( int i=0; i<1000; ++i ) // Many rehashes
+       {
+        keys.push_back( std::format("key{}", i) );
+        const auto pos = static_cast<MG::flat_hash_index::pos_type>(keys.size()-1);
+        ut::expect( ut::that % index.find_or_insert(keys.back(), pos, key_of)==pos );
+       }
+    ut::expect( ut::that % index.size()==1000u );
+    ut::expect( ut::that % index.find_or_insert("key10"sv, 1000u, key_of)==10u ) << "existing key should give its position\n";
+    ut::expect( ut::that % index.size()==1000u );
+
+    bool all_found = true;
+    for( std::size_t i=0; i<keys.size(); ++i )
+       {
+        const auto found = index.find(keys[i], key_of);
+        if( not found or *found!=i ) all_found = false;
+       }
+    ut::expect( all_found );
+    ut::expect( not index.find("key1000"sv, key_of) );
+    ut::expect( not index.find(""sv, key_of) );
+
+    index.clear();
+    ut::expect( index.is_empty() and not index.find("key1"sv, key_of) );
+   };
+
+};///////////////////////////////////////////////////////////////////////////
+#endif // TEST_UNITS ////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
@@ -3,8 +3,27 @@
 //  Abstraction of a callable that takes
 //  temporary string
 //  ---------------------------------------------
-//  #include "fnotify_type.hpp" // fnotify_t
+//  #include "fnotify_type.hpp" // fnotify_t, MG::make_thread_safe()
 //  ---------------------------------------------
 #include <functional> // std::function
+#include <memory> // std::make_shared
+#include <mutex> // std::mutex, std::scoped_lock
 
 using fnotify_t = std::function<void(std::string&&)>;
+
+
+namespace MG //::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+//---------------------------------------------------------------------------
+// Wraps a notifier so that can be called concurrently by multiple threads
+[[nodiscard]] fnotify_t make_thread_safe(fnotify_t notify)
+{
+    return [mtx=std::make_shared<std::mutex>(), notify=std::move(notify)](std::string&& msg)
+           {
+            const std::scoped_lock lock{*mtx};
+            notify( std::move(msg) );
+           };
+}
+
+}//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
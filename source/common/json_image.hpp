@@ -0,0 +1,464 @@
+﻿#pragma once
+//  ---------------------------------------------
+//  A json tree compiled in a binary image that
+//  can be used as is from a memory mapped file,
+//  without parsing and heap allocations
+//  ---------------------------------------------
+//  #include "json_image.hpp" // json::Image, json::compile_image()
+//  ---------------------------------------------
+#include <cstdint> // std::uint32_t
+#include <cstring> // std::memcpy
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <optional>
+#include <utility> // std::pair
+#include <iterator> // std::input_iterator_tag
+#include <stdexcept> // std::runtime_error
+#include <format>
+
+#include "json_node.hpp" // json::Node
+#include "json_tree.hpp" // json::Tree
+
+using namespace std::literals; // "..."sv
+
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+namespace json //::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+//  Layout (native byte order, checked by the header):
+//  ┌header: magic, byte order mark, nodes count, strings size
+//  ├nodes: key, value (string table spans), first child, childs count
+//  │       the root is the first, the childs of a node are contiguous
+//  │       and sorted by key, so they can be searched by bisection;
+//  │       more nodes can share the same childs
+//  └strings: the keys and values, each one stored once
+namespace image_layout //::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+    inline constexpr std::string_view magic = "JSONIMG1"sv;
+    inline constexpr std::uint32_t byte_order_mark = 0x01020304u;
+
+    struct header_t final
+       {
+        char magic[8];
+        std::uint32_t byte_order;
+        std::uint32_t nodes_count;
+        std::uint32_t strings_size;
+        std::uint32_t reserved;
+       };
+
+    struct span_t final
+       {
+        std::uint32_t offset;
+        std::uint32_t length;
+       };
+
+    struct node_t final
+       {
+        span_t key;
+        span_t value;
+        std::uint32_t first_child;
+        std::uint32_t childs_count;
+       };
+
+    inline constexpr std::size_t nodes_offset = sizeof(header_t);
+
+    //-----------------------------------------------------------------------
+    // The buffer could be not aligned, copying avoids any trouble
+    template<typename T>
+    [[nodiscard]] T read_at(const std::string_view buf, const std::size_t offset) noexcept
+       {
+        T t;
+        std::memcpy(&t, buf.data()+offset, sizeof(T));
+        return t;
+       }
+}//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+
+/////////////////////////////////////////////////////////////////////////////
+// A node in an image, offering the same read interface of json::Node
+class NodeView final
+{
+ private:
+    std::string_view m_buf; // Whole image
+    std::uint32_t m_nodes_count = 0;
+    image_layout::node_t m_node{};
+
+ public:
+    /////////////////////////////////////////////////////////////////////////
+    // Doesn't refer to the parent view, that could be a temporary
+    class childs_type final
+    {
+     public:
+        /////////////////////////////////////////////////////////////////////
+        class iterator final
+        {
+         private:
+            std::string_view m_buf;
+            std::uint32_t m_nodes_count;
+            std::uint32_t m_idx;
+
+         public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = std::pair<std::string_view, NodeView>;
+            using difference_type = std::ptrdiff_t;
+
+            iterator(const std::string_view buf, const std::uint32_t nodes_count, const std::uint32_t idx) noexcept
+              : m_buf{buf}
+              , m_nodes_count{nodes_count}
+              , m_idx{idx}
+               {}
+
+            [[nodiscard]] value_type operator*() const noexcept
+               {
+                const NodeView child{m_buf, m_nodes_count, m_idx};
+                return { child.key(), child };
+               }
+            iterator& operator++() noexcept { ++m_idx; return *this; }
+            [[nodiscard]] bool operator==(const iterator& other) const noexcept { return m_idx==other.m_idx; }
+        };
+
+     private:
+        std::string_view m_buf;
+        std::uint32_t m_nodes_count;
+        std::uint32_t m_first;
+        std::uint32_t m_count;
+
+     public:
+        explicit childs_type(const std::string_view buf, const std::uint32_t nodes_count, const std::uint32_t first, const std::uint32_t count) noexcept
+          : m_buf{buf}
+          , m_nodes_count{nodes_count}
+          , m_first{first}
+          , m_count{count}
+           {}
+
+        [[nodiscard]] std::size_t size() const noexcept { return m_count; }
+        [[nodiscard]] bool empty() const noexcept { return m_count==0; }
+        [[nodiscard]] iterator begin() const noexcept { return {m_buf, m_nodes_count, m_first}; }
+        [[nodiscard]] iterator end() const noexcept { return {m_buf, m_nodes_count, m_first + m_count}; }
+    };
+
+ public:
+    NodeView() noexcept = default;
+    explicit NodeView(const std::string_view buf, const std::uint32_t nodes_count, const std::uint32_t idx) noexcept
+      : m_buf{buf}
+      , m_nodes_count{nodes_count}
+      , m_node{ image_layout::read_at<image_layout::node_t>(buf, image_layout::nodes_offset + idx*sizeof(image_layout::node_t)) }
+       {}
+
+    [[nodiscard]] std::string_view key() const noexcept { return string_at(m_node.key); }
+    [[nodiscard]] std::string_view value() const noexcept { return string_at(m_node.value); }
+    [[nodiscard]] bool has_value() const noexcept { return m_node.value.length>0; }
+    [[nodiscard]] bool has_childs() const noexcept { return m_node.childs_count>0; }
+    [[nodiscard]] bool is_leaf() const noexcept { return not has_childs() and has_value(); }
+    [[nodiscard]] childs_type childs() const noexcept { return childs_type{m_buf, m_nodes_count, m_node.first_child, m_node.childs_count}; }
+
+    //-----------------------------------------------------------------------
+    [[nodiscard]] std::optional<NodeView> get_child(const std::string_view childname) const noexcept
+       {
+        std::uint32_t lo = m_node.first_child;
+        std::uint32_t hi = m_node.first_child + m_node.childs_count;
+        while( lo<hi )
+           {
+            const std::uint32_t mid = lo + (hi-lo)/2;
+            const NodeView child = node_at(mid);
+            if( const auto cmp = child.key().compare(childname); cmp<0 ) lo = mid+1;
+            else if( cmp>0 ) hi = mid;
+            else return child;
+           }
+        return std::nullopt;
+       }
+
+    //-----------------------------------------------------------------------
+    [[nodiscard]] std::size_t total_values_count() const noexcept
+       {
+        if( is_leaf() ) return 1;
+        std::size_t n = 0;
+        for( const auto& [key, child] : childs() )
+           {
+            n += child.total_values_count();
+           }
+        return n;
+       }
+
+ private:
+    [[nodiscard]] NodeView node_at(const std::uint32_t idx) const noexcept
+       {
+        return NodeView{m_buf, m_nodes_count, idx};
+       }
+
+    [[nodiscard]] std::string_view string_at(const image_layout::span_t span) const noexcept
+       {
+        const std::size_t strings_offset = image_layout::nodes_offset + m_nodes_count*sizeof(image_layout::node_t);
+        return m_buf.substr(strings_offset + span.offset, span.length);
+       }
+};
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Refers to the image content, that must outlive it
+class Image final
+{
+ private:
+    std::string_view m_buf;
+    std::uint32_t m_nodes_count = 0;
+
+ public:
+    explicit Image(const std::string_view buf)
+      : m_buf{buf}
+      , m_nodes_count{ check_layout(buf) }
+       {}
+
+    [[nodiscard]] static bool is_image(const std::string_view buf) noexcept
+       {
+        return buf.starts_with(image_layout::magic);
+       }
+
+    [[nodiscard]] NodeView root() const noexcept
+       {
+        return NodeView{m_buf, m_nodes_count, 0};
+       }
+
+ private:
+    //-----------------------------------------------------------------------
+    // Just bounds checks, so the nodes can be accessed blindly
+    [[nodiscard]] static std::uint32_t check_layout(const std::string_view buf)
+       {
+        using namespace image_layout;
+        if( buf.size()<sizeof(header_t) or not is_image(buf) )
+           {
+            throw std::runtime_error("Not a json image");
+           }
+        const header_t header = read_at<header_t>(buf, 0);
+        if( header.byte_order!=byte_order_mark )
+           {
+            throw std::runtime_error("json image with another byte order");
+           }
+        const std::size_t strings_offset = nodes_offset + std::size_t{header.nodes_count}*sizeof(node_t);
+        if( header.nodes_count==0 or strings_offset + header.strings_size != buf.size() )
+           {
+            throw std::runtime_error("Truncated json image");
+           }
+        for( std::uint32_t i=0; i<header.nodes_count; ++i )
+           {
+            const node_t node = read_at<node_t>(buf, nodes_offset + i*sizeof(node_t));
+            if( std::size_t{node.key.offset} + node.key.length > header.strings_size or
+                std::size_t{node.value.offset} + node.value.length > header.strings_size or
+                (node.childs_count>0 and (node.first_child<=i or std::size_t{node.first_child} + node.childs_count > header.nodes_count)) )
+               {
+                throw std::runtime_error( std::format("Corrupted json image (node {})", i) );
+               }
+           }
+        return header.nodes_count;
+       }
+};
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Collects the nodes and the strings of an image
+class image_writer final
+{
+ private:
+    std::vector<image_layout::node_t> m_nodes;
+    std::string m_strings;
+    std::unordered_map<std::string_view, image_layout::span_t> m_spans; // Refer to the tree
+
+ public:
+    explicit image_writer(const std::size_t nodes_count)
+       {
+        m_nodes.reserve(nodes_count);
+       }
+
+    [[nodiscard]] std::size_t nodes_count() const noexcept { return m_nodes.size(); }
+
+    //-----------------------------------------------------------------------
+    void add_node(const std::string_view key, const std::string_view value)
+       {
+        m_nodes.push_back({ .key=span_of(key), .value=span_of(value), .first_child=0, .childs_count=0 });
+       }
+
+    //-----------------------------------------------------------------------
+    [[nodiscard]] image_layout::node_t& node_at(const std::size_t idx) noexcept { return m_nodes[idx]; }
+
+    //-----------------------------------------------------------------------
+    [[nodiscard]] std::string image() const
+       {
+        using namespace image_layout;
+        header_t header{};
+        std::memcpy(header.magic, magic.data(), sizeof(header.magic));
+        header.byte_order = byte_order_mark;
+        header.nodes_count = static_cast<std::uint32_t>(m_nodes.size());
+        header.strings_size = static_cast<std::uint32_t>(m_strings.size());
+
+        std::string img( sizeof(header_t) + m_nodes.size()*sizeof(node_t), '\0' );
+        std::memcpy(img.data(), &header, sizeof(header_t));
+        std::memcpy(img.data()+nodes_offset, m_nodes.data(), m_nodes.size()*sizeof(node_t));
+        img += m_strings;
+        return img;
+       }
+
+ private:
+    //-----------------------------------------------------------------------
+    [[nodiscard]] image_layout::span_t span_of(const std::string_view sv)
+       {
+        if( sv.empty() ) return {0,0};
+        auto [it, inserted] = m_spans.try_emplace(sv);
+        if( inserted )
+           {
+            it->second = { static_cast<std::uint32_t>(m_strings.size()), static_cast<std::uint32_t>(sv.size()) };
+            m_strings += sv;
+           }
+        return it->second;
+       }
+};
+
+
+//---------------------------------------------------------------------------
+// Nodes numbered breadth first, so the childs of each one are contiguous
+[[nodiscard]] std::string compile_image(const Node& root)
+{
+    image_writer writer(1 + root.childs().size());
+    writer.add_node({}, root.value());
+    std::deque<std::pair<const Node*, std::size_t>> to_visit{ {&root, 0} };
+    while( not to_visit.empty() )
+       {
+        const auto [node, idx] = to_visit.front();
+        to_visit.pop_front();
+        if( node->has_childs() )
+           {
+            writer.node_at(idx).first_child = static_cast<std::uint32_t>(writer.nodes_count());
+            writer.node_at(idx).childs_count = static_cast<std::uint32_t>(node->childs().size());
+           }
+        for( const auto& [key, child] : node->childs() ) // Already sorted
+           {
+            to_visit.emplace_back(&child, writer.nodes_count());
+            writer.add_node(key, child.value());
+           }
+       }
+    return writer.image();
+}
+
+
+//---------------------------------------------------------------------------
+[[nodiscard]] std::string compile_image(const Tree& tree)
+{
+    image_writer writer(tree.nodes_count());
+    writer.add_node({}, tree.root().value());
+    std::unordered_map<std::uint32_t, std::uint32_t> written_childs; // Keep the shared childs shared
+    std::deque<std::pair<Tree::NodeRef, std::size_t>> to_visit{ {tree.root(), 0} };
+    while( not to_visit.empty() )
+       {
+        const auto [node, idx] = to_visit.front();
+        to_visit.pop_front();
+        if( not node.has_childs() )
+           {
+            continue;
+           }
+        writer.node_at(idx).childs_count = static_cast<std::uint32_t>(node.childs().size());
+        if( const auto it = written_childs.find(node.childs_id());
+            it!=written_childs.end() and it->second>idx ) // Childs must follow their parent
+           {
+            writer.node_at(idx).first_child = it->second;
+            continue;
+           }
+        writer.node_at(idx).first_child = written_childs[node.childs_id()] = static_cast<std::uint32_t>(writer.nodes_count());
+        for( const auto& [key, child] : node.childs() ) // Already sorted
+           {
+            to_visit.emplace_back(child, writer.nodes_count());
+            writer.add_node(key, child.value());
+           }
+       }
+    return writer.image();
+}
+
+}//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+#ifdef TEST_UNITS ///////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+static ut::suite<"json_image"> json_image_tests = []
+{////////////////////////////////////////////////////////////////////////////
+
+ut::test("json::compile_image()") = []
+   {
+    json::Node root;
+    auto& b = root.ensure_child("b");
+        b.ensure_child("b2").set_value("2");
+        b.ensure_child("b1").set_value("1");
+    root.ensure_child("a").set_value("1");
+    auto& c = root.ensure_child("c");
+        c.ensure_child("c1").ensure_child("c11").set_value("x");
+
+    const std::string image = json::compile_image(root);
+    const json::Image img(image);
+    const json::NodeView img_root = img.root();
+    ut::expect( ut::that % img_root.childs().size()==3u );
+    ut::expect( ut::that % img_root.total_values_count()==root.total_values_count() );
+
+    std::string keys;
+    for( const auto& [key, child] : img_root.childs() ) keys += key;
+    ut::expect( ut::that % keys=="abc"sv ) << "childs should be sorted\n";
+
+    const auto b_view = img_root.get_child("b"sv);
+    ut::expect( ut::fatal(b_view.has_value()) );
+    ut::expect( not b_view->is_leaf() and b_view->has_childs() );
+    ut::expect( ut::that % b_view->get_child("b2"sv)->value()=="2"sv );
+    ut::expect( img_root.get_child("a"sv)->is_leaf() );
+    ut::expect( ut::that % img_root.get_child("c"sv)->get_child("c1"sv)->get_child("c11"sv)->value()=="x"sv );
+    ut::expect( not img_root.get_child("d"sv) );
+    ut::expect( not b_view->get_child("b0"sv) );
+   };
+
+ut::test("json::compile_image(json::Tree)") = []
+   {
+    const std::string_view keys = "abc12"sv; // The tree refers to these
+    json::Tree::Builder builder;
+    auto root = builder.root();
+    auto b = root.ensure_child(keys.substr(1,1));
+        b.ensure_child(keys.substr(3,1)).set_value(keys.substr(4,1));
+    root.ensure_child(keys.substr(0,1)).set_value(keys.substr(3,1));
+    root.ensure_child(keys.substr(2,1));
+
+    json::Node node_root;
+    node_root.ensure_child("b").ensure_child("1").set_value("2");
+    node_root.ensure_child("a").set_value("1");
+    node_root.ensure_child("c");
+
+    ut::expect( ut::that % json::compile_image(builder.build())==json::compile_image(node_root) ) << "should have the same image\n";
+
+    json::Tree::Builder shared_builder;
+    auto shared_root = shared_builder.root();
+    auto bag = shared_root.new_detached();
+        bag.ensure_child("g").ensure_child("x").set_value("1");
+    shared_root.ensure_child("a").insert_childs_of(bag);
+    shared_root.ensure_child("b").insert_childs_of(bag);
+    const json::Tree tree = shared_builder.build();
+    const std::string img = json::compile_image(tree);
+    const json::Image image(img);
+    ut::expect( ut::that % tree.nodes_count()==5u ) << "shared childs should be stored once\n";
+    ut::expect( ut::that % json::image_layout::read_at<json::image_layout::header_t>(img, 0).nodes_count==5u ) << "shared childs should stay shared\n";
+    ut::expect( ut::that % image.root().get_child("a")->get_child("g")->get_child("x")->value()=="1"sv );
+    ut::expect( ut::that % image.root().get_child("b")->get_child("g")->get_child("x")->value()=="1"sv );
+   };
+
+ut::test("corrupted json images") = []
+   {
+    json::Node root;
+    root.ensure_child("a").set_value("1");
+    const std::string image = json::compile_image(root);
+    ut::expect( ut::throws([]{ json::Image img("not an image"sv); }) );
+    ut::expect( ut::throws([&image]{ json::Image img( std::string_view{image}.substr(0, image.size()-1) ); }) ) << "truncated\n";
+    std::string corrupted{image};
+    corrupted[json::image_layout::nodes_offset + 16] = '\x7f'; // First child of root
+    ut::expect( ut::throws([&corrupted]{ json::Image img(corrupted); }) );
+   };
+
+};///////////////////////////////////////////////////////////////////////////
+#endif // TEST_UNITS ////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
@@ -3,12 +3,18 @@
 //  Parses my special json format adopted for
 //  parameters overlays
 //  ---------------------------------------------
-//  #include "json_parser.hpp" // json::Parser
+//  #include "json_parser.hpp" // json::Parser, json::parse(), json::parse_tree(), json::LazyRoot
 //  ---------------------------------------------
 #include <vector>
+#include <optional>
+#include <algorithm> // std::ranges::count_if, std::ranges::find, std::ranges::sort, std::ranges::unique
+#include <functional> // std::hash
+#include <concepts> // std::predicate
 
 #include "plain_parser_base.hpp" // plain::ParserBase
 #include "json_node.hpp" // json::Node
+#include "json_structural_index.hpp" // json::StructuralIndex
+#include "json_tree.hpp" // json::Tree
 
 
 //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
@@ -19,13 +25,125 @@ namespace json //::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 /////////////////////////////////////////////////////////////////////////////
 class Parser final : public plain::ParserBase<char>
 {              using base = plain::ParserBase<char>;
+ public:
+    // A first level entry, located but not parsed
+    struct entry_t final
+       {
+        std::vector<std::string_view> keys;
+        context_t start; // Inside the block or at the value
+        std::string_view content; // Up to the closing brace or the end of the value
+        bool is_block;
+       };
+
+ private:
+    std::vector<std::string_view> m_keys; // Stack of the keys of the nested blocks, reused
+    std::string_view m_text; // Same of base
+    std::optional<StructuralIndex> m_own_index;
+    const StructuralIndex* m_index;
+    std::size_t m_index_hint = 0; // Last used position in the index
+
  public:
     Parser(const std::string_view buf)
       : base(buf)
+      , m_text{buf}
+      , m_own_index{std::in_place, buf}
+      , m_index{&*m_own_index}
+       {}
+
+    // Sharing the index of the same buffer
+    Parser(const std::string_view buf, const StructuralIndex& index)
+      : base(buf)
+      , m_text{buf}
+      , m_index{&index}
        {}
 
     //-----------------------------------------------------------------------
-    void collect_childs_of(Node& n_parent, const int nest_lvl =0, const std::size_t line_start =1)
+    // Locate the first level entries just matching the braces
+    [[nodiscard]] std::vector<entry_t> scan_entries()
+       {
+        std::vector<entry_t> entries;
+        while( true )
+           {
+            base::skip_any_space();
+            if( not base::has_codepoint() )
+               {
+                break;
+               }
+            else if( skip_possible_comment() )
+               {
+               }
+            else if( got_sep() )
+               {
+                base::get_next();
+               }
+            else if( base::got('}') )
+               {
+                throw base::create_parse_error("Unexpected '}' at first level");
+               }
+            else
+               {
+                entry_t& entry = entries.emplace_back();
+                const std::size_t keys_count = extract_keys();
+                entry.keys.assign(m_keys.end() - static_cast<std::ptrdiff_t>(keys_count), m_keys.end());
+                m_keys.clear();
+
+                const char keyval_sep = base::curr_codepoint();
+                if( not ascii::is_any_of<':','='>(keyval_sep) )
+                   {
+                    throw base::create_parse_error(std::format("Invalid separator '{}' after key \"{}\"", str::escape(keyval_sep), entry.keys.back()));
+                   }
+                base::get_next();
+                base::skip_any_space();
+                if( skip_possible_comment() )
+                   {
+                    base::skip_any_space();
+                   }
+
+                if( not base::has_codepoint() )
+                   {
+                    throw base::create_parse_error( std::format("Missing value of key \"{}\"", entry.keys.back()) );
+                   }
+                else if( base::got('{') )
+                   {
+                    if( keyval_sep!=':' )
+                       {
+                        throw base::create_parse_error(std::format("Key \"{}\" must be followed by ':' and not by '{}'", entry.keys.back(), keyval_sep));
+                       }
+                    base::get_next();
+                    entry.start = base::save_context();
+                    entry.is_block = true;
+                    skip_block();
+                   }
+                else
+                   {
+                    if( entry.keys.size()>1 )
+                       {
+                        throw base::create_parse_error("A value cannot have multiple keys");
+                       }
+                    entry.start = base::save_context();
+                    entry.is_block = false;
+                    std::ignore = extract_value();
+                   }
+                entry.content = base::get_view_between(entry.start.offset, base::curr_offset());
+               }
+           }
+        return entries;
+       }
+
+    //-----------------------------------------------------------------------
+    // Parse a first level entry found by scan_entries()
+    template<typename NODE>
+    void collect_entry(const entry_t& entry, NODE& node)
+       {
+        base::restore_context(entry.start);
+        if( entry.is_block ) collect_childs_of(node, 1, entry.start.line);
+        else node.set_value( extract_value() );
+       }
+
+    //-----------------------------------------------------------------------
+    // NODE can be a json::Node or a json::Tree::Builder::NodeRef
+    template<typename NODE>
+    void collect_childs_of(NODE& n_parent, const int nest_lvl =0, const std::size_t line_start =1)
        {
         while( true )
            {
@@ -49,15 +167,17 @@ class Parser final : public plain::ParserBase<char>
             else
                {
                 // Here expecting one or more keys
-                const auto keys = extract_keys();
-                assert( not keys.empty() );
+                const std::size_t keys_start = m_keys.size();
+                const std::size_t keys_count = extract_keys();
+                assert( keys_count>0 );
+                const std::string_view last_key = m_keys.back();
 
                 // Get key/value separator
                 assert( not base::got_space() );
                 const char keyval_sep = base::curr_codepoint();
                 if( not ascii::is_any_of<':','='>(keyval_sep) )
                    {
-                    throw base::create_parse_error(std::format("Invalid separator '{}' after key \"{}\"", str::escape(keyval_sep), keys.back()));
+                    throw base::create_parse_error(std::format("Invalid separator '{}' after key \"{}\"", str::escape(keyval_sep), last_key));
                    }
                 base::get_next();
 
@@ -71,7 +191,7 @@ class Parser final : public plain::ParserBase<char>
                 // Now expecting a value or further child block
                 if( not base::has_codepoint() )
                    {
-                    throw base::create_parse_error( std::format("Missing value of key \"{}\"", keys.back()) );
+                    throw base::create_parse_error( std::format("Missing value of key \"{}\"", last_key) );
                    }
                 else if( base::got('{') )
                    {// Collect child block
@@ -80,36 +200,37 @@ class Parser final : public plain::ParserBase<char>
                     // In this case I strictly enforce a colon
                     if( keyval_sep!=':' )
                        {
-                        throw base::create_parse_error(std::format("Key \"{}\" must be followed by ':' and not by '{}'", keys.back(), keyval_sep));
+                        throw base::create_parse_error(std::format("Key \"{}\" must be followed by ':' and not by '{}'", last_key, keyval_sep));
                        }
 
-                    if( keys.size()>1 )
+                    if( keys_count>1 )
                        {// I'll ensure a child for each key
-                        Node n_tmp; // An empty bag to collect just this block
+                        auto n_tmp = detached_like(n_parent); // An empty bag to collect just this block
                         collect_childs_of(n_tmp, nest_lvl+1, base::curr_line());
 
                         // Copy retrieved child block to all keys
-                        for( const auto& key : keys )
+                        for( std::size_t i=keys_start; i<keys_start+keys_count; ++i )
                            {
-                            Node& n_child = n_parent.ensure_child( key );
+                            auto&& n_child = n_parent.ensure_child( m_keys[i] );
                             n_child.insert_childs_of(n_tmp);
                            }
                        }
                     else
                        {
-                        Node& child = n_parent.ensure_child( keys.front() );
+                        auto&& child = n_parent.ensure_child( m_keys[keys_start] );
                         collect_childs_of(child, nest_lvl+1, base::curr_line());
                        }
                    }
                 else
                    {// A single value
-                    if( keys.size()>1 )
+                    if( keys_count>1 )
                        {
                         throw base::create_parse_error("A value cannot have multiple keys");
                        }
-                    Node& child = n_parent.ensure_child( keys.front() );
+                    auto&& child = n_parent.ensure_child( m_keys[keys_start] );
                     child.set_value( extract_value() );
                    }
+                m_keys.resize(keys_start);
                }
            }
 
@@ -122,6 +243,45 @@ class Parser final : public plain::ParserBase<char>
 
 
  private:
+    [[nodiscard]] static Node detached_like(const Node&) { return Node{}; }
+    template<typename NODE>
+    [[nodiscard]] static NODE detached_like(const NODE& n) { return n.new_detached(); }
+
+
+    //-----------------------------------------------------------------------
+    // Skip until the brace closing the current block, minding
+    // comments and quoted strings that could contain braces
+    void skip_block()
+       {
+        const std::size_t line_start = base::curr_line();
+        int depth = 1;
+        while( skip_to_structural(ascii::is_any_of<'{','}','\"','/'>) )
+           {
+            if( skip_possible_comment() )
+               {
+                continue;
+               }
+            if( base::got('\"') )
+               {
+                base::get_next();
+                skip_to_structural(ascii::is_any_of<'\"','\n'>);
+               }
+            else if( base::got('{') )
+               {
+                ++depth;
+               }
+            else if( base::got('}') and --depth==0 )
+               {
+                base::get_next();
+                return;
+               }
+            base::get_next();
+           }
+        throw base::create_parse_error( std::format("Unclosed block (nesting level={}) opened at line {}", depth, line_start) );
+       }
+
+
+    //-----------------------------------------------------------------------
     [[nodiscard]] static constexpr bool is_special_char(const char c) noexcept
        {
         return ascii::is_any_of<':','{','}',',',';','='>(c);
@@ -140,18 +300,77 @@ class Parser final : public plain::ParserBase<char>
        {
         if( base::eat("//") )
            {// Skip line comment
-            base::skip_line();
+            skip_to_structural(ascii::is_endline<char>);
+            base::get_next();
             return true;
            }
         else if( base::eat("/*") )
            {// Skip block comment
-            [[maybe_unused]] auto cmt = base::get_until("*/");
-            return true;
+            const auto start = base::save_context();
+            while( skip_to_structural(ascii::is<'/'>) )
+               {
+                const bool closing = base::curr_offset()>start.offset and m_text[base::curr_offset()-1]=='*';
+                base::get_next();
+                if( closing ) return true;
+               }
+            base::restore_context( start );
+            throw base::create_parse_error(std::format("Unclosed content (\"{}\" not found)","*/"sv), start.line);
+           }
+        return false;
+       }
+
+
+    //-----------------------------------------------------------------------
+    // Jump to the next structural character satisfying the predicate,
+    // or to the end if none. The others are just passed, counting lines
+    template<std::predicate<const char> CodepointPredicate>
+    bool skip_to_structural(CodepointPredicate is) noexcept
+       {
+        std::size_t lines = 0;
+        for( std::size_t i=m_index->first_from(base::curr_offset(), m_index_hint); i<m_index->size(); ++i )
+           {
+            const std::size_t pos = (*m_index)[i];
+            const char c = m_text[pos];
+            if( is(c) )
+               {
+                m_index_hint = i;
+                base::jump_to(pos, lines);
+                return true;
+               }
+            if( c=='\n' ) ++lines;
            }
+        m_index_hint = m_index->size();
+        base::jump_to(m_text.size(), lines);
         return false;
        }
 
 
+    //-----------------------------------------------------------------------
+    // Content of a quoted string, the closing quote should come before
+    // any unexpected character (that must be structural)
+    template<std::predicate<const char> CodepointPredicate>
+    [[nodiscard]] std::string_view get_quoted(CodepointPredicate is_unexpected)
+       {
+        assert( base::got('\"') );
+        base::get_next();
+        const auto start = base::save_context();
+        if( skip_to_structural([&is_unexpected](const char c) noexcept { return c=='\"' or is_unexpected(c); }) )
+           {
+            if( base::got('\"') )
+               {
+                const std::string_view content = base::get_view_between(start.offset, base::curr_offset());
+                base::get_next();
+                return content;
+               }
+            const char offending_codepoint = base::curr_codepoint();
+            base::restore_context( start ); // Strong guarantee
+            throw base::create_parse_error( std::format("Unexpected character '{}'"sv, str::escape(offending_codepoint)) );
+           }
+        base::restore_context( start ); // Strong guarantee
+        throw base::create_parse_error( "Unexpected end (termination not found)" );
+       }
+
+
     //-----------------------------------------------------------------------
     // Extract a (possibly quoted) string. Ensures not empty
     [[nodiscard]] std::string_view extract_key()
@@ -165,9 +384,7 @@ class Parser final : public plain::ParserBase<char>
 
             [[nodiscard]] static std::string_view get_quoted_key(json::Parser& parser)
                {
-                assert( parser.got('\"') );
-                parser.get_next();
-                return parser.get_until_and_skip(ascii::is<'\"'>, local::is_unexpected);
+                return parser.get_quoted(local::is_unexpected);
                }
 
             [[nodiscard]] static std::string_view get_unquoted_key(json::Parser& parser)
@@ -191,21 +408,22 @@ class Parser final : public plain::ParserBase<char>
 
 
     //-----------------------------------------------------------------------
-    [[nodiscard]] std::vector<std::string_view> extract_keys()
+    // Pushes the keys in the stack, returning how many
+    [[nodiscard]] std::size_t extract_keys()
        {
-        std::vector<std::string_view> keys;
-
-        keys.push_back( extract_key() );
+        std::size_t count = 1;
+        m_keys.push_back( extract_key() );
 
         // Extension: Support multiple keys (comma separated)
         while( base::got(',') )
            {
             base::get_next();
             base::skip_any_space(); // Possible spaces after comma
-            keys.push_back( extract_key() );
+            m_keys.push_back( extract_key() );
+            ++count;
            }
 
-        return keys;
+        return count;
        }
 
 
@@ -217,9 +435,7 @@ class Parser final : public plain::ParserBase<char>
            {
             [[nodiscard]] static std::string_view get_quoted_val(json::Parser& parser)
                {
-                assert( parser.got('\"') );
-                parser.get_next();
-                return parser.get_until_and_skip(ascii::is<'\"'>, ascii::is_any_of<'\n',cend>);
+                return parser.get_quoted(ascii::is_any_of<'\n',cend>);
                }
 
             [[nodiscard]] static constexpr bool is_end(const char c) noexcept
@@ -246,7 +462,8 @@ class Parser final : public plain::ParserBase<char>
 
 //---------------------------------------------------------------------------
 // Parse json file
-void parse(const std::string& file_path, const std::string_view buf, Node& root, fnotify_t const& notify_issue)
+template<typename NODE>
+void parse(const std::string& file_path, const std::string_view buf, NODE& root, fnotify_t const& notify_issue)
 {
     Parser parser(buf);
     parser.set_on_notify_issue(notify_issue);
@@ -266,12 +483,160 @@ void parse(const std::string& file_path, const std::string_view buf, Node& root,
 }
 
 
+//---------------------------------------------------------------------------
+// Parse json content to a tree that refers to it
+[[nodiscard]] Tree parse_tree(const std::string& file_path, const std::string_view buf, fnotify_t const& notify_issue)
+{
+    // Roughly a node per key, to avoid reallocations
+    const auto keys_count = std::ranges::count_if(buf, [](const char c){ return c==':' or c=='='; });
+    Tree::Builder builder( static_cast<std::size_t>(keys_count) + 1 );
+    auto root = builder.root();
+    parse(file_path, buf, root, notify_issue);
+    return builder.build();
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// The first level entries of a json content, located with a quick
+// scan, so that later just the ones of a given key are parsed
+class LazyRoot final
+{
+ private:
+    std::string m_file_path;
+    std::string_view m_buf; // Must outlive this
+    StructuralIndex m_index;
+    std::vector<Parser::entry_t> m_entries;
+    std::vector<std::string_view> m_keys; // Distinct and sorted
+
+ public:
+    explicit LazyRoot(const std::string& file_path, const std::string_view buf)
+      : m_file_path{file_path}
+      , m_buf{buf}
+      , m_index{buf}
+       {
+        Parser parser(m_buf, m_index);
+        parser.set_file_path(m_file_path);
+        m_entries = parser.scan_entries();
+        for( const auto& entry : m_entries )
+           {
+            m_keys.insert(m_keys.end(), entry.keys.begin(), entry.keys.end());
+           }
+        std::ranges::sort(m_keys);
+        const auto [dup_begin, dup_end] = std::ranges::unique(m_keys);
+        m_keys.erase(dup_begin, dup_end);
+       }
+
+    [[nodiscard]] std::size_t keys_count() const noexcept { return m_keys.size(); }
+    [[nodiscard]] const std::vector<std::string_view>& keys() const noexcept { return m_keys; }
+
+    //-----------------------------------------------------------------------
+    // Of the content of all the entries of a key, a quick check to recognize
+    // without parsing the keys whose content didn't change, to be confirmed
+    // comparing their contents_of()
+    [[nodiscard]] std::size_t hash_of(const std::string_view key) const noexcept
+       {
+        std::size_t hash = 0;
+        for( const auto& entry : m_entries )
+           {
+            if( std::ranges::find(entry.keys, key)!=entry.keys.end() )
+               {
+                hash ^= std::hash<std::string_view>{}(entry.content) + 0x9E3779B97F4A7C15u + (hash << 6) + (hash >> 2);
+               }
+           }
+        return hash;
+       }
+
+    //-----------------------------------------------------------------------
+    // The contents of all the entries of a key, in order
+    [[nodiscard]] std::vector<std::string_view> contents_of(const std::string_view key) const
+       {
+        std::vector<std::string_view> contents;
+        for( const auto& entry : m_entries )
+           {
+            if( std::ranges::find(entry.keys, key)!=entry.keys.end() )
+               {
+                contents.push_back(entry.content);
+               }
+           }
+        return contents;
+       }
+
+    //-----------------------------------------------------------------------
+    // All the first level keys, but just the given one with its content
+    [[nodiscard]] Tree tree_of(const std::string_view key, fnotify_t const& notify_issue) const
+       {
+        Tree::Builder builder(m_keys.size() + 1);
+        auto root = builder.root();
+        for( const auto k : m_keys )
+           {
+            std::ignore = root.ensure_child(k);
+           }
+
+        Parser parser(m_buf, m_index);
+        parser.set_on_notify_issue(notify_issue);
+        parser.set_file_path(m_file_path);
+        try{
+            for( const auto& entry : m_entries )
+               {
+                if( std::ranges::find(entry.keys, key)==entry.keys.end() )
+                   {
+                    continue;
+                   }
+                if( entry.keys.size()>1 )
+                   {// Same merge of a block shared by multiple keys
+                    auto n_tmp = root.new_detached();
+                    parser.collect_entry(entry, n_tmp);
+                    root.ensure_child(key).insert_childs_of(n_tmp);
+                   }
+                else
+                   {
+                    auto child = root.ensure_child(key);
+                    parser.collect_entry(entry, child);
+                   }
+               }
+           }
+        catch( parse::error& )
+           {
+            throw;
+           }
+        catch( std::exception& e )
+           {
+            throw parser.create_parse_error(e.what());
+           }
+        return builder.build();
+       }
+};
+
+
 }//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 
 
 
 
 
+/////////////////////////////////////////////////////////////////////////////
+#if defined(TEST_UNITS) or defined(TEST_BENCHMARKS) /////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+// Blocks with comments, quoted strings and nested blocks
+[[nodiscard]] std::string json_generated_db(const std::size_t min_size)
+   {
+    std::string buf;
+    for( int i=0; buf.size()<min_size; ++i )
+       {
+        buf += std::format("// Block {}\n"
+                           "\"F{}\", \"G{}\" :\n"
+                           "   {{\n"
+                           "    \"common\" : {{ Name = \"A quoted value {{}}\", Num: {} }} /* a comment\n"
+                           "                  on more lines */\n"
+                           "    \"axes\" : {{ \"Xr\", \"Ysup\" : {{ MaxPos = {}, MinPos = -{} }} }}\n"
+                           "   }}\n", i, i, i, i, i, i);
+       }
+    return buf;
+   }
+#endif //////////////////////////////////////////////////////////////////////
+
+
+
 /////////////////////////////////////////////////////////////////////////////
 #ifdef TEST_UNITS ///////////////////////////////////////////////////////////
 /////////////////////////////////////////////////////////////////////////////
@@ -359,8 +724,132 @@ ut::test("json::parse()") = []
                                            "c:{d:{common:val},e:{common:val}},"
                                            "n0:{n1:{n1-0:{key1:{nam1:val1,nam2:val2},key2:{nam1:val1,nam2:val2}}},"
                                                "n2:{n2-0:{nam3:val3},nam4:val4,nam5:val5}}}"sv );
+
+    try{
+        struct issues_t final { int num=0; void operator()(std::string&& msg) noexcept {++num; ut::log << msg << '\n';}; } issues;
+        const json::Tree tree = json::parse_tree("test", buf, std::ref(issues));
+        ut::expect( ut::that % tree.root().string()==root.string() ) << "tree should be the same\n";
+        ut::expect( ut::that % tree.nodes_count()==19u ) << "multiple keys should share their block\n";
+       }
+    catch( parse::error& e )
+       {
+        ut::expect(false) << std::format("Exception: {} (line {})\n", e.what(), e.line());
+       }
+   };
+
+
+ut::test("json::parse() error lines") = []
+   {
+    const auto error_of = [](const std::string_view buf) -> std::string
+       {
+        try{
+            json::Node root;
+            json::parse("test", buf, root, [](std::string&&){});
+           }
+        catch( parse::error& e )
+           {
+            return std::format("{}:{}", e.line(), e.what());
+           }
+        return {};
+       };
+
+    ut::expect( ut::that % error_of("a: {\n /* unclosed\n comment \n"sv)=="2:Unclosed content (\"*/\" not found)"sv );
+    ut::expect( ut::that % error_of("a: {\n b: \"unterminated\n}\n"sv)=="2:Unexpected character '\\n'"sv );
+    ut::expect( ut::that % error_of("a: {\n \"k:ey\": 1 }"sv)=="2:Unexpected character ':'"sv );
+    ut::expect( ut::that % error_of("// c {\n/* x\n y */ a: {\n b: 1\n"sv)=="5:Unclosed block (nesting level=1) opened at line 3"sv );
+    ut::expect( ut::that % error_of("a: { b: \"x/*\" // }\n c: \"/\" }\nd: \"unterminated"sv)=="3:Unexpected end (termination not found)"sv );
+    ut::expect( ut::that % error_of("a: {\n b: 1 /**/ c: 2 /*/ \n*/ d: 3 }\n e = 4 f: {}\n\n g"sv)=="6:Invalid separator '\\0' after key \"g\""sv );
+   };
+
+ut::test("json::Parser generated blocks") = []
+   {
+    const std::string buf = json_generated_db(64u*1024u);
+    const json::Tree tree = json::parse_tree("test", buf, [](std::string&&){ ut::expect(false) << "no issues expected\n"; });
+    const json::LazyRoot lazy("test", buf);
+    ut::expect( ut::that % lazy.keys_count()==tree.root().childs().size() );
+    ut::expect( lazy.keys_count()%2u==0u ) << "two keys per block\n";
+    ut::expect( json::StructuralIndex(buf).positions()==json::StructuralIndex(buf, json::StructuralIndex::scan::scalar).positions() );
+    ut::expect( ut::that % tree.root().get_child("G7"sv)->get_child("axes"sv)->get_child("Ysup"sv)->get_child("MinPos"sv)->value()=="-7"sv );
+   };
+
+ut::test("json::LazyRoot") = []
+   {
+    const std::string_view buf =
+        "a,b : { x: 1, y: \"}\" } // comment }\n"
+        "c: { wrong = { } }\n"
+        "a: { z: { w = 2 } }\n"
+        "d = 3\n"sv;
+
+    try{
+        struct issues_t final { int num=0; void operator()(std::string&& msg) noexcept {++num; ut::log << msg << '\n';}; } issues;
+        const json::LazyRoot lazy("test", buf);
+        ut::expect( ut::that % lazy.keys_count()==4u );
+
+        const json::Tree tree_a = lazy.tree_of("a"sv, std::ref(issues));
+        ut::expect( ut::that % tree_a.root().get_child("a"sv)->string()=="{x:1,y:},z:{w:2}}"sv );
+        ut::expect( ut::that % tree_a.root().childs().size()==4u ) << "all first level keys should be present\n";
+        ut::expect( not tree_a.root().get_child("b"sv)->has_childs() ) << "other keys shouldn't be parsed\n";
+
+        const json::Tree tree_d = lazy.tree_of("d"sv, std::ref(issues));
+        ut::expect( ut::that % tree_d.root().get_child("d"sv)->value()=="3"sv );
+        ut::expect( ut::that % issues.num==0 ) << "no issues expected\n";
+       }
+    catch( parse::error& e )
+       {
+        ut::expect(false) << std::format("Exception: {} (line {})\n", e.what(), e.line());
+       }
+
+    const std::string_view edited_buf =
+        "a,b : { x: 1, y: \"}\" } // edited comment }\n"
+        "c: { wrong = { } }\n"
+        "\n"
+        "a: { z: { w = 3 } }\n"
+        "d = 3\n"sv;
+    const json::LazyRoot lazy("test", buf);
+    const json::LazyRoot edited_lazy("test", edited_buf);
+    ut::expect( ut::that % edited_lazy.hash_of("a"sv)!=lazy.hash_of("a"sv) ) << "changed content should change the hash\n";
+    for( const auto key : {"b"sv, "c"sv, "d"sv} )
+       {
+        ut::expect( ut::that % edited_lazy.hash_of(key)==lazy.hash_of(key) ) << key << " content didn't change\n";
+        ut::expect( edited_lazy.contents_of(key)==lazy.contents_of(key) ) << key << " content didn't change\n";
+       }
+    ut::expect( edited_lazy.contents_of("a"sv)!=lazy.contents_of("a"sv) );
+    ut::expect( ut::that % lazy.contents_of("a"sv).size()==2u ) << "a has two blocks\n";
+
+    ut::expect( ut::throws([]{ std::ignore = json::LazyRoot("test", "a:{ b:{ }\n"sv); }) ) << "unclosed block should be detected\n";
+    ut::expect( ut::throws([buf]{ std::ignore = json::LazyRoot("test", buf).tree_of("c"sv, [](std::string&&){}); }) ) << "error in parsed block should be detected\n";
    };
 
 };///////////////////////////////////////////////////////////////////////////
 #endif // TEST_UNITS ////////////////////////////////////////////////////////
 /////////////////////////////////////////////////////////////////////////////
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+#ifdef TEST_BENCHMARKS //////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+static ut::suite<"json_parser_benchmarks"> json_parser_benchmarks = []
+{////////////////////////////////////////////////////////////////////////////
+
+ut::test("json::Parser throughput") = []
+   {
+    const std::string buf = json_generated_db(1u<<20);
+    const auto mb_per_s = [size=buf.size()](const auto& fn) -> double
+       {
+        constexpr std::size_t reps = 3;
+        return (reps * static_cast<double>(size) / (1024.0*1024.0)) / test::seconds_taken(reps, fn);
+       };
+
+    std::size_t count = 0;
+    const double index_simd = mb_per_s([&]{ count = json::StructuralIndex(buf).size(); });
+    const double index_scalar = mb_per_s([&]{ ut::expect( json::StructuralIndex(buf, json::StructuralIndex::scan::scalar).size()==count ); });
+    const double tree = mb_per_s([&]{ count = json::parse_tree("bench", buf, [](std::string&&){}).nodes_count(); });
+    const double lazy = mb_per_s([&]{ count = json::LazyRoot("bench", buf).keys_count(); });
+    ut::log << std::format("{} KiB: index {:.0f} MiB/s (scalar {:.0f}), full parse {:.0f} MiB/s, lazy scan {:.0f} MiB/s\n", buf.size()/1024, index_simd, index_scalar, tree, lazy);
+    ut::expect( ut::that % count>0u );
+   };
+
+};///////////////////////////////////////////////////////////////////////////
+#endif // TEST_BENCHMARKS ///////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,179 @@
+﻿#pragma once
+//  ---------------------------------------------
+//  Positions of the structural characters of a
+//  json buffer, found in bulk with SIMD
+//  ---------------------------------------------
+//  #include "json_structural_index.hpp" // json::StructuralIndex
+//  ---------------------------------------------
+#include <cstdint> // std::uint8_t, std::uint32_t
+#include <string_view>
+#include <vector>
+#include <limits> // std::numeric_limits
+#include <bit> // std::countr_zero
+#include <algorithm> // std::lower_bound
+#include <stdexcept> // std::runtime_error
+
+#include "ascii_predicates.hpp" // ascii::is_any_of
+
+#if defined(__AVX2__)
+  #include <immintrin.h> // _mm256_*
+#elif defined(__SSE2__) or defined(_M_X64)
+  #include <emmintrin.h> // _mm_*
+#endif
+
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+namespace json //::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+/////////////////////////////////////////////////////////////////////////////
+// The ascending offsets of the characters that a parser needs to stop at
+// when skipping comments, quoted strings and whole blocks. The line breaks
+// are included, so the lines of the skipped content can be counted, and
+// also the nul characters, that the parser treats as unexpected
+class StructuralIndex final
+{
+ public:
+    enum class scan : std::uint8_t { vectorized, scalar };
+
+ private:
+    std::vector<std::uint32_t> m_positions;
+
+ public:
+    explicit StructuralIndex(const std::string_view buf, const scan mode =scan::vectorized)
+       {
+        if( buf.size() > std::numeric_limits<std::uint32_t>::max() )
+           {
+            throw std::runtime_error("Content too big to be indexed");
+           }
+        m_positions.reserve(buf.size()/8);
+        const std::size_t scanned = mode==scan::vectorized ? add_vectorized(buf) : 0;
+        add_scalar(buf, scanned);
+       }
+
+    [[nodiscard]] static constexpr bool is_structural(const char c) noexcept
+       {
+        return ascii::is_any_of<'{','}',':','=',',',';','\"','\n','/','\0'>(c);
+       }
+
+    [[nodiscard]] std::size_t size() const noexcept { return m_positions.size(); }
+    [[nodiscard]] std::size_t operator[](const std::size_t i) const noexcept { return m_positions[i]; }
+    [[nodiscard]] const std::vector<std::uint32_t>& positions() const noexcept { return m_positions; }
+
+    //-----------------------------------------------------------------------
+    // Index of the first position not before offset, searching from
+    // a previous result when going forward as usual
+    [[nodiscard]] std::size_t first_from(const std::size_t offset, std::size_t hint =0) const noexcept
+       {
+        if( hint>m_positions.size() or (hint>0 and m_positions[hint-1]>=offset) )
+           {
+            hint = 0; // Went back
+           }
+        // Usually the next one is near
+        const std::size_t linear_end = std::min(hint+8, m_positions.size());
+        while( hint<linear_end )
+           {
+            if( m_positions[hint]>=offset ) return hint;
+            ++hint;
+           }
+        return static_cast<std::size_t>(std::lower_bound(m_positions.begin() + static_cast<std::ptrdiff_t>(hint), m_positions.end(), offset) - m_positions.begin());
+       }
+
+ private:
+    //-----------------------------------------------------------------------
+    void add_scalar(const std::string_view buf, const std::size_t start)
+       {
+        for( std::size_t i=start; i<buf.size(); ++i )
+           {
+            if( is_structural(buf[i]) ) m_positions.push_back( static_cast<std::uint32_t>(i) );
+           }
+       }
+
+    //-----------------------------------------------------------------------
+    void add_mask_bits(std::uint32_t mask, const std::size_t base_offset)
+       {
+        while( mask!=0 )
+           {
+            m_positions.push_back( static_cast<std::uint32_t>(base_offset + static_cast<std::size_t>(std::countr_zero(mask))) );
+            mask &= mask - 1; // Clear lowest bit
+           }
+       }
+
+    //-----------------------------------------------------------------------
+    // Returns the scanned size, the rest is left to add_scalar()
+    [[nodiscard]] std::size_t add_vectorized([[maybe_unused]] const std::string_view buf)
+       {
+      #if defined(__AVX2__)
+        constexpr std::size_t chunk_size = 32;
+        std::size_t i = 0;
+        for( ; i+chunk_size<=buf.size(); i+=chunk_size )
+           {
+            const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(buf.data() + i));
+            const auto eq = [chunk](const char c) noexcept { return _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(c)); };
+            const __m256i hits = _mm256_or_si256( _mm256_or_si256(_mm256_or_si256(eq('{'), eq('}')), _mm256_or_si256(eq(':'), eq('='))),
+                                                  _mm256_or_si256(_mm256_or_si256(_mm256_or_si256(eq(','), eq(';')), _mm256_or_si256(eq('\"'), eq('\n'))),
+                                                                  _mm256_or_si256(eq('/'), eq('\0'))) );
+            add_mask_bits(static_cast<std::uint32_t>(_mm256_movemask_epi8(hits)), i);
+           }
+        return i;
+      #elif defined(__SSE2__) or defined(_M_X64)
+        constexpr std::size_t chunk_size = 16;
+        std::size_t i = 0;
+        for( ; i+chunk_size<=buf.size(); i+=chunk_size )
+           {
+            const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf.data() + i));
+            const auto eq = [chunk](const char c) noexcept { return _mm_cmpeq_epi8(chunk, _mm_set1_epi8(c)); };
+            const __m128i hits = _mm_or_si128( _mm_or_si128(_mm_or_si128(eq('{'), eq('}')), _mm_or_si128(eq(':'), eq('='))),
+                                               _mm_or_si128(_mm_or_si128(_mm_or_si128(eq(','), eq(';')), _mm_or_si128(eq('\"'), eq('\n'))),
+                                                            _mm_or_si128(eq('/'), eq('\0'))) );
+            add_mask_bits(static_cast<std::uint32_t>(_mm_movemask_epi8(hits)), i);
+           }
+        return i;
+      #else
+        return 0;
+      #endif
+       }
+};
+
+}//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+#ifdef TEST_UNITS ///////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+static ut::suite<"json_structural_index"> json_structural_index_tests = []
+{////////////////////////////////////////////////////////////////////////////
+
+ut::test("json::StructuralIndex") = []
+   {
+    const std::string_view buf = "a:{b=1,c;\"d\"}\n// e\n{}  x"sv;
+    const json::StructuralIndex index(buf);
+    const std::vector<std::uint32_t> expected{1,2,4,6,8,9,11,12,13,14,15,18,19,20};
+    ut::expect( index.positions()==expected );
+    ut::expect( ut::that % index.first_from(0)==0u );
+    ut::expect( ut::that % index.first_from(3)==2u );
+    ut::expect( ut::that % index.first_from(14, 5)==9u );
+    ut::expect( ut::that % index.first_from(3, 9)==2u ) << "should go back\n";
+    ut::expect( ut::that % index.first_from(21, 3)==index.size() );
+   };
+
+ut::test("json::StructuralIndex same as scalar") = []
+   {
+    std::string buf;
+    for( int i=0; i<300; ++i ) // Not a multiple of the chunk size
+       {
+        buf += std::format("\"k{}\" : {{ v = {} /* c */ }},", i, i);
+        buf += static_cast<char>(i); // Also odd bytes
+       }
+    const json::StructuralIndex index(buf);
+    const json::StructuralIndex scalar_index(buf, json::StructuralIndex::scan::scalar);
+    ut::expect( ut::that % index.size()==scalar_index.size() );
+    ut::expect( index.positions()==scalar_index.positions() );
+    ut::expect( ut::that % json::StructuralIndex(""sv).size()==0u );
+   };
+
+};///////////////////////////////////////////////////////////////////////////
+#endif // TEST_UNITS ////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
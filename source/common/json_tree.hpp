@@ -0,0 +1,599 @@
+﻿#pragma once
+//  ---------------------------------------------
+//  A json tree whose nodes are stored in a
+//  single array, referring to the parsed buffer
+//  ---------------------------------------------
+//  #include "json_tree.hpp" // json::Tree
+//  ---------------------------------------------
+#include <cstdint> // std::uint32_t, std::uint64_t
+#include <string>
+#include <string_view>
+#include <vector>
+#include <optional>
+#include <utility> // std::pair
+#include <iterator> // std::input_iterator_tag
+#include <algorithm> // std::ranges::sort
+#include <functional> // std::hash
+#include <stdexcept> // std::runtime_error
+#include <format>
+
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+namespace json //::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+/////////////////////////////////////////////////////////////////////////////
+// Same read interface of json::Node, but keys and values are views
+// of the parsed buffer (that must outlive the tree) and the childs
+// of each node are contiguous and sorted by key. Being built once,
+// all the nodes take just one allocation. The childs of a block
+// with multiple keys are stored once and shared by those nodes
+class Tree final
+{
+ private:
+    struct node_t final
+       {
+        std::string_view key;
+        std::string_view value;
+        std::uint32_t first_child = 0;
+        std::uint32_t childs_count = 0;
+       };
+
+    std::vector<node_t> m_nodes; // The root is the first
+
+ public:
+    class Builder;
+
+    /////////////////////////////////////////////////////////////////////////
+    class NodeRef final
+    {
+     private:
+        const node_t* m_nodes = nullptr; // Whole tree
+        std::uint32_t m_idx = 0;
+
+     public:
+        /////////////////////////////////////////////////////////////////////
+        class childs_type final
+        {
+         public:
+            /////////////////////////////////////////////////////////////////
+            class iterator final
+            {
+             private:
+                const node_t* m_nodes;
+                std::uint32_t m_idx;
+
+             public:
+                using iterator_category = std::input_iterator_tag;
+                using value_type = std::pair<std::string_view, NodeRef>;
+                using difference_type = std::ptrdiff_t;
+
+                iterator(const node_t* const nodes, const std::uint32_t idx) noexcept
+                  : m_nodes{nodes}
+                  , m_idx{idx}
+                   {}
+
+                [[nodiscard]] value_type operator*() const noexcept { return { m_nodes[m_idx].key, NodeRef{m_nodes, m_idx} }; }
+                iterator& operator++() noexcept { ++m_idx; return *this; }
+                [[nodiscard]] bool operator==(const iterator& other) const noexcept { return m_idx==other.m_idx; }
+            };
+
+         private:
+            const node_t* m_nodes;
+            std::uint32_t m_first;
+            std::uint32_t m_count;
+
+         public:
+            explicit childs_type(const node_t* const nodes, const std::uint32_t first, const std::uint32_t count) noexcept
+              : m_nodes{nodes}
+              , m_first{first}
+              , m_count{count}
+               {}
+
+            [[nodiscard]] std::size_t size() const noexcept { return m_count; }
+            [[nodiscard]] bool empty() const noexcept { return m_count==0; }
+            [[nodiscard]] iterator begin() const noexcept { return {m_nodes, m_first}; }
+            [[nodiscard]] iterator end() const noexcept { return {m_nodes, m_first + m_count}; }
+        };
+
+     public:
+        NodeRef() noexcept = default;
+        explicit NodeRef(const node_t* const nodes, const std::uint32_t idx) noexcept
+          : m_nodes{nodes}
+          , m_idx{idx}
+           {}
+
+        [[nodiscard]] std::string_view key() const noexcept { return node().key; }
+        [[nodiscard]] std::string_view value() const noexcept { return node().value; }
+        [[nodiscard]] bool has_value() const noexcept { return not node().value.empty(); }
+        [[nodiscard]] bool has_childs() const noexcept { return node().childs_count>0; }
+        [[nodiscard]] bool is_leaf() const noexcept { return not has_childs() and has_value(); }
+        [[nodiscard]] childs_type childs() const noexcept { return childs_type{m_nodes, node().first_child, node().childs_count}; }
+        [[nodiscard]] std::uint32_t childs_id() const noexcept { return node().first_child; } // Same for shared childs
+
+        //-------------------------------------------------------------------
+        [[nodiscard]] std::optional<NodeRef> get_child(const std::string_view childname) const noexcept
+           {
+            std::uint32_t lo = node().first_child;
+            std::uint32_t hi = node().first_child + node().childs_count;
+            while( lo<hi )
+               {
+                const std::uint32_t mid = lo + (hi-lo)/2;
+                if( const auto cmp = m_nodes[mid].key.compare(childname); cmp<0 ) lo = mid+1;
+                else if( cmp>0 ) hi = mid;
+                else return NodeRef{m_nodes, mid};
+               }
+            return std::nullopt;
+           }
+
+        //-------------------------------------------------------------------
+        [[nodiscard]] std::size_t total_values_count() const noexcept
+           {
+            if( is_leaf() ) return 1;
+            std::size_t n = 0;
+            for( const auto& [key, child] : childs() )
+               {
+                n += child.total_values_count();
+               }
+            return n;
+           }
+
+        //-------------------------------------------------------------------
+        // Same format of json::Node::string()
+        [[nodiscard]] std::string string() const
+           {
+            std::string s{ value() };
+            if( has_childs() )
+               {
+                char sep = '{';
+                for( const auto& [key, child] : childs() )
+                   {
+                    s += sep;
+                    s += key;
+                    s += ':';
+                    s += child.string();
+                    sep = ',';
+                   }
+                s += '}';
+               }
+            return s;
+           }
+
+     private:
+        [[nodiscard]] const node_t& node() const noexcept { return m_nodes[m_idx]; }
+    };
+
+ public:
+    [[nodiscard]] NodeRef root() const noexcept { return NodeRef{m_nodes.data(), 0}; }
+    [[nodiscard]] std::size_t nodes_count() const noexcept { return m_nodes.size(); }
+};
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Collects the nodes in insertion order as linked lists, indexed
+// by parent and key with an open addressing table, then lays out
+// the tree breadth first. Offers the build interface of json::Node
+// used by json::Parser.
+// A block merged into an empty node is not copied: the node just
+// refers to it (alias), and gets its own copy of the first level
+// only when modified, where each child refers to the shared one
+class Tree::Builder final
+{
+ private:
+    static constexpr std::uint32_t npos = 0xFFFFFFFF;
+
+    struct bnode_t final
+       {
+        std::string_view key;
+        std::string_view value;
+        std::uint32_t parent = npos;
+        std::uint32_t first_child = npos;
+        std::uint32_t last_child = npos;
+        std::uint32_t next_sibling = npos;
+        std::uint32_t childs_count = 0;
+        std::uint32_t alias = npos; // Node whose childs are shared
+       };
+
+    std::vector<bnode_t> m_nodes; // The root is the first
+    std::vector<std::uint32_t> m_index; // Slots of node index+1 by (parent,key), 0 if empty
+    std::size_t m_indexed_count = 0;
+
+ public:
+    /////////////////////////////////////////////////////////////////////////
+    class NodeRef final
+    {
+     private:
+        Builder* m_builder;
+        std::uint32_t m_idx;
+
+     public:
+        explicit NodeRef(Builder* const builder, const std::uint32_t idx) noexcept
+          : m_builder{builder}
+          , m_idx{idx}
+           {}
+
+        [[nodiscard]] std::string_view value() const noexcept { return node().value; }
+        [[nodiscard]] bool has_value() const noexcept { return not node().value.empty(); }
+        [[nodiscard]] bool has_childs() const noexcept { return m_builder->childs_count_of(m_idx)>0; }
+        [[nodiscard]] bool is_leaf() const noexcept { return not has_childs() and has_value(); }
+
+        [[maybe_unused]] NodeRef ensure_child(const std::string_view key) { return NodeRef{m_builder, m_builder->ensure_child(m_idx, key)}; }
+        void set_value(const std::string_view newval) { m_builder->set_value(m_idx, newval); }
+        void insert_childs_of(const NodeRef& other) { m_builder->insert_childs_of(m_idx, other.m_idx); } // other shouldn't be modified after this
+
+        // Not reachable from the root, to collect a block to be merged elsewhere
+        [[nodiscard]] NodeRef new_detached() const { return NodeRef{m_builder, m_builder->add_node(npos, {})}; }
+
+     private:
+        [[nodiscard]] const bnode_t& node() const noexcept { return m_builder->m_nodes[m_idx]; }
+    };
+
+ public:
+    explicit Builder(const std::size_t expected_nodes =64)
+       {
+        m_nodes.reserve(expected_nodes);
+        m_index.resize( slots_count_for(expected_nodes) );
+        m_nodes.emplace_back(); // The root
+       }
+
+    [[nodiscard]] NodeRef root() noexcept { return NodeRef{this, 0}; }
+
+    //-----------------------------------------------------------------------
+    // Childs sorted by key like json::Node, numbered breadth first
+    [[nodiscard]] Tree build() const
+       {
+        Tree tree;
+        tree.m_nodes.reserve( m_nodes.size() );
+        std::vector<std::uint32_t> src_of; // Builder node of each tree node
+        src_of.reserve( m_nodes.size() );
+        std::vector<std::uint32_t> first_child_of(m_nodes.size(), npos); // Shared childs laid out once
+        std::vector<std::uint32_t> childs;
+
+        tree.m_nodes.push_back({ .key={}, .value=m_nodes[0].value, .first_child=0, .childs_count=0 });
+        src_of.push_back(0);
+        for( std::size_t i=0; i<tree.m_nodes.size(); ++i )
+           {
+            const std::uint32_t src = resolved(src_of[i]);
+            if( m_nodes[src].childs_count==0 ) continue;
+            tree.m_nodes[i].childs_count = m_nodes[src].childs_count;
+            if( first_child_of[src]!=npos )
+               {
+                tree.m_nodes[i].first_child = first_child_of[src];
+                continue;
+               }
+
+            childs.clear();
+            for( std::uint32_t c=m_nodes[src].first_child; c!=npos; c=m_nodes[c].next_sibling )
+               {
+                childs.push_back(c);
+               }
+            std::ranges::sort(childs, {}, [this](const std::uint32_t c){ return m_nodes[c].key; });
+
+            tree.m_nodes[i].first_child = first_child_of[src] = static_cast<std::uint32_t>(tree.m_nodes.size());
+            for( const std::uint32_t c : childs )
+               {
+                tree.m_nodes.push_back({ .key=m_nodes[c].key, .value=m_nodes[c].value, .first_child=0, .childs_count=0 });
+                src_of.push_back(c);
+               }
+           }
+        return tree;
+       }
+
+ private:
+    //-----------------------------------------------------------------------
+    // The node that actually holds the childs
+    [[nodiscard]] std::uint32_t resolved(std::uint32_t idx) const noexcept
+       {
+        while( m_nodes[idx].alias!=npos ) idx = m_nodes[idx].alias;
+        return idx;
+       }
+
+    //-----------------------------------------------------------------------
+    [[nodiscard]] std::uint32_t childs_count_of(const std::uint32_t idx) const noexcept
+       {
+        return m_nodes[resolved(idx)].childs_count;
+       }
+
+    //-----------------------------------------------------------------------
+    [[nodiscard]] static std::size_t slots_count_for(const std::size_t n) noexcept
+       {
+        std::size_t slots = 16;
+        while( slots < 2*n ) slots *= 2; // Load factor at most one half
+        return slots;
+       }
+
+    //-----------------------------------------------------------------------
+    [[nodiscard]] static std::size_t hash_of(const std::uint32_t parent, const std::string_view key) noexcept
+       {
+        return std::hash<std::string_view>{}(key) ^ (std::uint64_t{parent} * 0x9E3779B97F4A7C15u);
+       }
+
+    //-----------------------------------------------------------------------
+    [[nodiscard]] std::size_t slot_of(const std::uint32_t parent, const std::string_view key) const noexcept
+       {
+        const std::size_t mask = m_index.size() - 1;
+        std::size_t i = hash_of(parent, key) & mask;
+        while( m_index[i]!=0 )
+           {
+            const bnode_t& n = m_nodes[m_index[i]-1];
+            if( n.parent==parent and n.key==key ) break;
+            i = (i+1) & mask;
+           }
+        return i;
+       }
+
+    //-----------------------------------------------------------------------
+    [[nodiscard]] std::uint32_t find_child(const std::uint32_t parent, const std::string_view key) const noexcept
+       {
+        const std::uint32_t slot_val = m_index[slot_of(parent, key)];
+        return slot_val==0 ? npos : slot_val-1;
+       }
+
+    //-----------------------------------------------------------------------
+    void grow_index()
+       {
+        m_index.assign(m_index.size()*2, 0);
+        for( std::uint32_t i=1; i<m_nodes.size(); ++i )
+           {
+            if( m_nodes[i].parent!=npos ) // Detached nodes are not indexed, their childs are
+               {
+                m_index[slot_of(m_nodes[i].parent, m_nodes[i].key)] = i+1;
+               }
+           }
+       }
+
+    //-----------------------------------------------------------------------
+    [[nodiscard]] std::uint32_t add_node(const std::uint32_t parent, const std::string_view key)
+       {
+        const auto idx = static_cast<std::uint32_t>(m_nodes.size());
+        m_nodes.push_back({ .key=key, .value={}, .parent=parent });
+        if( parent!=npos )
+           {
+            bnode_t& p = m_nodes[parent];
+            if( p.last_child==npos ) p.first_child = idx;
+            else m_nodes[p.last_child].next_sibling = idx;
+            p.last_child = idx;
+            ++p.childs_count;
+
+            if( 2*(++m_indexed_count) > m_index.size() ) grow_index();
+            else m_index[slot_of(parent, key)] = idx+1;
+           }
+        return idx;
+       }
+
+    //-----------------------------------------------------------------------
+    [[nodiscard]] std::uint32_t ensure_child(const std::uint32_t parent, const std::string_view key)
+       {
+        unshare(parent);
+        if( const std::uint32_t idx = find_child(parent, key); idx!=npos )
+           {
+            return idx; // Already existing
+           }
+        return add_node(parent, key);
+       }
+
+    //-----------------------------------------------------------------------
+    void set_value(const std::uint32_t idx, const std::string_view newval)
+       {
+        bnode_t& n = m_nodes[idx];
+        if( childs_count_of(idx)>0 )
+           {
+            throw std::runtime_error( std::format("Cannot assign value \"{}\" to a parent node", newval) );
+           }
+        if( not n.value.empty() )
+           {
+            throw std::runtime_error( std::format("Cannot overwrite already existing value \"{}\" with \"{}\"", n.value, newval) );
+           }
+        n.value = newval;
+       }
+
+    //-----------------------------------------------------------------------
+    [[nodiscard]] bool is_leaf(const std::uint32_t idx) const noexcept
+       {
+        return childs_count_of(idx)==0 and not m_nodes[idx].value.empty();
+       }
+
+    //-----------------------------------------------------------------------
+    // Same checks of json::Node::insert_childs_of()
+    void insert_childs_of(const std::uint32_t dst, std::uint32_t src)
+       {
+        if( not m_nodes[dst].value.empty() )
+           {
+            throw std::runtime_error("Won't merge a value node");
+           }
+
+        src = resolved(src);
+        if( m_nodes[src].childs_count==0 )
+           {
+            return;
+           }
+        if( m_nodes[dst].childs_count==0 and m_nodes[dst].alias==npos )
+           {// Nothing to merge with, just share
+            m_nodes[dst].alias = src;
+            return;
+           }
+        unshare(dst);
+
+        for( std::uint32_t c=m_nodes[src].first_child; c!=npos; c=m_nodes[c].next_sibling )
+           {
+            const std::string_view key = m_nodes[c].key;
+            if( const std::uint32_t mine = find_child(dst, key); mine!=npos )
+               {// I already have this child!
+                if( is_leaf(mine) and is_leaf(c) )
+                   {
+                    if( m_nodes[mine].value != m_nodes[c].value )
+                       {
+                        throw std::runtime_error( std::format("Value conflict \"{}\": \"{}\" != \"{}\"", key, m_nodes[mine].value, m_nodes[c].value) );
+                       }
+                    else
+                       {
+                        throw std::runtime_error( std::format("Value \"{}:{}\" specified twice", key, m_nodes[c].value) );
+                       }
+                   }
+                else if( is_leaf(mine) )
+                   {
+                    throw std::runtime_error( std::format("Can't merge group \"{}\" with value \"{}\"", key, m_nodes[mine].value) );
+                   }
+                else if( is_leaf(c) )
+                   {
+                    throw std::runtime_error( std::format("Can't merge a value \"{}:{}\" with a group", key, m_nodes[c].value) );
+                   }
+                else
+                   {// Two groups, merge them
+                    insert_childs_of(mine, c);
+                   }
+               }
+            else
+               {// I don't already have this child
+                add_shared(c, dst);
+               }
+           }
+       }
+
+    //-----------------------------------------------------------------------
+    // A new child that refers to the childs of another node
+    void add_shared(const std::uint32_t src, const std::uint32_t parent)
+       {
+        const std::uint32_t idx = add_node(parent, m_nodes[src].key);
+        m_nodes[idx].value = m_nodes[src].value;
+        if( childs_count_of(src)>0 ) m_nodes[idx].alias = src;
+       }
+
+    //-----------------------------------------------------------------------
+    // Before modifying a node that shares its childs,
+    // give it its own first level, still sharing the rest
+    void unshare(const std::uint32_t idx)
+       {
+        if( m_nodes[idx].alias==npos )
+           {
+            return;
+           }
+        const std::uint32_t src = resolved(idx);
+        m_nodes[idx].alias = npos;
+        for( std::uint32_t c=m_nodes[src].first_child; c!=npos; c=m_nodes[c].next_sibling )
+           {
+            add_shared(c, idx);
+           }
+       }
+};
+
+}//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+#ifdef TEST_UNITS ///////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+static ut::suite<"json_tree"> json_tree_tests = []
+{////////////////////////////////////////////////////////////////////////////
+
+ut::test("json::Tree") = []
+   {
+    json::Tree::Builder builder;
+    auto root = builder.root();
+    auto c0 = root.ensure_child("c0");                         //   ┌b0┬b2=B2
+        c0.ensure_child("c1").ensure_child("c12").set_value("C12"); //   │  └b1=B1
+        c0.ensure_child("c1").ensure_child("c11").set_value("C11"); // ──┤     ┌c12=C12
+    auto b0 = root.ensure_child("b0");                         //   └c0─c1┴c11=C11
+        b0.ensure_child("b2").set_value("B2");
+        b0.ensure_child("b1").set_value("B1");
+    const json::Tree tree = builder.build();
+
+    ut::expect( ut::that % tree.nodes_count()==8u );
+    ut::expect( ut::that % tree.root().string()=="{b0:{b1:B1,b2:B2},c0:{c1:{c11:C11,c12:C12}}}"sv ) << "childs should be sorted\n";
+    ut::expect( ut::that % tree.root().total_values_count()==4u );
+
+    const auto b0_ref = tree.root().get_child("b0");
+    ut::expect( ut::fatal(b0_ref.has_value()) );
+    ut::expect( b0_ref->has_childs() and not b0_ref->is_leaf() and not b0_ref->has_value() );
+    ut::expect( ut::that % b0_ref->childs().size()==2u );
+    ut::expect( ut::that % b0_ref->get_child("b2")->value()=="B2"sv );
+    ut::expect( b0_ref->get_child("b2")->is_leaf() );
+    ut::expect( not b0_ref->get_child("b3") );
+    ut::expect( ut::that % tree.root().get_child("c0")->get_child("c1")->get_child("c11")->value()=="C11"sv );
+    ut::expect( not tree.root().get_child("X") );
+   };
+
+ut::test("json::Tree::Builder merging") = []
+   {
+    const auto merged = [](const auto& fill_dst, const auto& fill_src) -> std::string
+       {
+        json::Tree::Builder builder;
+        auto dst = builder.root().ensure_child("dst");
+        auto src = dst.new_detached();
+        fill_dst(dst);
+        fill_src(src);
+        dst.insert_childs_of(src);
+        return builder.build().root().string();
+       };
+    const auto set = [](const std::string_view key, const std::string_view val){ return [=](auto& n){ n.ensure_child(key).set_value(val); }; };
+    const auto group = [](const std::string_view key){ return [=](auto& n){ n.ensure_child(key).ensure_child("x").set_value("1"); }; };
+
+    ut::expect( ut::that % merged(set("a","1"), set("b","2"))=="{dst:{a:1,b:2}}"sv );
+    ut::expect( ut::that % merged(group("g"), [](auto& n){ n.ensure_child("g").ensure_child("y").set_value("2"); })=="{dst:{g:{x:1,y:2}}}"sv );
+    ut::expect( ut::throws<std::runtime_error>([&]{ std::ignore = merged(set("a","1"), set("a","2")); }) ) << "value conflict\n";
+    ut::expect( ut::throws<std::runtime_error>([&]{ std::ignore = merged(set("a","1"), set("a","1")); }) ) << "value specified twice\n";
+    ut::expect( ut::throws<std::runtime_error>([&]{ std::ignore = merged(set("a","1"), group("a")); }) ) << "group over value\n";
+    ut::expect( ut::throws<std::runtime_error>([&]{ std::ignore = merged(group("a"), set("a","1")); }) ) << "value over group\n";
+
+    json::Tree::Builder builder;
+    auto n = builder.root().ensure_child("n");
+    n.set_value("1");
+    ut::expect( ut::throws<std::runtime_error>([&]{ n.set_value("2"); }) ) << "overwriting a value\n";
+    ut::expect( ut::throws<std::runtime_error>([&]{ builder.root().set_value("2"); }) ) << "value to a parent\n";
+   };
+
+ut::test("json::Tree::Builder shared blocks") = []
+   {
+    json::Tree::Builder builder;
+    auto root = builder.root();
+    auto bag = root.new_detached(); // As a block with keys "a,b,c"
+        bag.ensure_child("g").ensure_child("x").set_value("1");
+        bag.ensure_child("v").set_value("2");
+    root.ensure_child("a").insert_childs_of(bag);
+    root.ensure_child("b").insert_childs_of(bag);
+    root.ensure_child("c").insert_childs_of(bag);
+    ut::expect( root.ensure_child("a").has_childs() );
+    root.ensure_child("b").ensure_child("g").ensure_child("y").set_value("3"); // Modifies just b
+
+    auto bag2 = root.new_detached(); // Another block merged in "c"
+        bag2.ensure_child("g").ensure_child("z").set_value("4");
+    root.ensure_child("c").insert_childs_of(bag2);
+
+    const json::Tree tree = builder.build();
+    ut::expect( ut::that % tree.root().string()=="{a:{g:{x:1},v:2},b:{g:{x:1,y:3},v:2},c:{g:{x:1,z:4},v:2}}"sv );
+    ut::expect( ut::that % tree.nodes_count()==15u ) << "shared childs should be stored once\n";
+    ut::expect( ut::that % tree.root().total_values_count()==8u );
+
+    auto bag3 = root.new_detached();
+        bag3.ensure_child("v").set_value("5");
+    ut::expect( ut::throws<std::runtime_error>([&]{ root.ensure_child("a").insert_childs_of(bag3); }) ) << "value conflict with shared block\n";
+    ut::expect( ut::throws<std::runtime_error>([&]{ root.ensure_child("a").ensure_child("v").set_value("6"); }) ) << "overwriting a shared value\n";
+    ut::expect( ut::throws<std::runtime_error>([&]{ root.ensure_child("a").set_value("7"); }) ) << "value to a shared parent\n";
+   };
+
+ut::test("json::Tree many childs") = []
+   {
+    std::vector<std::string> keys; // The tree refers to them
+    for( int i=999; i>=0; --i ) keys.push_back( std::format("k{:03}", i) );
+
+    json::Tree::Builder builder(4); // Index must grow
+    auto root = builder.root();
+    for( const auto& key : keys )
+       {
+        root.ensure_child(key).ensure_child("v").set_value("x");
+        ut::expect( not root.ensure_child(key).has_value() ); // Got the existing one
+       }
+    const json::Tree tree = builder.build();
+    ut::expect( ut::that % tree.nodes_count()==2001u );
+    ut::expect( ut::that % tree.root().childs().size()==1000u );
+    ut::expect( ut::that % (*tree.root().childs().begin()).first=="k000"sv );
+    ut::expect( tree.root().get_child("k500").has_value() );
+    ut::expect( ut::that % tree.root().total_values_count()==1000u );
+   };
+
+};///////////////////////////////////////////////////////////////////////////
+#endif // TEST_UNITS ////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
@@ -15,6 +15,7 @@
   #include <fcntl.h> // open
   #include <sys/stat.h> // fstat
   #include <sys/mman.h> // mmap, munmap
+  #include <unistd.h> // close
 #endif
 
 
@@ -67,11 +68,13 @@ class memory_mapped_file final
         struct stat sbuf {};
         if( fstat(fd, &sbuf)==-1 )
            {
+            close(fd);
             throw std::runtime_error{"Cannot fstat file size"};
            }
         m_bufsiz = static_cast<std::size_t>(sbuf.st_size);
 
         m_buf = static_cast<const char*>(mmap(nullptr, m_bufsiz, PROT_READ, MAP_PRIVATE, fd, 0U));
+        close(fd); // The mapping stays valid, don't leak descriptors in long running processes
         if( m_buf==MAP_FAILED )
            {
             m_buf = nullptr;
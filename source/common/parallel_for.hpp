@@ -0,0 +1,140 @@
+﻿#pragma once
+//  ---------------------------------------------
+//  Distribute indexed work on available cores
+//  ---------------------------------------------
+//  #include "parallel_for.hpp" // MG::parallel_for()
+//  ---------------------------------------------
+#include <cstddef> // std::size_t
+#include <concepts> // std::invocable
+#include <algorithm> // std::min, std::max
+#include <atomic>
+#include <mutex>
+#include <latch>
+#include <exception> // std::exception_ptr
+#include <thread> // std::thread::hardware_concurrency
+
+#include "thread_pool.hpp" // MG::thread_pool
+
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+namespace MG //::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+//---------------------------------------------------------------------------
+// Calls f(idx) for each idx in [0,count) using the pool workers and
+// the calling thread (that shouldn't be a worker of the same pool).
+// All the calls are done, the first exception is rethrown at the end
+template<std::invocable<std::size_t> F>
+void parallel_for(thread_pool& pool, const std::size_t count, F&& f)
+{
+    std::atomic<std::size_t> next_idx{0};
+    std::exception_ptr first_exception;
+    std::mutex exception_mtx;
+
+    const auto work = [&]() noexcept
+       {
+        for( std::size_t idx=next_idx++; idx<count; idx=next_idx++ )
+           {
+            try{
+                f(idx);
+               }
+            catch(...)
+               {
+                const std::scoped_lock lock{exception_mtx};
+                if( not first_exception ) first_exception = std::current_exception();
+               }
+           }
+       };
+
+    const std::size_t helpers_count = count>1 ? std::min(count-1, pool.size()) : 0u;
+    std::latch helpers_done{ static_cast<std::ptrdiff_t>(helpers_count) };
+    for( std::size_t i=0; i<helpers_count; ++i )
+       {
+        pool.submit([&work, &helpers_done]{ work(); helpers_done.count_down(); });
+       }
+    work(); // This thread works too
+    helpers_done.wait();
+
+    if( first_exception )
+       {
+        std::rethrow_exception(first_exception);
+       }
+}
+
+
+//---------------------------------------------------------------------------
+// Calls f(idx) for each idx in [0,count) using up to one thread per core.
+// All the calls are done, the first exception is rethrown at the end
+template<std::invocable<std::size_t> F>
+void parallel_for(const std::size_t count, F&& f)
+{
+    const std::size_t threads_count = std::min<std::size_t>(count, std::max(1u, std::thread::hardware_concurrency()));
+    if( threads_count>1 )
+       {
+        thread_pool pool(threads_count-1);
+        parallel_for(pool, count, std::forward<F>(f));
+       }
+    else
+       {
+        std::exception_ptr first_exception;
+        for( std::size_t idx=0; idx<count; ++idx )
+           {
+            try{
+                f(idx);
+               }
+            catch(...)
+               {
+                if( not first_exception ) first_exception = std::current_exception();
+               }
+           }
+        if( first_exception )
+           {
+            std::rethrow_exception(first_exception);
+           }
+       }
+}
+
+}//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+#ifdef TEST_UNITS ///////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+static ut::suite<"MG::parallel_for()"> parallel_for_tests = []
+{////////////////////////////////////////////////////////////////////////////
+
+ut::test("all indexes visited once") = []
+   {
+    std::vector<int> visits(1000, 0);
+    MG::parallel_for(visits.size(), [&visits](const std::size_t idx){ ++visits[idx]; });
+    ut::expect( std::ranges::all_of(visits, [](const int n){ return n==1; }) );
+   };
+
+ut::test("no work") = []
+   {
+    int calls = 0;
+    MG::parallel_for(0u, [&calls](const std::size_t){ ++calls; });
+    ut::expect( ut::that % calls==0 );
+   };
+
+ut::test("using a given pool") = []
+   {
+    MG::thread_pool pool(2);
+    std::atomic<std::size_t> sum{0};
+    MG::parallel_for(pool, 100u, [&sum](const std::size_t idx){ sum += idx; });
+    MG::parallel_for(pool, 100u, [&sum](const std::size_t idx){ sum += idx; });
+    ut::expect( ut::that % sum.load()==9900u );
+   };
+
+ut::test("exception propagation") = []
+   {
+    std::atomic<std::size_t> calls{0};
+    ut::expect( ut::throws([&calls]{ MG::parallel_for(100u, [&calls](const std::size_t idx){ ++calls; if(idx==42) throw std::runtime_error("boom"); }); }) ) << "should rethrow\n";
+    ut::expect( ut::that % calls.load()==100u ) << "all calls should be done anyway\n";
+   };
+
+};///////////////////////////////////////////////////////////////////////////
+#endif // TEST_UNITS ////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
@@ -125,6 +125,17 @@ class ParserBase
         return see_curr_codepoint();
        }
 
+    //-----------------------------------------------------------------------
+    // Jump ahead to a position found otherwise (ex. with an index),
+    // knowing the line breaks in the skipped content
+    constexpr void jump_to(const std::size_t offset, const std::size_t skipped_lines) noexcept
+       {
+        assert( offset>=m_offset );
+        m_line += skipped_lines;
+        m_offset = offset;
+        see_curr_codepoint();
+       }
+
     //-----------------------------------------------------------------------
     // Querying current codepoint
     [[nodiscard]] constexpr bool has_codepoint() const noexcept
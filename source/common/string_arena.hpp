@@ -0,0 +1,87 @@
+﻿#pragma once
+//  ---------------------------------------------
+//  Append-only storage of strings
+//  .The stored strings never move
+//  .Few big allocations instead of one each
+//  ---------------------------------------------
+//  #include "string_arena.hpp" // MG::string_arena
+//  ---------------------------------------------
+#include <string_view>
+#include <vector>
+#include <memory> // std::unique_ptr
+#include <algorithm> // std::ranges::copy, std::max
+
+
+namespace MG //::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+/////////////////////////////////////////////////////////////////////////////
+class string_arena final
+{
+ private:
+    static constexpr std::size_t min_chunk_size = 4096;
+    std::vector<std::unique_ptr<char[]>> m_chunks;
+    std::size_t m_chunk_size = 0;
+    std::size_t m_chunk_used = 0;
+    std::size_t m_stored_size = 0;
+
+ public:
+    [[nodiscard]] std::size_t chunks_count() const noexcept { return m_chunks.size(); }
+    [[nodiscard]] std::size_t stored_size() const noexcept { return m_stored_size; }
+
+    //-----------------------------------------------------------------------
+    // A copy of the string that lives as long as the arena
+    [[nodiscard]] std::string_view store(const std::string_view sv)
+       {
+        if( sv.empty() ) return {};
+        if( sv.size() > m_chunk_size - m_chunk_used )
+           {
+            m_chunk_size = std::max(min_chunk_size, sv.size());
+            m_chunks.push_back( std::make_unique_for_overwrite<char[]>(m_chunk_size) );
+            m_chunk_used = 0;
+           }
+        char* const dst = m_chunks.back().get() + m_chunk_used;
+        std::ranges::copy(sv, dst);
+        m_chunk_used += sv.size();
+        m_stored_size += sv.size();
+        return {dst, sv.size()};
+       }
+};
+
+}//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+#ifdef TEST_UNITS ///////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+static ut::suite<"string_arena"> string_arena_tests = []
+{////////////////////////////////////////////////////////////////////////////
+
+ut::test("MG::string_arena") = []
+   {
+    MG::string_arena arena;
+    ut::expect( ut::that % arena.store(""sv).size()==0u and arena.chunks_count()==0u );
+
+    std::vector<std::string_view> stored;
+    for( int i=0; i<1000; ++i )
+       {
+        stored.push_back( arena.store(std::format("value {}", i)) );
+       }
+    const std::string big(10000, 'x');
+    const std::string_view stored_big = arena.store(big);
+
+    bool all_same = true;
+    for( int i=0; i<1000; ++i )
+       {
+        if( stored[static_cast<std::size_t>(i)]!=std::format("value {}", i) ) all_same = false;
+       }
+    ut::expect( all_same ) << "stored strings shouldn't move\n";
+    ut::expect( stored_big==big );
+    ut::expect( ut::that % arena.chunks_count()<5u );
+   };
+
+};///////////////////////////////////////////////////////////////////////////
+#endif // TEST_UNITS ////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,121 @@
+﻿#pragma once
+//  ---------------------------------------------
+//  Byte ranges of a buffer to be replaced
+//  .The unmodified parts are never copied
+//  .The replacement texts are streamed in
+//  ---------------------------------------------
+//  #include "text_patches.hpp" // MG::text_patches
+//  ---------------------------------------------
+#include <cassert>
+#include <cstdint> // std::uint32_t
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace MG //::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+/////////////////////////////////////////////////////////////////////////////
+// The ranges must be given in ascending order, each one followed
+// by its replacement text, that can be empty to delete or the range
+// can be empty to insert. The texts are contiguous in one string
+class text_patches final
+{
+ private:
+    struct patch_t final
+       {
+        std::uint32_t begin, end; // The replaced range of the buffer
+        std::uint32_t text_begin; // Where its replacement starts in m_text
+       };
+    std::vector<patch_t> m_patches;
+    std::string m_text;
+
+ public:
+    [[nodiscard]] std::size_t size() const noexcept { return m_patches.size(); }
+    [[nodiscard]] bool is_empty() const noexcept { return m_patches.empty(); }
+
+    //-----------------------------------------------------------------------
+    // What is streamed after will replace the range [begin,end)
+    void replace(const std::size_t begin, const std::size_t end)
+       {
+        assert( begin<=end and (m_patches.empty() or m_patches.back().end<=begin) );
+        m_patches.push_back({ static_cast<std::uint32_t>(begin),
+                              static_cast<std::uint32_t>(end),
+                              static_cast<std::uint32_t>(m_text.size()) });
+       }
+
+    text_patches& operator<<(const char c)
+       {
+        assert( not m_patches.empty() );
+        m_text += c;
+        return *this;
+       }
+
+    text_patches& operator<<(const std::string_view sv)
+       {
+        assert( not m_patches.empty() );
+        m_text += sv;
+        return *this;
+       }
+
+    //-----------------------------------------------------------------------
+    // The pieces of the patched [begin,end) range of buf, pointing to buf
+    // or to my texts, so valid until buf or me are modified or destroyed
+    [[nodiscard]] std::vector<std::string_view> fragments_of(const std::string_view buf, std::size_t begin, const std::size_t end) const
+       {
+        std::vector<std::string_view> fragments;
+        fragments.reserve(2*m_patches.size() + 1);
+        const auto add = [&fragments](const std::string_view sv){ if(not sv.empty()) fragments.push_back(sv); };
+        for( std::size_t i=0; i<m_patches.size(); ++i )
+           {
+            const patch_t& patch = m_patches[i];
+            assert( patch.begin>=begin and patch.end<=end );
+            add( buf.substr(begin, patch.begin-begin) );
+            const std::size_t text_end = i+1<m_patches.size() ? m_patches[i+1].text_begin : m_text.size();
+            add( std::string_view{m_text}.substr(patch.text_begin, text_end-patch.text_begin) );
+            begin = patch.end;
+           }
+        add( buf.substr(begin, end-begin) );
+        return fragments;
+       }
+};
+
+}//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+#ifdef TEST_UNITS ///////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+static ut::suite<"MG::text_patches"> text_patches_tests = []
+{////////////////////////////////////////////////////////////////////////////
+
+ut::test("MG::text_patches") = []
+   {
+    const std::string_view buf = "abc=1\nxyz=2\nend\n"sv;
+    const auto patched = [buf](const MG::text_patches& patches, const std::size_t begin, const std::size_t end)
+       {
+        std::string s;
+        for( const auto sv : patches.fragments_of(buf, begin, end) ) s += sv;
+        return s;
+       };
+
+    MG::text_patches patches;
+    ut::expect( ut::that % patched(patches, 0, buf.size())==buf );
+    ut::expect( ut::that % patches.fragments_of(buf, 0, buf.size()).size()==1u ) << "unmodified buffer should be one fragment\n";
+
+    patches.replace(4, 5);
+    patches << "10"sv;
+    patches.replace(6, 6);
+    patches << '#' << " note\n"sv;
+    patches.replace(10, 12);
+    ut::expect( ut::that % patches.size()==3u );
+    ut::expect( ut::that % patched(patches, 0, buf.size())=="abc=10\n# note\nxyz=end\n"sv );
+    ut::expect( ut::that % patched(patches, 2, 14)=="c=10\n# note\nxyz=en"sv );
+    ut::expect( patches.fragments_of(buf, 0, buf.size()).front().data()==buf.data() ) << "unmodified parts should not be copied\n";
+   };
+
+};///////////////////////////////////////////////////////////////////////////
+#endif // TEST_UNITS ////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,241 @@
+﻿#pragma once
+//  ---------------------------------------------
+//  A pool of worker threads that steal tasks
+//  from each other's queues
+//  ---------------------------------------------
+//  #include "thread_pool.hpp" // MG::thread_pool
+//  ---------------------------------------------
+#include <cstddef> // std::size_t
+#include <algorithm> // std::max
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <memory> // std::unique_ptr
+#include <functional> // std::function
+#include <exception> // std::exception_ptr
+#include <thread> // std::jthread
+#include <optional>
+#include <utility> // std::exchange
+#include <vector>
+
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+namespace MG //::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+/////////////////////////////////////////////////////////////////////////////
+// Each worker pops from the back of its own queue and when empty
+// steals from the front of the others. Submitted tasks are dealt
+// round robin. The first exception thrown by a task is rethrown
+// by wait(), that returns when all the submitted tasks are done.
+class thread_pool final
+{
+ public:
+    using task_t = std::function<void()>;
+
+ private:
+    struct task_queue_t final
+       {
+        std::mutex mtx;
+        std::deque<task_t> tasks;
+       };
+
+    std::size_t m_size;
+    std::unique_ptr<task_queue_t[]> m_queues;
+    std::atomic<std::size_t> m_next_queue{0};
+
+    std::mutex m_mtx; // Guards the following
+    std::condition_variable m_cv_work;
+    std::condition_variable m_cv_idle;
+    std::size_t m_queued = 0; // Tasks waiting in queues
+    std::size_t m_pending = 0; // Tasks not yet completed
+    std::exception_ptr m_first_exception;
+    bool m_stopping = false;
+
+    std::vector<std::jthread> m_threads; // Last, joined first
+
+ public:
+    explicit thread_pool(const std::size_t threads_count =std::thread::hardware_concurrency())
+      : m_size{ std::max<std::size_t>(1u, threads_count) }
+      , m_queues{ std::make_unique<task_queue_t[]>(m_size) }
+       {
+        m_threads.reserve(m_size);
+        for( std::size_t i=0; i<m_size; ++i )
+           {
+            m_threads.emplace_back([this, i]{ work(i); });
+           }
+       }
+
+    ~thread_pool()
+       {
+           {
+            const std::scoped_lock lock{m_mtx};
+            m_stopping = true;
+           }
+        m_cv_work.notify_all();
+        m_threads.clear(); // Join after the remaining tasks are done
+       }
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+    thread_pool(thread_pool&&) = delete;
+    thread_pool& operator=(thread_pool&&) = delete;
+
+    [[nodiscard]] std::size_t size() const noexcept { return m_size; }
+
+    //-----------------------------------------------------------------------
+    void submit(task_t&& task)
+       {
+           {
+            const std::scoped_lock lock{m_mtx};
+            ++m_queued;
+            ++m_pending;
+           }
+        task_queue_t& queue = m_queues[m_next_queue++ % m_size];
+           {
+            const std::scoped_lock lock{queue.mtx};
+            queue.tasks.push_back( std::move(task) );
+           }
+        m_cv_work.notify_one();
+       }
+
+    //-----------------------------------------------------------------------
+    // Don't call from a task: would wait for itself
+    void wait()
+       {
+        std::unique_lock lock{m_mtx};
+        m_cv_idle.wait(lock, [this]() noexcept { return m_pending==0; });
+        if( m_first_exception )
+           {
+            std::rethrow_exception( std::exchange(m_first_exception, nullptr) );
+           }
+       }
+
+ private:
+    //-----------------------------------------------------------------------
+    [[nodiscard]] std::optional<task_t> pop_task_for(const std::size_t idx)
+       {
+           {// Own queue first, most recent
+            task_queue_t& queue = m_queues[idx];
+            const std::scoped_lock lock{queue.mtx};
+            if( not queue.tasks.empty() )
+               {
+                std::optional<task_t> task{ std::move(queue.tasks.back()) };
+                queue.tasks.pop_back();
+                return task;
+               }
+           }
+        for( std::size_t i=1; i<m_size; ++i )
+           {// Steal the oldest from the others
+            task_queue_t& queue = m_queues[(idx+i) % m_size];
+            const std::scoped_lock lock{queue.mtx};
+            if( not queue.tasks.empty() )
+               {
+                std::optional<task_t> task{ std::move(queue.tasks.front()) };
+                queue.tasks.pop_front();
+                return task;
+               }
+           }
+        return std::nullopt;
+       }
+
+    //-----------------------------------------------------------------------
+    void work(const std::size_t idx) noexcept
+       {
+        while( true )
+           {
+            if( std::optional<task_t> task = pop_task_for(idx) )
+               {
+                   {
+                    const std::scoped_lock lock{m_mtx};
+                    --m_queued;
+                   }
+                std::exception_ptr task_exception;
+                try{
+                    (*task)();
+                   }
+                catch(...)
+                   {
+                    task_exception = std::current_exception();
+                   }
+                task.reset(); // Release the captures before signaling completion
+
+                const std::scoped_lock lock{m_mtx};
+                if( task_exception and not m_first_exception )
+                   {
+                    m_first_exception = task_exception;
+                   }
+                if( --m_pending==0 )
+                   {
+                    m_cv_idle.notify_all();
+                   }
+               }
+            else
+               {
+                std::unique_lock lock{m_mtx};
+                m_cv_work.wait(lock, [this]() noexcept { return m_queued>0 or m_stopping; });
+                if( m_queued==0 and m_stopping )
+                   {
+                    break;
+                   }
+               }
+           }
+       }
+};
+
+}//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+#ifdef TEST_UNITS ///////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+static ut::suite<"MG::thread_pool"> thread_pool_tests = []
+{////////////////////////////////////////////////////////////////////////////
+
+ut::test("all tasks done") = []
+   {
+    std::atomic<int> count{0};
+    MG::thread_pool pool(4);
+    ut::expect( ut::that % pool.size()==4u );
+    for( int i=0; i<1000; ++i )
+       {
+        pool.submit([&count]{ ++count; });
+       }
+    pool.wait();
+    ut::expect( ut::that % count.load()==1000 );
+   };
+
+ut::test("tasks submitting tasks") = []
+   {
+    std::atomic<int> count{0};
+    MG::thread_pool pool(3);
+    for( int i=0; i<10; ++i )
+       {
+        pool.submit([&count, &pool]
+           {
+            for( int j=0; j<10; ++j ) pool.submit([&count]{ ++count; });
+           });
+       }
+    pool.wait();
+    ut::expect( ut::that % count.load()==100 );
+   };
+
+ut::test("exception propagation") = []
+   {
+    std::atomic<int> count{0};
+    MG::thread_pool pool(2);
+    for( int i=0; i<10; ++i )
+       {
+        pool.submit([&count, i]{ ++count; if(i==5) throw std::runtime_error("boom"); });
+       }
+    ut::expect( ut::throws([&pool]{ pool.wait(); }) ) << "should rethrow\n";
+    ut::expect( ut::that % count.load()==10 ) << "all tasks should be done anyway\n";
+    ut::expect( ut::nothrow([&pool]{ pool.wait(); }) ) << "exception already consumed\n";
+   };
+
+};///////////////////////////////////////////////////////////////////////////
+#endif // TEST_UNITS ////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,206 @@
+﻿#pragma once
+//  ---------------------------------------------
+//  A stream socket in the unix domain
+//  ---------------------------------------------
+//  #include "unix_socket.hpp" // sys::unix_socket
+//  ---------------------------------------------
+#include <string>
+#include <string_view>
+#include <stdexcept> // std::runtime_error
+#include <format>
+#include <cstring> // std::memcpy, std::strerror
+#include <cerrno> // errno
+
+#include "os-detect.hpp" // MS_WINDOWS, POSIX
+
+#if defined(POSIX)
+  #include <sys/socket.h> // socket, bind, listen, accept, connect, send, recv, shutdown
+  #include <sys/un.h> // sockaddr_un
+  #include <unistd.h> // close, unlink
+#endif
+
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+namespace sys //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+#if defined(POSIX)
+
+/////////////////////////////////////////////////////////////////////////////
+class unix_socket final
+{
+ private:
+    int m_fd = -1;
+
+    explicit unix_socket(const int fd) noexcept
+      : m_fd{fd}
+       {}
+
+ public:
+    ~unix_socket() noexcept
+       {
+        if( m_fd!=-1 )
+           {
+            ::close(m_fd);
+           }
+       }
+
+    unix_socket(const unix_socket&) = delete;
+    unix_socket& operator=(const unix_socket&) = delete;
+    unix_socket(unix_socket&& other) noexcept
+      : m_fd{other.m_fd}
+       {
+        other.m_fd = -1;
+       }
+    unix_socket& operator=(unix_socket&&) = delete;
+
+    //-----------------------------------------------------------------------
+    // Bind to a filesystem path, replacing a stale socket file
+    [[nodiscard]] static unix_socket listen_on(const std::string& pth)
+       {
+        unix_socket sock = create();
+        const sockaddr_un addr = address_of(pth);
+        ::unlink(pth.c_str());
+        if( ::bind(sock.m_fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr))==-1 or
+            ::listen(sock.m_fd, SOMAXCONN)==-1 )
+           {
+            throw std::runtime_error( std::format("Cannot listen on {} ({})", pth, std::strerror(errno)) );
+           }
+        return sock;
+       }
+
+    //-----------------------------------------------------------------------
+    [[nodiscard]] static unix_socket connect_to(const std::string& pth)
+       {
+        unix_socket sock = create();
+        const sockaddr_un addr = address_of(pth);
+        if( ::connect(sock.m_fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr))==-1 )
+           {
+            throw std::runtime_error( std::format("Cannot connect to {} ({})", pth, std::strerror(errno)) );
+           }
+        return sock;
+       }
+
+    //-----------------------------------------------------------------------
+    [[nodiscard]] unix_socket accept() const
+       {
+        int fd;
+        do{ fd = ::accept(m_fd, nullptr, nullptr); }
+        while( fd==-1 and errno==EINTR );
+        if( fd==-1 )
+           {
+            throw std::runtime_error( std::format("Cannot accept connection ({})", std::strerror(errno)) );
+           }
+        return unix_socket{fd};
+       }
+
+    //-----------------------------------------------------------------------
+    void send_all(std::string_view data) const
+       {
+        while( not data.empty() )
+           {
+            const ssize_t n = ::send(m_fd, data.data(), data.size(), MSG_NOSIGNAL);
+            if( n==-1 )
+               {
+                if( errno==EINTR ) continue;
+                throw std::runtime_error( std::format("Cannot send data ({})", std::strerror(errno)) );
+               }
+            data.remove_prefix( static_cast<std::size_t>(n) );
+           }
+       }
+
+    //-----------------------------------------------------------------------
+    // Signal to the peer that nothing more will be sent
+    void shutdown_send() const noexcept
+       {
+        ::shutdown(m_fd, SHUT_WR);
+       }
+
+    //-----------------------------------------------------------------------
+    // Receive until the peer stops sending
+    [[nodiscard]] std::string receive_all() const
+       {
+        std::string data;
+        char buf[4096];
+        while( true )
+           {
+            const ssize_t n = ::recv(m_fd, buf, sizeof(buf), 0);
+            if( n==0 )
+               {
+                break;
+               }
+            if( n==-1 )
+               {
+                if( errno==EINTR ) continue;
+                throw std::runtime_error( std::format("Cannot receive data ({})", std::strerror(errno)) );
+               }
+            data.append(buf, static_cast<std::size_t>(n));
+           }
+        return data;
+       }
+
+ private:
+    //-----------------------------------------------------------------------
+    [[nodiscard]] static unix_socket create()
+       {
+        const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if( fd==-1 )
+           {
+            throw std::runtime_error( std::format("Cannot create socket ({})", std::strerror(errno)) );
+           }
+        return unix_socket{fd};
+       }
+
+    //-----------------------------------------------------------------------
+    [[nodiscard]] static sockaddr_un address_of(const std::string& pth)
+       {
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if( pth.size()>=sizeof(addr.sun_path) )
+           {
+            throw std::runtime_error( std::format("Socket path too long: {}", pth) );
+           }
+        std::memcpy(addr.sun_path, pth.c_str(), pth.size()+1);
+        return addr;
+       }
+};
+
+#endif
+
+}//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+#ifdef TEST_UNITS ///////////////////////////////////////////////////////////
+#if defined(POSIX) //////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+#include <thread> // std::jthread
+/////////////////////////////////////////////////////////////////////////////
+static ut::suite<"sys::unix_socket"> unix_socket_tests = []
+{////////////////////////////////////////////////////////////////////////////
+
+ut::test("echo") = []
+   {
+    test::TemporaryDirectory tmp_dir;
+    const std::string sock_path = (tmp_dir.path() / "echo.sock").string();
+    const sys::unix_socket listener = sys::unix_socket::listen_on(sock_path);
+
+    std::jthread server([&listener]
+       {
+        const sys::unix_socket conn = listener.accept();
+        conn.send_all( conn.receive_all() + "!" );
+       });
+
+    const sys::unix_socket client = sys::unix_socket::connect_to(sock_path);
+    const std::string request(10000, 'x'); // More than a single chunk
+    client.send_all(request);
+    client.shutdown_send();
+    ut::expect( ut::that % client.receive_all()==request+"!" );
+   };
+
+};///////////////////////////////////////////////////////////////////////////
+#endif // POSIX /////////////////////////////////////////////////////////////
+#endif // TEST_UNITS ////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,140 @@
+﻿#pragma once
+//  ---------------------------------------------
+//  Report which machines of the DB set each
+//  field, and the fields of a target file that
+//  aren't set for any machine
+//  ---------------------------------------------
+//  #include "db_coverage.hpp" // app::report_db_coverage()
+//  ---------------------------------------------
+#include <string>
+#include <string_view>
+#include <vector>
+#include <format>
+
+#include "fnotify_type.hpp" // fnotify_t
+#include "job_unit.hpp" // app::JobUnit
+#include "macotec_parameters_database.hpp" // macotec::ParamsDB, macotec::ParamsFieldsIndex
+#include "udt_file_descriptor.hpp" // udt::File
+#include "parax_file_descriptor.hpp" // parax::File
+
+using namespace std::literals; // "..."sv
+
+
+namespace app //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+//---------------------------------------------------------------------------
+// The names of the fields of the target as in the DB (axis.param for par2kax)
+[[nodiscard]] std::vector<std::string> db_names_of_fields_of(const JobUnit& job, fnotify_t const& notify_issue)
+{
+    std::vector<std::string> names;
+    if( job.target_file().is_udt() )
+       {
+        const udt::File udt_file(job.target_file().path().string(), notify_issue);
+        names.reserve( udt_file.fields().size() );
+        for( const auto& field : udt_file.fields() )
+           {
+            names.emplace_back( field.label() );
+           }
+       }
+    else if( job.target_file().is_parax() )
+       {
+        const parax::File parax_file(job.target_file().path().string(), notify_issue);
+        for( const auto& axis : parax_file.axes() )
+           {
+            for( const auto& field : axis.fields() )
+               {
+                names.push_back( std::format("{}.{}", axis.name(), field.var_name()) );
+               }
+           }
+       }
+    else
+       {
+        throw std::runtime_error( std::format("Cannot tell the fields of {}", job.target_file().path().string()) );
+       }
+    return names;
+}
+
+
+//---------------------------------------------------------------------------
+// Each field set in the DB with the sections that set it, then
+// the fields of the target (if given) not set for any machine
+template<typename FPRINT>
+void report_db_coverage( const JobUnit& job,
+                         FPRINT const& print,
+                         fnotify_t const& notify_issue )
+{
+    const macotec::ParamsDB db{ job.db_file().path().string(), notify_issue };
+    const macotec::ParamsFieldsIndex index = db.fields_index(notify_issue);
+
+    for( const auto& [field_name, settings] : index.fields() )
+       {
+        std::string line = std::format("{}:", field_name);
+        for( const auto& setting : settings )
+           {
+            line += std::format(" {}={}", setting.section(), setting.value.value());
+           }
+        print("{}\n", line);
+       }
+
+    if( job.target_file() )
+       {
+        std::vector<std::string> unset;
+        for( auto& field_name : db_names_of_fields_of(job, notify_issue) )
+           {
+            if( not index.settings_of(field_name) ) unset.push_back( std::move(field_name) );
+           }
+        print("{} fields of {} not set for any machine\n", unset.size(), job.target_file().path().filename().string());
+        for( const auto& field_name : unset )
+           {
+            print("    {}\n", field_name);
+           }
+       }
+}
+
+}//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+#ifdef TEST_UNITS ///////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+static ut::suite<"db_coverage"> db_coverage_tests = []
+{////////////////////////////////////////////////////////////////////////////
+
+struct issues_t final { int num=0; void operator()(std::string&& msg) noexcept {++num; ut::log << msg << '\n';}; };
+
+ut::test("app::report_db_coverage()") = []
+   {
+    test::TemporaryDirectory tmp_dir;
+    const auto udt = tmp_dir.create_file("MachSettings.udt",
+        "va0 = \"ActiveHP-6.0/4.6\" # Mandatory field 'vaMachName'\n"
+        "vn123 = 0 # Type 'vnType'\n"
+        "vn124 = 0 # Never set 'vnOther'\n"sv);
+    const auto db = tmp_dir.create_file("udt-overlays.txt",
+        "HP,WR:{\n"
+        "    \"common\": { vnType: 11 }\n"
+        "    \"+fast\": { vqSpd: 2 }\n"
+        "   }\n"sv);
+
+    app::JobUnit job;
+    job.set_target_file(udt.path().string());
+    job.set_db_file(db.path().string());
+
+    issues_t issues;
+    std::string out;
+    const auto print = [&out](const std::string_view msg, const auto&... args){ out += std::vformat(msg, std::make_format_args(args...)); };
+    app::report_db_coverage(job, print, std::ref(issues));
+    ut::expect( ut::that % out=="vnType: HP:common=11 WR:common=11\n"
+                                "vqSpd: HP:+fast=2 WR:+fast=2\n"
+                                "2 fields of MachSettings.udt not set for any machine\n"
+                                "    vaMachName\n"
+                                "    vnOther\n"sv );
+    ut::expect( ut::that % issues.num==0 ) << "no issues expected\n";
+   };
+
+};///////////////////////////////////////////////////////////////////////////
+#endif // TEST_UNITS ////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
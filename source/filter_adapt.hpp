@@ -0,0 +1,143 @@
+﻿#pragma once
+//  ---------------------------------------------
+//  Adapt or update a file as a filter:
+//  target from stdin, result to stdout,
+//  without passing from the filesystem
+//  ---------------------------------------------
+//  #include "filter_adapt.hpp" // app::filter_adapt(), app::filter_stdin_to_stdout()
+//  ---------------------------------------------
+#include <string>
+#include <string_view>
+#include <format>
+#include <stdexcept> // std::runtime_error
+
+#include "file_content.hpp" // sys::file_content, sys::write_all()
+#include "string_write.hpp" // MG::string_write
+#include "output_streamable_concept.hpp" // MG::OutputStreamable
+#include "options_set.hpp" // MG::options_set
+#include "job_unit.hpp" // app::JobUnit
+#include "adapt_udt_file.hpp" // app::overlay_adapted_udt()
+#include "adapt_parax_file.hpp" // app::overlay_parax_for()
+
+using namespace std::literals; // "..."sv
+
+
+namespace app //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+inline constexpr std::string_view stdin_name = "stdin"sv;
+
+
+//---------------------------------------------------------------------------
+// Do the job on a target already in memory, streaming out the result
+template<typename FPRINT>
+void filter_adapt( const JobUnit& job,
+                   sys::file_content&& target_content,
+                   MG::OutputStreamable auto& out,
+                   const MG::options_set& options,
+                   FPRINT const& verbose_print,
+                   fnotify_t const& notify_issue )
+{
+    sipro::TxtOverlay overlay;
+    if( job.is_update_udt() )
+       {
+        const udt::File new_udt_file(std::string{stdin_name}, std::move(target_content), notify_issue);
+        const udt::File old_udt_file(job.db_file().path().string(), notify_issue);
+        verbose_print("  Old udt: {}\n"
+                      "  New udt: {}\n",
+                      old_udt_file.info_string(),
+                      new_udt_file.info_string());
+        new_udt_file.overwrite_values_from( old_udt_file, overlay );
+        new_udt_file.write_to( out, overlay, options, {} );
+       }
+    else if( job.is_adapt_udt() )
+       {
+        const udt::File udt_file(std::string{stdin_name}, std::move(target_content), notify_issue);
+        const macotec::ParamsDB db{ job.db_file().path().string(), notify_issue, macotec::ParamsDB::parsing::lazy };
+        verbose_print("  udt file: {}\n"
+                      "  DB: {}\n",
+                      udt_file.info_string(),
+                      db.info_string());
+        overlay_adapted_udt(udt_file, db, job.mach_data(), overlay, notify_issue);
+        udt_file.write_to( out, overlay, options, {} );
+       }
+    else if( job.is_adapt_parax() )
+       {
+        const parax::File parax_file(std::string{stdin_name}, std::move(target_content), notify_issue);
+        const macotec::ParamsDB db{ job.db_file().path().string(), notify_issue, macotec::ParamsDB::parsing::lazy };
+        verbose_print("  parax file: {}\n"
+                      "  DB: {}\n",
+                      parax_file.info_string(),
+                      db.info_string());
+        overlay_parax_for(parax_file, db, job.mach_data(), overlay, notify_issue);
+        parax_file.write_to( out, overlay, options, std::format("Machine: {}", job.mach_data().string()) );
+       }
+    else
+       {
+        throw std::runtime_error("Just adaptations and udt updates can read from stdin");
+       }
+    verbose_print("  Modified {} values, {} issues\n", overlay.modified_values_count(), overlay.mod_issues().size());
+}
+
+
+//---------------------------------------------------------------------------
+// The output is written at once when complete, so nothing
+// partial gets in the pipeline when something goes wrong
+template<typename FPRINT>
+void filter_stdin_to_stdout( const JobUnit& job,
+                             const MG::options_set& options,
+                             FPRINT const& verbose_print,
+                             fnotify_t const& notify_issue )
+{
+    MG::string_write out;
+    filter_adapt(job, sys::file_content::of_stdin(), out, options, verbose_print, notify_issue);
+    sys::set_binary_mode(stdout);
+    sys::write_all(stdout, out.str(), "stdout"sv);
+}
+
+}//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+#ifdef TEST_UNITS ///////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+static ut::suite<"filter_adapt"> filter_adapt_tests = []
+{////////////////////////////////////////////////////////////////////////////
+
+struct issues_t final { int num=0; void operator()(std::string&& msg) noexcept {++num; ut::log << msg << '\n';}; };
+
+ut::test("app::filter_adapt()") = []
+   {
+    test::TemporaryDirectory tmp_dir;
+    const auto db = tmp_dir.create_file("udt-overlays.txt",
+        "HP:{\n"
+        "    \"common\": { vnType: 11 }\n"
+        "   }\n"sv);
+
+    app::JobUnit job;
+    job.set_target_stdin("MachSettings.udt"sv);
+    job.set_db_file(db.path().string());
+    job.add_mach_data("ActiveHP-6.0/4.6"sv);
+    job.detect_task();
+    job.ensure_out_path({});
+    ut::expect( ut::fatal(job.is_filter() and job.is_adapt_udt()) );
+
+    issues_t issues;
+    MG::string_write out;
+    app::filter_adapt( job,
+                       sys::file_content::of_string( "va0 = \"ActiveHP-6.0/4.6\" # Mandatory field 'vaMachName'\r\n"
+                                                     "vn123 = 0 # Should be overwritten 'vnType'\r\n"s ),
+                       out,
+                       MG::options_set{"no-timestamp"sv},
+                       [](const std::string_view, const auto&...){},
+                       std::ref(issues) );
+    ut::expect( ut::that % issues.num==0 ) << "no issues expected\n";
+    ut::expect( out.str().contains("vn123 = 11 # Should be overwritten 'vnType'\r\n"sv) ) << "should keep the line breaks\n";
+   };
+
+};///////////////////////////////////////////////////////////////////////////
+#endif // TEST_UNITS ////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
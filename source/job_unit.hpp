@@ -6,10 +6,15 @@
 //  ---------------------------------------------
 #include <cstdint> // std::uint8_t
 #include <string_view>
+#include <vector>
+#include <algorithm> // std::ranges::find, std::ranges::replace_if
 #include <filesystem> // std::filesystem
 #include <stdexcept> // std::runtime_error
 
+#include "string_utilities.hpp" // str::trim_right, ascii::is_space
+#include "memory_mapped_file.hpp" // sys::memory_mapped_file
 #include "macotec_machine_data.hpp" // macotec::MachineData
+#include "mach_outputs.hpp" // app::MachOutputs
 
 namespace fs = std::filesystem;
 
@@ -28,17 +33,19 @@ class JobUnit final
             unknown,
             udt, // MachSettings.udt, ParDefaults.udt
             parax, // par2kax.txt
-            txt // generic text (could be a json db or a sipro parameter file)
+            txt // generic text (could be a json db, its compiled image or a sipro parameter file)
            };
 
      private:
         fs::path m_path;
         file_type m_type = file_type::unknown;
+        bool m_is_stdin = false;
 
      public:
         [[nodiscard]] explicit operator bool() const noexcept { return !m_path.empty(); }
 
         [[nodiscard]] const auto& path() const noexcept { return m_path; }
+        [[nodiscard]] bool is_stdin() const noexcept { return m_is_stdin; }
 
         void assign( const std::string_view sv )
            {
@@ -47,10 +54,30 @@ class JobUnit final
                {
                 throw std::runtime_error( std::format("File not found: {}", sv) );
                }
+            // A link (as /dev/fd/3) is recognized by the linked file name
+            std::error_code ec;
+            const fs::path real_path = fs::is_symlink(m_path) ? fs::canonical(m_path, ec) : m_path;
+            recognize_type(ec ? m_path : real_path, not fs::is_regular_file(m_path));
+           }
+
+        // The content will come from the standard input,
+        // the given file name tells its type
+        void assign_stdin( const std::string_view nam )
+           {
+            m_path = "-";
+            m_is_stdin = true;
+            recognize_type(nam, false);
+           }
+
+        [[nodiscard]] bool is_udt() const noexcept { return m_type==file_type::udt; }
+        [[nodiscard]] bool is_parax() const noexcept { return m_type==file_type::parax; }
+        [[nodiscard]] bool is_txt() const noexcept { return m_type==file_type::txt; }
 
-            // Recognize the file type
-            const std::string fnam{ str::to_lower(m_path.filename().string()) };
-            const std::string ext{ str::to_lower(m_path.extension().string()) };
+     private:
+        void recognize_type( const fs::path& pth, const bool is_pipe )
+           {
+            const std::string fnam{ str::to_lower(pth.filename().string()) };
+            const std::string ext{ str::to_lower(pth.extension().string()) };
             if( ext==".udt" )
                {
                 m_type = file_type::udt;
@@ -59,19 +86,15 @@ class JobUnit final
                {
                 m_type = file_type::parax;
                }
-            else if( ext==".txt" )
-               {
+            else if( ext==".txt" or ext==".m32db" or is_pipe )
+               {// A pipe without a recognized name (as /dev/fd/3) can be just a DB
                 m_type = file_type::txt;
                }
             else
                {
-                throw std::runtime_error( std::format("Unrecognized file: {}", sv) );
+                throw std::runtime_error( std::format("Unrecognized file: {}", pth.string()) );
                }
            }
-
-        [[nodiscard]] bool is_udt() const noexcept { return m_type==file_type::udt; }
-        [[nodiscard]] bool is_parax() const noexcept { return m_type==file_type::parax; }
-        [[nodiscard]] bool is_txt() const noexcept { return m_type==file_type::txt; }
     };
 
     enum class task_type : std::uint8_t
@@ -79,26 +102,91 @@ class JobUnit final
         unknown,
         update_udt, // Updating an old udt file (db) to a newer one (target)
         adapt_udt,  // Adapting an udt file given overlays database and machine type
-        adapt_parax // Adapting a par2kax.txt file given overlays database and machine type
+        adapt_parax, // Adapting a par2kax.txt file given overlays database and machine type
+        adapt_fleet, // Adapting the files of all the machine folders in a directory
+        update_fleet // Updating the udt files of all the machine folders to a newer one (target)
        };
 
  private:
-    macotec::MachineData m_mach_data;
+    std::vector<macotec::MachineData> m_machs;
     file_t m_targetfile;
     file_t m_dbfile;
-    fs::path m_outpath;
+    file_t m_paraxdbfile; // Used for a fleet
+    fs::path m_fleetdir;
+    fs::path m_outpath; // Output directory when adapting for multiple machines
+    MachOutputs m_mach_outputs;
     task_type m_task = task_type::unknown;
 
  public:
-    [[nodiscard]] const auto& mach_data() const noexcept { return m_mach_data; }
-    void set_mach_data(const std::string_view sv) { m_mach_data.assign(sv); }
+    [[nodiscard]] const macotec::MachineData& mach_data() const noexcept
+       {
+        static const macotec::MachineData no_mach_data;
+        return m_machs.empty() ? no_mach_data : m_machs.front();
+       }
+    [[nodiscard]] const auto& machs() const noexcept { return m_machs; }
+    [[nodiscard]] bool is_multi_mach() const noexcept { return m_machs.size()>1; }
+    void add_mach_data(const std::string_view sv)
+       {
+        macotec::MachineData mach_data;
+        mach_data.assign(sv);
+        add_mach_data(mach_data);
+       }
+    void add_mach_data(const macotec::MachineData& mach_data)
+       {
+        if( std::ranges::find(m_machs, mach_data)!=m_machs.end() )
+           {
+            throw std::invalid_argument( std::format("Machine type {} was already given", mach_data.string()) );
+           }
+        m_machs.push_back(mach_data);
+       }
+    void add_machs_from_file(const std::string_view pth)
+       {// One machine type per line, skipping empty lines and comments
+        const sys::memory_mapped_file mapped_file{ std::string(pth).c_str() };
+        std::string_view buf = mapped_file.as_string_view();
+        std::size_t line = 0;
+        while( not buf.empty() )
+           {
+            ++line;
+            const std::size_t i_eol = buf.find('\n');
+            std::string_view mach_str = str::trim_right( buf.substr(0, i_eol) );
+            buf.remove_prefix( i_eol==std::string_view::npos ? buf.size() : i_eol+1 );
+            while( not mach_str.empty() and ascii::is_space(mach_str.front()) ) mach_str.remove_prefix(1);
+            if( mach_str.empty() or mach_str.starts_with('#') or mach_str.starts_with("//"sv) )
+               {
+                continue;
+               }
+            try{
+                add_mach_data(mach_str);
+               }
+            catch( std::exception& e )
+               {
+                throw std::invalid_argument( std::format("{}:{} {}", pth, line, e.what()) );
+               }
+           }
+       }
+
+    [[nodiscard]] const auto& mach_outputs() const noexcept { return m_mach_outputs; }
 
     [[nodiscard]] const auto& target_file() const noexcept { return m_targetfile; }
     void set_target_file(const std::string_view sv) { m_targetfile.assign(sv); }
+    void set_target_stdin(const std::string_view nam) { m_targetfile.assign_stdin(nam); }
 
     [[nodiscard]] const auto& db_file() const noexcept { return m_dbfile; }
     void set_db_file(const std::string_view sv) { m_dbfile.assign(sv); }
 
+    [[nodiscard]] const auto& parax_db_file() const noexcept { return m_paraxdbfile; }
+    void set_parax_db_file(const std::string_view sv) { m_paraxdbfile.assign(sv); }
+
+    [[nodiscard]] const auto& fleet_dir() const noexcept { return m_fleetdir; }
+    void set_fleet_dir(const std::string_view sv)
+       {
+        m_fleetdir = sv;
+        if( not fs::is_directory(m_fleetdir) )
+           {
+            throw std::runtime_error( std::format("Fleet directory not found: {}", sv) );
+           }
+       }
+
     [[nodiscard]] const auto& out_path() const noexcept { return m_outpath; }
     void set_out_path(const fs::path& orig_path, const std::string_view outpth)
        {
@@ -119,7 +207,31 @@ class JobUnit final
 
     void detect_task()
        {
-        if( target_file().is_udt() and db_file().is_udt() )
+        if( not fleet_dir().empty() and target_file() )
+           {
+            if( not target_file().is_udt() or db_file() or parax_db_file() )
+               {
+                throw std::invalid_argument("A fleet is updated given just the newer udt file (--tgt)");
+               }
+            m_task = task_type::update_fleet;
+           }
+        else if( not fleet_dir().empty() )
+           {
+            if( db_file() and not db_file().is_txt() )
+               {
+                throw std::invalid_argument( std::format("Not an overlays DB: {}", db_file().path().string()) );
+               }
+            if( not db_file() and not parax_db_file() )
+               {
+                throw std::invalid_argument("A fleet needs the overlays DB of MachSettings.udt (--db) and/or par2kax.txt (--parax-db)");
+               }
+            m_task = task_type::adapt_fleet;
+           }
+        else if( parax_db_file() )
+           {
+            throw std::invalid_argument("The par2kax.txt overlays DB (--parax-db) is used just for a fleet");
+           }
+        else if( target_file().is_udt() and db_file().is_udt() )
            {
             m_task = task_type::update_udt;
            }
@@ -137,9 +249,63 @@ class JobUnit final
            }
        }
 
+    void set_mach_outputs(const std::string_view outdir)
+       {// One output file per machine in the given directory
+        m_outpath = outdir.empty() ? target_file().path().parent_path() : fs::path(outdir);
+        if( m_outpath.empty() )
+           {
+            m_outpath = ".";
+           }
+        if( fs::exists(m_outpath) and not fs::is_directory(m_outpath) )
+           {
+            throw std::invalid_argument( std::format("Output \"{}\" must be a directory when adapting for multiple machines", m_outpath.string()) );
+           }
+        fs::create_directories(m_outpath);
+
+        m_mach_outputs.clear();
+        m_mach_outputs.reserve( m_machs.size() );
+        for( const auto& mach : m_machs )
+           {
+            std::string mach_str = mach.string();
+            std::ranges::replace_if(mach_str, [](const char ch) noexcept { return ch=='/' or ch=='\\' or ch==':' or ch=='*' or ch=='?' or ch=='\"' or ch=='<' or ch=='>' or ch=='|' or ascii::is_space(ch); }, '-');
+            const fs::path out_path = m_outpath / std::format("{}-{}{}", target_file().path().stem().string(), mach_str, target_file().path().extension().string());
+            if( fs::exists(out_path) and (fs::equivalent(out_path, target_file().path()) or fs::equivalent(out_path, db_file().path())) )
+               {
+                throw std::invalid_argument( std::format("Output \"{}\" collides with input file", out_path.string()) );
+               }
+            m_mach_outputs.emplace_back(mach, out_path.string());
+           }
+       }
+
     void ensure_out_path(const std::string_view outpth)
        {
-        if( is_update_udt() )
+        if( is_adapt_fleet() or is_update_fleet() )
+           {
+            if( not m_machs.empty() )
+               {
+                throw std::invalid_argument("Machine shouldn't be specified for a fleet, each MachSettings.udt declares its own");
+               }
+            if( not outpth.empty() )
+               {
+                throw std::invalid_argument("Output shouldn't be specified for a fleet, files are replaced in place");
+               }
+           }
+        else if( is_filter() )
+           {// The result goes to stdout
+            if( is_update_udt() and mach_data() )
+               {
+                throw std::invalid_argument( "Machine shouldn't be specified for a UDT update" );
+               }
+            if( (is_adapt_udt() or is_adapt_parax()) and (m_machs.size()!=1 or mach_data().is_incomplete()) )
+               {
+                throw std::invalid_argument("A single complete machine is expected when reading from stdin");
+               }
+            if( not outpth.empty() )
+               {
+                throw std::invalid_argument("Output shouldn't be specified when reading from stdin, goes to stdout");
+               }
+           }
+        else if( is_update_udt() )
            {
             if( mach_data() )
                {
@@ -149,21 +315,34 @@ class JobUnit final
            }
         else if( is_adapt_udt() or is_adapt_parax() )
            {
-            if( not mach_data() )
+            if( m_machs.empty() )
                {
                 throw std::invalid_argument("Machine not specified");
                }
-            else if( mach_data().is_incomplete() )
+            for( const auto& mach : m_machs )
+               {
+                if( mach.is_incomplete() )
+                   {
+                    throw std::invalid_argument( std::format("Machine data incomplete: {}", mach.string()) );
+                   }
+               }
+            if( is_multi_mach() )
+               {
+                set_mach_outputs(outpth);
+               }
+            else
                {
-                throw std::invalid_argument( std::format("Machine data incomplete: {}", mach_data().string()) );
+                set_out_path(target_file().path(), outpth);
                }
-            set_out_path(target_file().path(), outpth);
            }
        }
 
     [[nodiscard]] bool is_update_udt() const noexcept { return m_task == task_type::update_udt; }
     [[nodiscard]] bool is_adapt_udt() const noexcept { return m_task == task_type::adapt_udt; }
     [[nodiscard]] bool is_adapt_parax() const noexcept { return m_task == task_type::adapt_parax; }
+    [[nodiscard]] bool is_adapt_fleet() const noexcept { return m_task == task_type::adapt_fleet; }
+    [[nodiscard]] bool is_update_fleet() const noexcept { return m_task == task_type::update_fleet; }
+    [[nodiscard]] bool is_filter() const noexcept { return m_targetfile.is_stdin(); } // stdin to stdout
 };
 
 }//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
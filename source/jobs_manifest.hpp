@@ -0,0 +1,441 @@
+﻿#pragma once
+//  ---------------------------------------------
+//  Run concurrently the jobs listed in a
+//  manifest file, parsing just once the inputs
+//  shared by more jobs
+//  ---------------------------------------------
+//  #include "jobs_manifest.hpp" // app::run_jobs_manifest(), app::run_jobs()
+//  ---------------------------------------------
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <memory> // std::shared_ptr
+#include <functional> // std::function
+#include <format>
+#include <stdexcept> // std::runtime_error, std::invalid_argument
+#include <filesystem> // std::filesystem
+
+#include "memory_mapped_file.hpp" // sys::memory_mapped_file
+#include "json_parser.hpp" // json::parse()
+#include "options_set.hpp" // MG::options_set
+#include "thread_pool.hpp" // MG::thread_pool
+#include "parallel_for.hpp" // MG::parallel_for()
+#include "job_unit.hpp" // app::JobUnit
+#include "adapt_udt_file.hpp" // app::overlay_adapted_udt()
+#include "adapt_parax_file.hpp" // app::overlay_parax_for()
+#include "handle_output_file.hpp" // app::handle_output_file()
+
+namespace fs = std::filesystem;
+using namespace std::literals; // "..."sv
+
+
+namespace app //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+/////////////////////////////////////////////////////////////////////////////
+class NamedJob final
+{
+ private:
+    std::string m_name;
+    JobUnit m_job;
+
+ public:
+    explicit NamedJob(const std::string_view nam)
+      : m_name{nam}
+       {}
+
+    explicit NamedJob(const std::string_view nam, const JobUnit& job)
+      : m_name{nam}
+      , m_job{job}
+       {}
+
+    [[nodiscard]] const std::string& name() const noexcept { return m_name; }
+    [[nodiscard]] const JobUnit& job() const noexcept { return m_job; }
+    [[nodiscard]] JobUnit& job() noexcept { return m_job; }
+
+    // The file that the output will replace, if any
+    [[nodiscard]] const fs::path& replaced_file() const noexcept
+       {
+        return empty_if_or(not is_temp(m_job.out_path()), m_job.is_update_udt() ? m_job.db_file().path() : m_job.target_file().path());
+       }
+};
+
+
+//---------------------------------------------------------------------------
+// A manifest lists named jobs, paths are relative to its directory:
+//   adapt-hp: { tgt: "MachSettings.udt", db: "overlays.txt", mach: "HP-6.0/4.6-(lowe)", out: "hp/MachSettings.udt" }
+//   update: { tgt: "new/MachSettings.udt", db: "old/MachSettings.udt" }
+// Without an output the original file is replaced after a backup copy
+[[nodiscard]] std::vector<NamedJob> read_jobs_manifest(const std::string& manifest_path, fnotify_t const& notify_issue)
+{
+    json::Node root;
+       {
+        const sys::memory_mapped_file manifest_buf(manifest_path.c_str());
+        json::parse(manifest_path, manifest_buf.as_string_view(), root, notify_issue);
+       }
+
+    const fs::path base_dir = fs::path(manifest_path).parent_path();
+    const auto full_path_of = [&base_dir](const std::string_view pth) -> std::string { return (base_dir / pth).string(); };
+
+    std::vector<NamedJob> jobs;
+    jobs.reserve( root.childs().size() );
+    for( const auto& [job_name, job_node] : root.childs() )
+       {
+        try{
+            if( not job_node.has_childs() )
+               {
+                throw std::runtime_error("Not a block of fields");
+               }
+            NamedJob& named_job = jobs.emplace_back(job_name);
+            std::string out_path;
+            for( const auto& [key, field] : job_node.childs() )
+               {
+                if( not field.is_leaf() )
+                   {
+                    throw std::runtime_error( std::format("Field `{}` hasn't a value", key) );
+                   }
+                else if( key=="tgt"sv or key=="target"sv )
+                   {
+                    named_job.job().set_target_file( full_path_of(field.value()) );
+                   }
+                else if( key=="db"sv )
+                   {
+                    named_job.job().set_db_file( full_path_of(field.value()) );
+                   }
+                else if( key=="mach"sv or key=="machine"sv )
+                   {
+                    named_job.job().add_mach_data( field.value() );
+                   }
+                else if( key=="out"sv or key=="to"sv )
+                   {
+                    out_path = full_path_of(field.value());
+                   }
+                else
+                   {
+                    throw std::runtime_error( std::format("Unknown field `{}`", key) );
+                   }
+               }
+            named_job.job().detect_task();
+            named_job.job().ensure_out_path(out_path);
+           }
+        catch( std::exception& e )
+           {
+            throw std::invalid_argument( std::format("{} job `{}`: {}", manifest_path, job_name, e.what()) );
+           }
+       }
+    return jobs;
+}
+
+
+//---------------------------------------------------------------------------
+// The jobs given on the command line are named after their targets
+[[nodiscard]] std::vector<NamedJob> named_after_targets(const std::vector<JobUnit>& jobs)
+{
+    std::vector<NamedJob> named_jobs;
+    named_jobs.reserve( jobs.size() );
+    for( const JobUnit& job : jobs )
+       {
+        named_jobs.emplace_back(job.target_file().path().filename().string(), job);
+       }
+    return named_jobs;
+}
+
+
+//---------------------------------------------------------------------------
+// Jobs can run concurrently only if none writes what others use
+void check_jobs_independence(const std::vector<NamedJob>& jobs)
+{
+    std::map<fs::path, const NamedJob*> writers;
+    for( const auto& named_job : jobs )
+       {
+        for( const fs::path& pth : {named_job.job().out_path(), named_job.replaced_file()} )
+           {
+            if( pth.empty() ) continue;
+            if( const auto [it, inserted] = writers.try_emplace(fs::weakly_canonical(pth), &named_job); not inserted and it->second!=&named_job )
+               {
+                throw std::invalid_argument( std::format("Jobs `{}` and `{}` write the same file: {}", it->second->name(), named_job.name(), pth.string()) );
+               }
+           }
+       }
+
+    for( const auto& named_job : jobs )
+       {
+        for( const fs::path& pth : {named_job.job().target_file().path(), named_job.job().db_file().path()} )
+           {
+            if( const auto it=writers.find(fs::weakly_canonical(pth)); it!=writers.end() and it->second!=&named_job )
+               {
+                throw std::invalid_argument( std::format("Jobs `{}` and `{}` aren't independent: {}", it->second->name(), named_job.name(), pth.string()) );
+               }
+           }
+       }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// The parsed input files, shared read-only by the jobs
+class JobsInputs final
+{
+ private:
+    std::map<fs::path, std::shared_ptr<const macotec::ParamsDB>> m_dbs;
+    std::map<fs::path, std::shared_ptr<const udt::File>> m_udts;
+    std::map<fs::path, std::shared_ptr<const parax::File>> m_paraxs;
+
+ public:
+    //-----------------------------------------------------------------------
+    // Parse concurrently each distinct input
+    void load(const std::vector<NamedJob>& jobs, MG::thread_pool& pool, fnotify_t const& notify_issue)
+       {
+        for( const auto& named_job : jobs )
+           {
+            const JobUnit& job = named_job.job();
+            if( job.is_update_udt() )
+               {
+                m_udts.try_emplace( key_of(job.target_file().path()) );
+                m_udts.try_emplace( key_of(job.db_file().path()) );
+               }
+            else if( job.is_adapt_udt() )
+               {
+                m_udts.try_emplace( key_of(job.target_file().path()) );
+                m_dbs.try_emplace( key_of(job.db_file().path()) );
+               }
+            else if( job.is_adapt_parax() )
+               {
+                m_paraxs.try_emplace( key_of(job.target_file().path()) );
+                m_dbs.try_emplace( key_of(job.db_file().path()) );
+               }
+           }
+
+        std::vector<std::function<void()>> loaders;
+        loaders.reserve( size() );
+        for( auto& [pth, db] : m_dbs ) loaders.emplace_back([&pth, &db, &notify_issue]{ db = std::make_shared<const macotec::ParamsDB>(pth.string(), notify_issue, macotec::ParamsDB::parsing::indexed); });
+        for( auto& [pth, udt_file] : m_udts ) loaders.emplace_back([&pth, &udt_file, &notify_issue]{ udt_file = std::make_shared<const udt::File>(pth.string(), notify_issue); });
+        for( auto& [pth, parax_file] : m_paraxs ) loaders.emplace_back([&pth, &parax_file, &notify_issue]{ parax_file = std::make_shared<const parax::File>(pth.string(), notify_issue); });
+        MG::parallel_for(pool, loaders.size(), [&loaders](const std::size_t idx){ loaders[idx](); });
+       }
+
+    [[nodiscard]] std::size_t size() const noexcept { return m_dbs.size() + m_udts.size() + m_paraxs.size(); }
+
+    [[nodiscard]] std::shared_ptr<const macotec::ParamsDB> db(const fs::path& pth) const { return m_dbs.at(key_of(pth)); }
+    [[nodiscard]] std::shared_ptr<const udt::File> udt_file(const fs::path& pth) const { return m_udts.at(key_of(pth)); }
+    [[nodiscard]] std::shared_ptr<const parax::File> parax_file(const fs::path& pth) const { return m_paraxs.at(key_of(pth)); }
+
+ private:
+    [[nodiscard]] static fs::path key_of(const fs::path& pth) { return fs::weakly_canonical(pth); }
+};
+
+
+//---------------------------------------------------------------------------
+// Returns the report line of the job
+[[nodiscard]] std::string run_job(const NamedJob& named_job, const JobsInputs& inputs, const MG::options_set& options, fnotify_t const& notify_issue)
+{
+    const JobUnit& job = named_job.job();
+    sipro::TxtOverlay overlay;
+    if( job.is_update_udt() )
+       {
+        const auto new_udt_file = inputs.udt_file( job.target_file().path() );
+        new_udt_file->overwrite_values_from( *inputs.udt_file(job.db_file().path()), overlay );
+        new_udt_file->write_to( job.out_path().string(), overlay, options );
+       }
+    else if( job.is_adapt_udt() )
+       {
+        const auto udt_file = inputs.udt_file( job.target_file().path() );
+        overlay_adapted_udt( *udt_file, *inputs.db(job.db_file().path()), job.mach_data(), overlay, notify_issue );
+        udt_file->write_to( job.out_path().string(), overlay, options );
+       }
+    else if( job.is_adapt_parax() )
+       {
+        const auto parax_file = inputs.parax_file( job.target_file().path() );
+        overlay_parax_for( *parax_file, *inputs.db(job.db_file().path()), job.mach_data(), overlay, notify_issue );
+        parax_file->write_to( job.out_path().string(), overlay, options, std::format("Machine: {}", job.mach_data().string()) );
+       }
+    return std::format("  {}: modified {} values, {} issues => {}\n", named_job.name(), overlay.modified_values_count(), overlay.mod_issues().size(), job.out_path().string());
+}
+
+
+//---------------------------------------------------------------------------
+// Run concurrently independent jobs, the outputs that replace an
+// original file are handled at the end, after the inputs are released
+template<typename FPRINT>
+void run_jobs( const std::vector<NamedJob>& jobs,
+               const MG::options_set& options,
+               const bool quiet,
+               FPRINT const& verbose_print,
+               fnotify_t const& notify_issue )
+{
+    check_jobs_independence(jobs);
+
+    const fnotify_t notify_issue_mt = MG::make_thread_safe(notify_issue);
+    std::vector<std::string> reports( jobs.size() ); // Empty if job failed
+       {
+        MG::thread_pool pool;
+        JobsInputs inputs;
+        inputs.load(jobs, pool, notify_issue_mt);
+        verbose_print("  {} jobs, {} distinct inputs\n", jobs.size(), inputs.size());
+
+        for( std::size_t i=0; i<jobs.size(); ++i )
+           {
+            pool.submit([&, i]
+               {
+                const NamedJob& named_job = jobs[i];
+                try{
+                    reports[i] = run_job(named_job, inputs, options, [&notify_issue_mt, &named_job](std::string&& msg){ notify_issue_mt( std::format("{}: {}", named_job.name(), msg) ); });
+                   }
+                catch( std::exception& e )
+                   {
+                    notify_issue_mt( std::format("{}: {}", named_job.name(), e.what()) );
+                   }
+               });
+           }
+        pool.wait();
+       } // Inputs released
+
+    for( std::size_t i=0; i<jobs.size(); ++i )
+       {
+        if( not reports[i].empty() )
+           {
+            if( const fs::path& replaced = jobs[i].replaced_file(); not replaced.empty() )
+               {
+                handle_output_file(quiet, jobs[i].job().out_path(), replaced);
+               }
+            verbose_print("{}", reports[i]);
+           }
+       }
+}
+
+
+//---------------------------------------------------------------------------
+template<typename FPRINT>
+void run_jobs_manifest( const std::string& manifest_file,
+                        const MG::options_set& options,
+                        FPRINT const& verbose_print,
+                        fnotify_t const& notify_issue )
+{
+    run_jobs( read_jobs_manifest(manifest_file, notify_issue), options, true, verbose_print, notify_issue );
+}
+
+}//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+#ifdef TEST_UNITS ///////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+#include "arguments.hpp" // app::Arguments
+/////////////////////////////////////////////////////////////////////////////
+static ut::suite<"jobs_manifest"> jobs_manifest_tests = []
+{////////////////////////////////////////////////////////////////////////////
+
+struct issues_t final { int num=0; void operator()(std::string&& msg) noexcept {++num; ut::log << msg << '\n';}; };
+
+ut::test("app::run_jobs_manifest()") = []
+   {
+    test::TemporaryDirectory tmp_dir;
+
+    const auto udt = tmp_dir.create_file("template.udt",
+        "va0 = \"W\" # Mandatory field 'vaMachName'\n"
+        "vn123 = 0 # Should be overwritten 'vnType'\n"sv);
+    const auto udt_old = tmp_dir.create_file("old.udt",
+        "va0 = \"W\" # Mandatory field 'vaMachName'\n"
+        "vn123 = old # Should be overwritten 'vnType'\n"sv);
+    const auto udt_new = tmp_dir.create_file("new.udt",
+        "va0 = \"W\" # Mandatory field 'vaMachName'\n"
+        "vn123 = new # Should be overwritten 'vnType'\n"sv);
+    const auto db = tmp_dir.create_file("overlays.txt",
+        "HP:{\n"
+        "    \"common\": { vnType: 11 }\n"
+        "    \"cut-bridge\" : { \"6.0\": { vnType: 11 } }\n"
+        "    \"algn-span\" : { \"4.6\": { vnType: 11 } }\n"
+        "   }\n"
+        "W:{\n"
+        "    \"common\": { vnType: 10 }\n"
+        "    \"cut-bridge\" : { \"4.9\": { vnType: 10 } }\n"
+        "    \"algn-span\" : { \"3.2\": { vnType: 10 } }\n"
+        "   }\n"sv);
+
+    const auto manifest = tmp_dir.create_file("jobs.txt",
+        "hp: { tgt: template.udt, db: overlays.txt, mach: \"HP-6.0/4.6\", out: hp.udt }\n"
+        "w: { tgt: template.udt, db: overlays.txt, mach: \"W-4.9/3.2\", out: w.udt }\n"
+        "update: { tgt: new.udt, db: old.udt }\n"sv);
+    const auto out_hp = tmp_dir.decl_file("hp.udt");
+    const auto out_w = tmp_dir.decl_file("w.udt");
+
+    issues_t issues;
+    app::run_jobs_manifest( manifest.path().string(), {}, [](const std::string_view, const auto&...){}, std::ref(issues) );
+    ut::expect( ut::that % issues.num==0 ) << "no issues expected\n";
+
+    issues_t reparse_issues;
+    check_field(udt::File(out_hp.path().string(), std::ref(reparse_issues)), "vn123"sv, "11"sv, "Should be overwritten"sv, "vnType"sv);
+    check_field(udt::File(out_w.path().string(), std::ref(reparse_issues)), "vn123"sv, "10"sv, "Should be overwritten"sv, "vnType"sv);
+    check_field(udt::File(udt_old.path().string(), std::ref(reparse_issues)), "vn123"sv, "old"sv, "Should be overwritten"sv, "vnType"sv);
+    check_field(udt::File(udt.path().string(), std::ref(reparse_issues)), "vn123"sv, "0"sv, "Should be overwritten"sv, "vnType"sv);
+    ut::expect( ut::that % reparse_issues.num==0 ) << "no issues expected\n";
+    ut::expect( fs::exists(udt_old.path().string() + ".bck") ) << "updated file should be backed up\n";
+   };
+
+
+ut::test("app::run_jobs() of target/db pairs") = []
+   {
+    test::TemporaryDirectory tmp_dir;
+
+    const auto udt = tmp_dir.create_file("MachSettings.udt",
+        "va0 = \"HP-6.0/4.6\" # Mandatory field 'vaMachName'\n"
+        "vn123 = 0 # Should be overwritten 'vnType'\n"sv);
+    const auto parax = tmp_dir.create_file("par2kax.txt",
+        "[StartEthercatAx]\n"
+        "  Name = \"Xr\"\n"
+        "  InvDir = 0\n"
+        "[EndEthercatAx]\n"sv);
+    const auto udt_db = tmp_dir.create_file("udt-overlays.txt",
+        "HP:{\n"
+        "    \"common\": { vnType: 11 }\n"
+        "   }\n"sv);
+    const auto parax_db = tmp_dir.create_file("parax-overlays.txt",
+        "HP:{\n"
+        "    common: { Xr: { InvDir = 1 } }\n"
+        "   }\n"sv);
+
+    const std::string udt_path{ udt.path().string() };
+    const std::string parax_path{ parax.path().string() };
+    const std::string udt_db_path{ udt_db.path().string() };
+    const std::string parax_db_path{ parax_db.path().string() };
+    const std::string out_dir{ (tmp_dir.path() / "out").string() };
+    const char* const argv[] = { "m32-pars-adapt", "--tgt", udt_path.c_str(), "--db", udt_db_path.c_str(),
+                                 "--tgt", parax_path.c_str(), "--db", parax_db_path.c_str(), "--mach", "HP-6.0/4.6", "--out", out_dir.c_str() };
+    app::Arguments args;
+    args.parse(static_cast<int>(std::size(argv)), argv);
+    ut::expect( ut::fatal(ut::that % args.jobs().size()==2u) );
+    ut::expect( args.jobs()[1].is_adapt_parax() );
+    ut::expect( args.jobs()[1].mach_data()==args.jobs()[0].mach_data() ) << "same machine expected\n";
+
+    issues_t issues;
+    app::run_jobs( app::named_after_targets(args.jobs()), {}, true, [](const std::string_view, const auto&...){}, std::ref(issues) );
+    ut::expect( ut::that % issues.num==0 ) << "no issues expected\n";
+
+    issues_t reparse_issues;
+    check_field(udt::File((tmp_dir.path() / "out/MachSettings.udt").string(), std::ref(reparse_issues)), "vn123"sv, "11"sv, "Should be overwritten"sv, "vnType"sv);
+    parax::File adapted_parax((tmp_dir.path() / "out/par2kax.txt").string(), std::ref(reparse_issues));
+    check_field(adapted_parax, "Xr"sv, "InvDir"sv, "1"sv);
+    ut::expect( ut::that % reparse_issues.num==0 ) << "no issues expected\n";
+   };
+
+
+ut::test("dependent jobs") = []
+   {
+    test::TemporaryDirectory tmp_dir;
+
+    const auto udt_old = tmp_dir.create_file("old.udt", "vn123 = old # Type 'vnType'\n"sv);
+    const auto udt_new = tmp_dir.create_file("new.udt", "vn123 = new # Type 'vnType'\n"sv);
+    const auto manifest = tmp_dir.create_file("jobs.txt",
+        "first: { tgt: new.udt, db: old.udt, out: mid.udt }\n"
+        "second: { tgt: mid.udt, db: old.udt, out: last.udt }\n"sv);
+    const auto out_mid = tmp_dir.create_file("mid.udt", "vn123 = mid # Type 'vnType'\n"sv);
+
+    issues_t issues;
+    ut::expect( ut::throws<std::invalid_argument>([&]{ app::run_jobs_manifest( manifest.path().string(), {}, [](const std::string_view, const auto&...){}, std::ref(issues) ); }) ) << "should refuse dependent jobs\n";
+   };
+
+};///////////////////////////////////////////////////////////////////////////
+#endif // TEST_UNITS ////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
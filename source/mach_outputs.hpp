@@ -0,0 +1,36 @@
+﻿#pragma once
+//  ---------------------------------------------
+//  Output files of an adaptation done for
+//  a batch of machines
+//  ---------------------------------------------
+//  #include "mach_outputs.hpp" // app::MachOutput
+//  ---------------------------------------------
+#include <string>
+#include <vector>
+
+#include "macotec_machine_data.hpp" // macotec::MachineData
+
+
+namespace app //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+/////////////////////////////////////////////////////////////////////////////
+class MachOutput final
+{
+ private:
+    macotec::MachineData m_mach_data;
+    std::string m_path;
+
+ public:
+    explicit MachOutput(const macotec::MachineData& mach, std::string&& pth)
+      : m_mach_data{mach}
+      , m_path{std::move(pth)}
+       {}
+
+    [[nodiscard]] const macotec::MachineData& mach_data() const noexcept { return m_mach_data; }
+    [[nodiscard]] const std::string& path() const noexcept { return m_path; }
+};
+
+using MachOutputs = std::vector<MachOutput>;
+
+}//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
@@ -5,15 +5,18 @@
 //  #include "macotec_machine_data.hpp" // macotec::MachineData
 //  ---------------------------------------------
 #include <stdexcept>
-#include <cstdint> // std::uint8_t
-#include <cmath> // std::fabs, ...
+#include <cstdint> // std::uint8_t, std::uint32_t
 #include <string>
 #include <string_view>
 #include <array>
+#include <utility> // std::pair
+#include <optional>
+#include <bit> // std::bit_ceil
+#include <algorithm> // std::ranges::transform
 #include <format>
 
 #include "options_set.hpp" // MG::options_set
-#include "string_utilities.hpp" // str::tolower
+#include "ascii_predicates.hpp" // ascii::to_lower, ascii::is_digit
 #include "ascii_simple_lexer.hpp" // ascii::simple_lexer
 
 using namespace std::literals; // "..."sv
@@ -24,6 +27,151 @@ using namespace std::literals; // "..."sv
 namespace macotec //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 {
 
+namespace details //::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+    //-----------------------------------------------------------------------
+    // Case insensitive FNV-1a, seeded to search a perfect hash
+    [[nodiscard]] constexpr std::uint32_t seeded_hash_of(const std::string_view sv, const std::uint32_t seed) noexcept
+       {
+        std::uint32_t h = 2166136261u ^ seed;
+        for( const char c : sv )
+           {
+            h ^= static_cast<std::uint8_t>(ascii::to_lower(c));
+            h *= 16777619u;
+           }
+        return h;
+       }
+
+    //-----------------------------------------------------------------------
+    [[nodiscard]] constexpr bool equals_ignoring_case(const std::string_view a, const std::string_view b) noexcept
+       {
+        return a.size()==b.size() and std::ranges::equal(a, b, [](const char ca, const char cb) noexcept { return ascii::to_lower(ca)==ascii::to_lower(cb); });
+       }
+
+
+    /////////////////////////////////////////////////////////////////////////
+    // Few known keys (case insensitive) in a table without collisions,
+    // the seed of the hash is searched at compile time. Empty keys are
+    // ignored, a missing key gives T{}
+    template<typename T, std::size_t N>
+    class PerfectHashMap final
+    {
+        static constexpr std::size_t slots_count = std::bit_ceil(4*N);
+        std::array<std::string_view, slots_count> m_keys{};
+        std::array<T, slots_count> m_values{};
+        std::uint32_t m_seed = 0;
+
+     public:
+        consteval explicit PerfectHashMap(const std::array<std::pair<std::string_view,T>, N>& entries)
+           {
+            while( not try_fill(entries) )
+               {
+                if( ++m_seed>100000 ) throw "No perfect hash found"; // Fails the compilation
+               }
+           }
+
+        [[nodiscard]] constexpr T find(const std::string_view key) const noexcept
+           {
+            const std::size_t slot = seeded_hash_of(key, m_seed) & (slots_count-1);
+            return equals_ignoring_case(m_keys[slot], key) and not key.empty() ? m_values[slot] : T{};
+           }
+
+     private:
+        [[nodiscard]] consteval bool try_fill(const std::array<std::pair<std::string_view,T>, N>& entries)
+           {
+            m_keys.fill({});
+            for( const auto& [key, value] : entries )
+               {
+                if( key.empty() ) continue;
+                const std::size_t slot = seeded_hash_of(key, m_seed) & (slots_count-1);
+                if( not m_keys[slot].empty() ) return false; // Collision
+                m_keys[slot] = key;
+                m_values[slot] = value;
+               }
+            return true;
+           }
+    };
+
+
+    /////////////////////////////////////////////////////////////////////////
+    // Lowercase copy of a token, not allocating for the usual short ones
+    class LowercaseToken final
+    {
+        std::array<char,32> m_buf{};
+        std::string m_long_buf;
+        std::string_view m_view;
+
+     public:
+        constexpr explicit LowercaseToken(const std::string_view sv)
+           {
+            char* const dst = sv.size()<=m_buf.size() ? m_buf.data() : (m_long_buf.resize(sv.size()), m_long_buf.data());
+            std::ranges::transform(sv, dst, [](const char c) noexcept { return ascii::to_lower(c); });
+            m_view = {dst, sv.size()};
+           }
+        LowercaseToken(const LowercaseToken&) =delete; // m_view refers to this
+        LowercaseToken& operator=(const LowercaseToken&) =delete;
+
+        [[nodiscard]] constexpr std::string_view view() const noexcept { return m_view; }
+    };
+
+
+    //-----------------------------------------------------------------------
+    // The value of a dimension like "4.9", in tenths
+    [[nodiscard]] constexpr std::optional<std::uint8_t> tenths_of(const std::string_view token) noexcept
+       {
+        if( token.size()==3 and ascii::is_digit(token[0]) and token[1]=='.' and ascii::is_digit(token[2]) )
+           {
+            return static_cast<std::uint8_t>(10*ascii::value_of_digit(token[0]) + ascii::value_of_digit(token[2]));
+           }
+        return {};
+       }
+
+    //-----------------------------------------------------------------------
+    // The value of a generic dimension token (digits, possibly decimals)
+    [[nodiscard]] constexpr double value_of_dimension(const std::string_view token) noexcept
+       {
+        double val = 0.0;
+        std::size_t i = 0;
+        for( ; i<token.size() and ascii::is_digit(token[i]); ++i )
+           {
+            val = (10.0 * val) + ascii::value_of_digit(token[i]);
+           }
+        if( i<token.size() and token[i]=='.' )
+           {
+            double k = 0.1;
+            for( ++i; i<token.size() and ascii::is_digit(token[i]); ++i )
+               {
+                val += k * ascii::value_of_digit(token[i]);
+                k *= 0.1;
+               }
+           }
+        return val;
+       }
+
+    //-----------------------------------------------------------------------
+    // The category of each "D.D" dimension, precomputed with the same
+    // arithmetic of value_of_dimension() so the results are identical
+    template<typename T, typename FCATEGORY>
+    [[nodiscard]] consteval std::array<T,100> tenths_table(FCATEGORY const& category_of)
+       {
+        std::array<T,100> table{};
+        for( std::size_t t=0; t<table.size(); ++t )
+           {
+            table[t] = category_of( static_cast<double>(t/10) + 0.1*static_cast<double>(t%10) );
+           }
+        return table;
+       }
+
+    //-----------------------------------------------------------------------
+    [[nodiscard]] constexpr bool dims_match(const double dim, const double other_dim) noexcept
+       {
+        const double diff = dim - other_dim;
+        return diff<0.2 and diff>-0.2;
+       }
+}//::::::::::::::::::::::::::::::::: details ::::::::::::::::::::::::::::::::::
+
+
+
 /////////////////////////////////////////////////////////////////////////////
 class MachineFamily final
 {
@@ -72,47 +220,82 @@ class MachineFamily final
  private:
     family m_family = family::undefined;
 
- public:
-    [[nodiscard]] constexpr bool operator==(const MachineFamily other) const noexcept { return m_family==other.m_family; }
-
-    void assign(const std::string_view sv)
+    //-----------------------------------------------------------------------
+    // Tells the family from a lowercase string, undefined if not recognized
+    [[nodiscard]] static constexpr family family_of(const std::string_view sv) noexcept
        {
         if( sv.ends_with("hp") )
            {
-            m_family = family::acthp;
+            return family::acthp;
            }
         else if( sv.ends_with("wr") )
            {
-            m_family = family::actwr;
+            return family::actwr;
            }
         else if( sv.ends_with("w") )
            {
-            m_family = family::actw;
+            return family::actw;
            }
         else if( sv.contains("act") and (sv.ends_with("frs") or sv.ends_with("fr")) )
            {
-            m_family = family::actfr;
+            return family::actfr;
            }
         else if( (sv.contains("act") and (sv.ends_with('f') or sv.ends_with('e'))) or
                  (sv.contains("strato") and sv.ends_with('s')) )
            {
-            m_family = family::actf;
+            return family::actf;
            }
         else if( sv.ends_with("frv") )
            {
-            m_family = family::msfrv;
+            return family::msfrv;
            }
         else if( sv.ends_with("fr") and sv.contains('m') )
            {
-            m_family = family::msfr;
+            return family::msfr;
            }
         else if( sv.contains("starcut") or sv.contains("stc") )
            {
-            m_family = family::scut;
+            return family::scut;
            }
-        else
+        return family::undefined;
+       }
+
+    //-----------------------------------------------------------------------
+    // The exact names and ids are looked up in a perfect hash table,
+    // undefined for the other spellings
+    [[nodiscard]] static family family_of_known_name(const std::string_view sv) noexcept
+       {
+        static constexpr details::PerfectHashMap<family, 2*mach_names.size()> known_names = []() consteval
            {
-            throw std::runtime_error( std::format("Unrecognized machine: {}", sv) );
+            std::array<std::pair<std::string_view,family>, 2*mach_names.size()> entries{};
+            std::size_t n = 0;
+            const auto add_if_recognized = [&entries, &n](const std::string_view name, const family fam)
+               {// Just the names that family_of() also recognizes, to behave the same
+                if( family_of(details::LowercaseToken(name).view())==fam ) entries[n++] = {name, fam};
+               };
+            for( std::size_t i=1; i<mach_names.size(); ++i )
+               {
+                add_if_recognized(mach_names[i], static_cast<family>(i));
+                add_if_recognized(mach_ids[i], static_cast<family>(i));
+               }
+            return details::PerfectHashMap<family, 2*mach_names.size()>(entries);
+           }();
+        return known_names.find(sv);
+       }
+
+ public:
+    [[nodiscard]] constexpr bool operator==(const MachineFamily other) const noexcept { return m_family==other.m_family; }
+
+    void assign(const std::string_view sv)
+       {
+        m_family = family_of_known_name(sv);
+        if( m_family==family::undefined )
+           {
+            m_family = family_of(details::LowercaseToken(sv).view());
+            if( m_family==family::undefined )
+               {
+                throw std::runtime_error( std::format("Unrecognized machine: {}", sv) );
+               }
            }
        }
 
@@ -141,6 +324,7 @@ class MachineFamily final
 
     [[nodiscard]] constexpr std::string_view id_string() const noexcept { return mach_ids[std::to_underlying(m_family)]; }
     [[nodiscard]] constexpr std::string_view name() const noexcept { return mach_names[std::to_underlying(m_family)]; }
+
 };
 
 
@@ -172,31 +356,47 @@ class CutBridgeDim final
  private:
     cutbridgedim m_dim_category = cutbridgedim::undefined;
 
- public:
-    [[nodiscard]] constexpr bool operator==(const CutBridgeDim other) const noexcept { return m_dim_category==other.m_dim_category; }
-
-    void assign(const double dim, const MachineFamily mach_family)
+    [[nodiscard]] static constexpr cutbridgedim category_of(const double dim, const bool is_strato_f) noexcept
        {
         // Le misure riconosciute sono: 4.0, 4.9, 6.0 (ActiveW)
         //                              3.7, 4.6 (ActiveF)
-        auto matches = [dim](const double other_dim) noexcept -> bool
+        if( is_strato_f )
            {
-            return std::fabs(dim-other_dim) < 0.2;
-           };
+                 if( details::dims_match(dim, 3.7) ) return cutbridgedim::c37;
+            else if( details::dims_match(dim, 4.6) ) return cutbridgedim::c46;
+           }
+        else
+           {
+                 if( details::dims_match(dim, 4.0) ) return cutbridgedim::c40;
+            else if( details::dims_match(dim, 4.9) ) return cutbridgedim::c49;
+            else if( details::dims_match(dim, 6.0) ) return cutbridgedim::c60;
+           }
+        return cutbridgedim::undefined;
+       }
 
-        if( mach_family.is_strato_f() )
+ public:
+    [[nodiscard]] constexpr bool operator==(const CutBridgeDim other) const noexcept { return m_dim_category==other.m_dim_category; }
+
+    void assign(const double dim, const MachineFamily mach_family)
+       {
+        m_dim_category = category_of(dim, mach_family.is_strato_f());
+        if( m_dim_category==cutbridgedim::undefined )
            {
-                 if( matches(3.7) ) m_dim_category = cutbridgedim::c37;
-            else if( matches(4.6) ) m_dim_category = cutbridgedim::c46;
-            else throw std::runtime_error( std::format("Unrecognized {} cut bridge size: {}", mach_family.name(), dim) );
+            throw std::runtime_error( std::format("Unrecognized {} cut bridge size: {}", mach_family.name(), dim) );
            }
-        else
+       }
+
+    // The usual dimensions like "4.9" are looked up in precomputed tables
+    void assign(const std::string_view token, const MachineFamily mach_family)
+       {
+        static constexpr auto strato_f_table = details::tenths_table<cutbridgedim>([](const double dim) consteval { return category_of(dim, true); });
+        static constexpr auto others_table = details::tenths_table<cutbridgedim>([](const double dim) consteval { return category_of(dim, false); });
+        if( const auto tenths = details::tenths_of(token) )
            {
-                 if( matches(4.0) ) m_dim_category = cutbridgedim::c40;
-            else if( matches(4.9) ) m_dim_category = cutbridgedim::c49;
-            else if( matches(6.0) ) m_dim_category = cutbridgedim::c60;
-            else throw std::runtime_error( std::format("Unrecognized {} cut bridge size: {}", mach_family.name(), dim) );
+            m_dim_category = (mach_family.is_strato_f() ? strato_f_table : others_table)[*tenths];
+            if( m_dim_category!=cutbridgedim::undefined ) return;
            }
+        assign(details::value_of_dimension(token), mach_family);
        }
 
     [[nodiscard]] constexpr bool is_defined() const noexcept { return m_dim_category!=cutbridgedim::undefined; }
@@ -207,6 +407,7 @@ class CutBridgeDim final
     [[nodiscard]] constexpr bool is_60() const noexcept { return m_dim_category == cutbridgedim::c60; }
 
     [[nodiscard]] constexpr std::string_view string() const noexcept { return cutbridgedim_ids[std::to_underlying(m_dim_category)]; }
+
 };
 
 
@@ -232,21 +433,37 @@ class AlignSpanDim final
  private:
     aligndim m_dim_category = aligndim::undefined;
 
+    [[nodiscard]] static constexpr aligndim category_of(const double dim) noexcept
+       {
+        // Le misure riconosciute sono: 3.2, 4.6 (ActiveW)
+        //                              3.2 (ActiveF)
+             if( details::dims_match(dim, 3.2) ) return aligndim::a32;
+        else if( details::dims_match(dim, 4.6) ) return aligndim::a46;
+        return aligndim::undefined;
+       }
+
  public:
     [[nodiscard]] constexpr bool operator==(const AlignSpanDim other) const noexcept { return m_dim_category==other.m_dim_category; }
 
     void assign(const double dim)
        {
-        // Le misure riconosciute sono: 3.2, 4.6 (ActiveW)
-        //                              3.2 (ActiveF)
-        auto matches = [dim](const double other_dim) noexcept -> bool
+        m_dim_category = category_of(dim);
+        if( m_dim_category==aligndim::undefined )
            {
-            return std::fabs(dim-other_dim) < 0.2;
-           };
+            throw std::runtime_error( std::format("Unrecognized align size: {}",dim) );
+           }
+       }
 
-             if( matches(3.2) ) m_dim_category = aligndim::a32;
-        else if( matches(4.6) ) m_dim_category = aligndim::a46;
-        else throw std::runtime_error( std::format("Unrecognized align size: {}",dim) );
+    // The usual dimensions like "4.6" are looked up in a precomputed table
+    void assign(const std::string_view token)
+       {
+        static constexpr auto table = details::tenths_table<aligndim>([](const double dim) consteval { return category_of(dim); });
+        if( const auto tenths = details::tenths_of(token) )
+           {
+            m_dim_category = table[*tenths];
+            if( m_dim_category!=aligndim::undefined ) return;
+           }
+        assign(details::value_of_dimension(token));
        }
 
     [[nodiscard]] constexpr bool is_defined() const noexcept { return m_dim_category!=aligndim::undefined; }
@@ -254,6 +471,7 @@ class AlignSpanDim final
     [[nodiscard]] constexpr bool is_46() const noexcept { return m_dim_category == aligndim::a46; }
 
     [[nodiscard]] constexpr std::string_view string() const noexcept { return aligndim_ids[std::to_underlying(m_dim_category)]; }
+
 };
 
 
@@ -418,10 +636,7 @@ class MachineData final
        {// From strings like "ActiveWR-4.9/4.6-(opp,no-buf)"
         //                    family🠉    🠉dims    🠉options
         MachineData mach;
-
-        // Need lowercase string
-        const std::string s = str::to_lower( std::string{sv} );
-        ascii::simple_lexer<char> lexer(s);
+        ascii::simple_lexer<char> lexer(sv);
 
         // Machine family
         lexer.skip_nonalphas();
@@ -435,29 +650,18 @@ class MachineData final
         lexer.skip_nonalnums();
         if( lexer.got_digit() )
            {
-            auto get_dim = [&lexer]() mutable -> double
+            auto get_dim = [&lexer]() mutable -> std::string_view
                {
-                double val = ascii::value_of_digit( lexer.current_char() );
-                while( lexer.get_next() and lexer.got_digit() )
-                   {
-                    val = (10.0 * val) + ascii::value_of_digit( lexer.current_char() );
-                   }
+                const std::size_t start = lexer.pos();
+                lexer.skip_while(ascii::is_digit<char>);
                 if( lexer.got('.') )
                    {
                     lexer.get_next();
-                    if( lexer.got_digit() )
-                       {
-                        double k = 0.1;
-                        do {
-                            val += k * ascii::value_of_digit( lexer.current_char() );
-                            k *= 0.1;
-                           }
-                        while( lexer.get_next() and lexer.got_digit() );
-                       }
+                    lexer.skip_while(ascii::is_digit<char>);
                    }
-                return val;
+                return lexer.input.substr(start, lexer.pos()-start);
                };
-            const double dim1 = get_dim();
+            const std::string_view dim1 = get_dim();
             if( mach.family().is_strato() )
                {
                 mach.m_cutbridgedim.assign( dim1, mach.m_family );
@@ -467,7 +671,7 @@ class MachineData final
             lexer.skip_nonalnums();
             if( lexer.got_digit() )
                {
-                const double dim2 = get_dim();
+                const std::string_view dim2 = get_dim();
                 if( mach.family().is_strato() )
                    {
                     mach.m_algndim.assign( dim2 );
@@ -481,7 +685,7 @@ class MachineData final
             lexer.skip_nonalphas();
             if( not lexer.got_alpha() ) break;
             const std::string_view opt = lexer.get_while(ascii::is_alpha_or_any_of<'-'>);
-            mach.m_options.add(opt);
+            mach.m_options.add( details::LowercaseToken(opt).view() );
            }
 
         // If here, all ok
@@ -495,6 +699,33 @@ class MachineData final
 
 
 
+/////////////////////////////////////////////////////////////////////////////
+#if defined(TEST_UNITS) or defined(TEST_BENCHMARKS) /////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+// All the families and dimensions, with some options
+[[nodiscard]] std::vector<std::string> macotec_machines_corpus()
+   {
+    std::vector<std::string> corpus;
+    for( const auto fam : {"ActiveHP"sv, "ActiveWR"sv, "ActiveW"sv, "WR"sv, "HP"sv} )
+       {
+        for( const auto cb : {"4.0"sv, "4.9"sv, "6.0"sv, "6.1"sv} )
+           {
+            for( const auto al : {"3.2"sv, "4.6"sv} )
+               {
+                for( const auto opts : {""sv, "-(opp)"sv, "-(lowe,rot)"sv, "-(opp,no-buf,other)"sv} )
+                   {
+                    corpus.push_back( std::format("{}-{}/{}{}", fam, cb, al, opts) );
+                   }
+               }
+           }
+       }
+    corpus.insert(corpus.end(), {"StarCut"s, "MasterFRV-(lowe)"s, "ActiveF-3.7/3.2"s, "ActiveFRS-4.9/3.2-(opp)"s});
+    return corpus;
+   }
+#endif //////////////////////////////////////////////////////////////////////
+
+
+
 /////////////////////////////////////////////////////////////////////////////
 #ifdef TEST_UNITS ///////////////////////////////////////////////////////////
 /////////////////////////////////////////////////////////////////////////////
@@ -521,6 +752,16 @@ ut::test("macotec::MachineFamily") = []
     fam.assign("starcut"sv);
     ut::expect( fam.is_float_scut() );
     ut::expect( ut::throws([]{ macotec::MachineFamily fam; fam.assign("boh"sv); }) ) << "bad family should throw\n";
+
+    fam.assign("ActiveWR"sv);
+    ut::expect( fam.is_strato_wr() );
+    fam.assign("MSFRV"sv);
+    ut::expect( fam.is_float_frv() );
+    fam.assign("stc"sv);
+    ut::expect( fam.is_float_scut() );
+    fam.assign("ActiveFRS"sv);
+    ut::expect( fam.is_strato_fr() ) << "not a known name, should be recognized anyway\n";
+    ut::expect( ut::throws([]{ macotec::MachineFamily f; f.assign("FR"sv); }) ) << "known ids not recognized before shouldn't be now\n";
    };
 
 ut::test("macotec::CutBridgeDim") = []
@@ -540,6 +781,18 @@ ut::test("macotec::CutBridgeDim") = []
     dim.assign(6.1, fam);
     ut::expect( dim.is_60() );
     ut::expect( ut::that % dim.string()=="6.0"sv );
+
+    dim.assign("4.9"sv, fam);
+    ut::expect( dim.is_49() );
+    dim.assign("3.9"sv, fam);
+    ut::expect( dim.is_40() ) << "tokens should have the same tolerance\n";
+    dim.assign("6.05"sv, fam);
+    ut::expect( dim.is_60() );
+    ut::expect( ut::throws([]{ macotec::CutBridgeDim d; d.assign("4.6"sv,{}); }) ) << "4.6 is just for ActiveF\n";
+    fam.set_as_strato_s();
+    dim.assign("4.6"sv, fam);
+    ut::expect( dim.is_46() );
+    ut::expect( ut::throws([]{ macotec::CutBridgeDim d; d.assign("1.9"sv,{}); }) ) << "bad dim token should throw\n";
    };
 
 ut::test("macotec::AlignSpanDim") = []
@@ -554,6 +807,12 @@ ut::test("macotec::AlignSpanDim") = []
     dim.assign(3.2);
     ut::expect( dim.is_32() );
     ut::expect( ut::that % dim.string()=="3.2"sv );
+
+    dim.assign("4.5"sv);
+    ut::expect( dim.is_46() );
+    dim.assign("3.25"sv);
+    ut::expect( dim.is_32() );
+    ut::expect( ut::throws([]{ macotec::AlignSpanDim d; d.assign("4.1"sv); }) ) << "bad dim token should throw\n";
    };
 
 ut::test("macotec::MachineOptions") = []
@@ -738,8 +997,56 @@ ut::test("macotec::MachineData") = []
        {
         ut::expect( ut::throws([]{ [[maybe_unused]] macotec::MachineData m{"ActiveW-6.0/3.9-(lowe)"sv}; }) ) << "unknown cut bridge should throw\n";
        };
+
+    ut::should("ignore case") = []
+       {
+        const macotec::MachineData m{ "activewr-4.9/4.6-(OPP,Rot)"sv };
+        ut::expect( m == macotec::MachineData{"ActiveWR-4.9/4.6-(opp,rot)"sv} );
+       };
+   };
+
+ut::test("macotec::MachineData recognition corpus") = []
+   {
+    std::size_t strato_count = 0;
+    const std::vector<std::string> corpus = macotec_machines_corpus();
+    for( const auto& mach_str : corpus )
+       {
+        const macotec::MachineData mach(mach_str);
+        if( mach.family().is_strato() ) ++strato_count;
+        ut::expect( mach==macotec::MachineData(test::tolower(mach_str)) ) << mach_str << " should be case insensitive\n";
+       }
+    ut::expect( ut::that % strato_count==corpus.size() - 2u ) << "all but StarCut and MasterFRV\n";
    };
 
 };///////////////////////////////////////////////////////////////////////////
 #endif // TEST_UNITS ////////////////////////////////////////////////////////
 /////////////////////////////////////////////////////////////////////////////
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+#ifdef TEST_BENCHMARKS //////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+static ut::suite<"macotec_machine_data_benchmarks"> macotec_machine_data_benchmarks = []
+{////////////////////////////////////////////////////////////////////////////
+
+ut::test("macotec::MachineData recognition throughput") = []
+   {
+    const std::vector<std::string> corpus = macotec_machines_corpus();
+    constexpr std::size_t reps = 2000;
+    std::size_t strato_count = 0;
+    const double elapsed = test::seconds_taken(reps, [&]
+       {
+        for( const auto& mach_str : corpus )
+           {
+            if( macotec::MachineData(mach_str).family().is_strato() ) ++strato_count;
+           }
+       });
+    const std::size_t recognized = reps * corpus.size();
+    ut::log << std::format("{} machines recognized: {:.0f} k/s\n", recognized, static_cast<double>(recognized) / 1000.0 / elapsed);
+    ut::expect( ut::that % strato_count==recognized - reps*2u );
+   };
+
+};///////////////////////////////////////////////////////////////////////////
+#endif // TEST_BENCHMARKS ///////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
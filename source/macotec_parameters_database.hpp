@@ -4,16 +4,30 @@
 //  machine type and extract the data pertinent
 //  to a machine type assuming database structure
 //  ---------------------------------------------
-//  #include "macotec_parameters_database.hpp" // macotec::ParamsDB
+//  #include "macotec_parameters_database.hpp" // macotec::ParamsDB, macotec::ParamsIndex, macotec::ParamsFieldsIndex, macotec::compile_params_db()
 //  ---------------------------------------------
+#include <cstdint> // std::uint8_t, std::int64_t
+#include <charconv> // std::from_chars
 #include <string>
 #include <string_view>
+#include <vector>
+#include <utility> // std::pair
+#include <iterator> // std::make_move_iterator
+#include <map>
+#include <variant>
+#include <optional>
+#include <memory> // std::shared_ptr
+#include <algorithm> // std::ranges::find
+#include <stdexcept> // std::runtime_error
 #include <format>
 
-#include "json_node.hpp" // json::Node
-#include "json_parser.hpp" // json::parse()
+#include "ascii_predicates.hpp" // ascii::is_digit
+#include "json_tree.hpp" // json::Tree
+#include "json_parser.hpp" // json::parse_tree(), json::LazyRoot
+#include "json_image.hpp" // json::Image, json::compile_image()
+#include "file_write.hpp" // sys::file_write
 #include "vectmap.hpp" // MG::vectmap<>
-#include "memory_mapped_file.hpp" // sys::memory_mapped_file
+#include "file_content.hpp" // sys::file_content
 #include "macotec_machine_data.hpp" // macotec::MachineData
 
 
@@ -21,246 +35,737 @@
 namespace macotec //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 {
 
+/////////////////////////////////////////////////////////////////////////////
+// A value in the DB, referring to its content
+// The value is classified when loaded and the numbers are decoded once,
+// so can be compared numerically with the text of the target fields
+class ParamValue final
+{
+ public:
+    enum class kind : std::uint8_t { none, integer, floating, quoted, token };
+
+ private:
+    std::string_view m_value;
+    double m_number = 0.0;
+    std::int64_t m_integer = 0; // Exact, when kind::integer
+    kind m_kind = kind::none;
+
+ public:
+    explicit ParamValue(const std::string_view val) noexcept
+      : m_value{val}
+       {
+        if( m_value.empty() )
+           {
+            m_kind = kind::none;
+           }
+        else if( const auto num = decode_number(m_value) )
+           {
+            m_number = num->value;
+            m_integer = num->integer;
+            m_kind = num->is_integer ? kind::integer : kind::floating;
+           }
+        else if( m_value.size()>1 and m_value.front()=='\"' and m_value.back()=='\"' )
+           {
+            m_kind = kind::quoted;
+           }
+        else
+           {
+            m_kind = kind::token;
+           }
+       }
+
+    [[nodiscard]] bool has_value() const noexcept { return not m_value.empty(); }
+    [[nodiscard]] std::string_view value() const noexcept { return m_value; }
+
+    [[nodiscard]] kind value_kind() const noexcept { return m_kind; }
+    [[nodiscard]] bool is_number() const noexcept { return m_kind==kind::integer or m_kind==kind::floating; }
+    [[nodiscard]] double number() const noexcept { return m_number; }
+
+    //-----------------------------------------------------------------------
+    // Numbers are compared by value (4282 is the same as 4282.0),
+    // two integers exactly (beyond 2^53 a double can't tell them apart),
+    // anything else by text
+    [[nodiscard]] bool same_value_as(const std::string_view txt) const noexcept
+       {
+        if( is_number() )
+           {
+            const auto num = decode_number(txt);
+            if( not num ) return false;
+            if( m_kind==kind::integer and num->is_integer ) return num->integer==m_integer;
+            return num->value==m_number;
+           }
+        return txt==m_value;
+       }
+
+ private:
+    struct number_t final
+       {
+        double value;
+        std::int64_t integer; // When is_integer
+        bool is_integer;
+       };
+
+    //-----------------------------------------------------------------------
+    // The number and if it's written as an integer
+    [[nodiscard]] static std::optional<number_t> decode_number(std::string_view txt) noexcept
+       {
+        if( not txt.empty() and txt.front()=='+' ) txt.remove_prefix(1); // Not accepted by from_chars
+        if( txt.empty() or not (ascii::is_digit(txt.front()) or txt.front()=='-' or txt.front()=='.') )
+           {// Excluding also inf and nan
+            return std::nullopt;
+           }
+        const char* const txt_end = txt.data() + txt.size();
+        std::int64_t i = 0;
+        if( const auto [it, ec] = std::from_chars(txt.data(), txt_end, i); ec==std::errc() and it==txt_end )
+           {
+            return number_t{ static_cast<double>(i), i, true };
+           }
+        double d = 0.0;
+        if( const auto [it, ec] = std::from_chars(txt.data(), txt_end, d); ec==std::errc() and it==txt_end )
+           {
+            return number_t{ d, 0, false };
+           }
+        return std::nullopt;
+       }
+};
+
+// The fields of a DB group (name=value)
+using ParamsGroup = std::vector<std::pair<std::string_view, ParamValue>>;
+using ParamsGroups = std::vector<ParamsGroup>;
+
+
 //----------------------------------------------------------------------------
-[[nodiscard]] auto extract_mach_udt_db( const json::Node& db,
-                                        const macotec::MachineData& mach,
-                                        fnotify_t const& notify_issue )
-// Extracts a list of node groups :      ┌{nam=val,...}
-//                                       ├{nam=val,...}
-// from this DB structure:    root┐      └{nam=val,...}
-//                                ├mach┐
-//                                │    ├"common"-{nam=val,...}
-//                                │    ├"cut-bridge"
-//                                │    │  ├"dim"-{nam=val,...}
-//                                │    │  └···
-//                                │    ├"algn-span"
-//                                │    │ ├"dim"-{nam=val,...}
-//                                │    │ └···
-//                                │    ├"+option"-{nam=val,...}
-//                                │    └···
-//                                ├mach┐
-//                                │    └···
-//                                └···
+// Works on a parsed DB (json::Tree) as well as on a compiled one (json::Image)
+template<typename NODE>
+[[nodiscard]] ParamsGroup group_of(const NODE& node)
+{
+    ParamsGroup group;
+    group.reserve( node.childs().size() );
+    for( const auto& [nam, child] : node.childs() )
+       {
+        group.emplace_back( nam, ParamValue{child.value()} );
+       }
+    return group;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// The sections of the machine families of a DB, the single implementation
+// of the extraction rules. Collected once, extracting the groups of a
+// machine needs no searches in the nodes nor parsing of the options names.
+// The DB structure:   root┐
+//                         ├mach┐
+//                         │    ├"common"-{nam=val,...}
+//                         │    ├"cut-bridge"
+//                         │    │  ├"dim"-{nam=val,...}
+//                         │    │  └···
+//                         │    ├"algn-span"
+//                         │    │ ├"dim"-{nam=val,...}
+//                         │    │ └···
+//                         │    ├"+option"-{nam=val,...}
+//                         │    └···
+//                         └···
+// where the blocks of a parax DB have the axes {"ax"-{nam=val,...},...}
+class ParamsIndex final
 {
-    json::RefNodeList mach_db;
-
-    if( const json::Node* const mach_db_root = db.get_child(mach.family().id_string()) )
-       {// Good, got an entry for this machine:
-        //  ┌"common"-{nam=val,...}
-        //  ├"cut-bridge"
-        //  │  ├"dim"-{nam=val,...}
-        //  │  └···                              ┌{nam=val,...}
-        //  ├"algn-span"                   =>    ├{nam=val,...}
-        //  │ ├"dim"-{nam=val,...}               └{nam=val,...}
-        //  │ └···
-        //  ├"+option"-{nam=val,...}
-        //  └···
-        json::RefNodeList options_db; // Possible options are collected in a separate container
-
-        for( const auto& [child_id, child] : mach_db_root->childs() )
+ public:
+    // The effective value of a field and the DB section that set it
+    struct found_value_t final
+       {
+        ParamValue value;
+        std::string section;
+       };
+
+ private:
+    struct section_t final
+       {
+        std::string name; // As "HP:cut-bridge:6.0", for the messages
+        ParamsGroup fields; // udt: the fields of the block (its leaves)
+        std::vector<std::pair<std::string_view,ParamsGroup>> axes; // parax: the fields of each axis (its groups)
+       };
+    struct dim_section_t final
+       {
+        std::string_view dim;
+        section_t section;
+       };
+    struct option_section_t final
+       {
+        MachineOptions required;
+        section_t section;
+       };
+    enum class step_kind : std::uint8_t { issue, common, cut_bridge, align_span };
+    struct step_t final
+       {
+        step_kind kind;
+        std::string issue;
+       };
+    struct family_t final
+       {
+        std::vector<step_t> steps; // In the DB order
+        section_t common;
+        std::vector<dim_section_t> cut_bridge_dims;
+        std::vector<dim_section_t> align_span_dims;
+        std::vector<option_section_t> options; // Applied last, in the DB order
+       };
+
+    MG::vectmap<std::string_view, family_t> m_families; // By family id
+    std::size_t m_entries_count = 0; // First level DB nodes
+
+ public:
+    template<typename NODE>
+    explicit ParamsIndex(const NODE& db)
+      : m_entries_count{ db.childs().size() }
+       {
+        for( const auto& [fam_id, fam_node] : db.childs() )
+           {
+            add_family(fam_id, fam_node);
+           }
+       }
+
+    // To be filled a family at a time
+    explicit ParamsIndex(const std::size_t entries_count) noexcept
+      : m_entries_count{ entries_count }
+       {}
+
+    //-----------------------------------------------------------------------
+    template<typename NODE>
+    void add_family(const std::string_view fam_id, const NODE& fam_node)
+       {
+        family_t& fam = m_families.insert_if_missing( std::string_view{fam_id} );
+        for( const auto& [child_id, child] : fam_node.childs() )
            {
             if( child.is_leaf() )
                {
-                notify_issue( std::format("DB: Ignoring orphan field `{}:{}` in {}", child_id, child.value(), mach.family().id_string()) );
+                fam.steps.push_back({ step_kind::issue, std::format("DB: Ignoring orphan field `{}:{}` in {}", child_id, child.value(), fam_id) });
                }
             else if( child_id=="common" )
                {
-                mach_db.append_ref_of( child );
+                fam.steps.push_back({ step_kind::common, {} });
+                fam.common = section_of(child, std::format("{}:{}", fam_id, child_id));
                }
-            else if( child_id=="cut-bridge" )
+            else if( child_id=="cut-bridge" or child_id=="algn-span" )
                {
-                if( mach.has_cutbridge_dim() )
+                const bool is_cut_bridge = child_id=="cut-bridge";
+                fam.steps.push_back({ is_cut_bridge ? step_kind::cut_bridge : step_kind::align_span, {} });
+                auto& dims = is_cut_bridge ? fam.cut_bridge_dims : fam.align_span_dims;
+                for( const auto& [dim_id, dim_node] : child.childs() )
                    {
-                    if( const json::Node* const cutbridge_db = child.get_child(mach.cutbridge_dim().string()) )
-                       {
-                        mach_db.append_ref_of( *cutbridge_db );
-                       }
-                    else
-                       {
-                        notify_issue( std::format("DB: Cut bridge dimension `{}` not found in {}:{{{}}}", mach.cutbridge_dim().string(), mach.family().id_string(), child_id) );
-                       }
-                   }
-               }
-            else if( child_id=="algn-span" )
-               {
-                if( mach.has_align_dim() )
-                   {
-                    if( const json::Node* const alignspan_db = child.get_child(mach.align_dim().string()) )
-                       {
-                        mach_db.append_ref_of( *alignspan_db );
-                       }
-                    else
-                       {
-                        notify_issue( std::format("DB: Align dimension `{}` not found in {}:{{{}}}", mach.align_dim().string(), mach.family().id_string(), child_id) );
-                       }
+                    dims.push_back({ dim_id, section_of(dim_node, std::format("{}:{}:{}", fam_id, child_id, dim_id)) });
                    }
                }
             else if( child_id.starts_with('+') )
                {
-                const std::string_view opt(child_id.begin()+1, child_id.end());
-                if( mach.options().has(opt) )
-                   {
-                    options_db.append_ref_of( child );
-                    // Support dimensions here?
-                    //if( mach.has_cutbridge_dim() and const json::Node* const cutbridge_db = child.get_child(mach.cutbridge_dim().string()) )
-                    //   {
-                    //   }
-                    //if( mach.has_align_dim() and const json::Node* const alignspan_db = child.get_child(mach.align_dim().string()) )
-                    //   {
-                    //   }
-                   }
+                option_section_t& opt = fam.options.emplace_back();
+                opt.required.add( child_id.substr(1) );
+                opt.section = section_of(child, std::format("{}:{}", fam_id, child_id));
                }
             else
                {
-                notify_issue( std::format("DB: Ignoring unrecognized block {}:{{{}}}", mach.family().id_string(), child_id) );
+                fam.steps.push_back({ step_kind::issue, std::format("DB: Ignoring unrecognized block {}:{{{}}}", fam_id, child_id) });
                }
            }
+       }
 
-        // Appending options last in order to overwrite the existing values
-        if( options_db.size()>0 )
+    //-----------------------------------------------------------------------
+    // The same sections of a family of another index (that refer to
+    // the content of the other DB)
+    void add_family_of(const ParamsIndex& other, const std::string_view fam_id)
+       {
+        if( const auto it=other.m_families.find(fam_id); it!=other.m_families.end() )
            {
-            mach_db.append_refs(options_db);
+            m_families.insert_if_missing( std::string_view{fam_id} ) = it->second;
            }
        }
-    else
+
+    //-----------------------------------------------------------------------
+    [[nodiscard]] ParamsGroups udt_db_for(const macotec::MachineData& mach, fnotify_t const& notify_issue) const
        {
-        notify_issue( std::format("DB: Machine id `{}` not found in the {} DB entries", mach.family().id_string(), db.childs().size()) );
+        ParamsGroups mach_db;
+        visit_sections_for(mach, notify_issue, [&mach_db](const section_t& section)
+           {
+            ParamsGroup& group = mach_db.emplace_back(section.fields);
+            for( const auto& ax : section.axes )
+               {// Not expected in an udt DB, kept as fields without a value to be reported
+                group.emplace_back( ax.first, ParamValue{{}} );
+               }
+           });
+        return mach_db;
        }
-    return mach_db;
-}
 
+    //-----------------------------------------------------------------------
+    [[nodiscard]] MG::vectmap<std::string_view,ParamsGroups> parax_db_for(const macotec::MachineData& mach, fnotify_t const& notify_issue) const
+       {
+        MG::vectmap<std::string_view,ParamsGroups> mach_db;
+        visit_sections_for(mach, notify_issue, [&mach_db](const section_t& section)
+           {
+            for( const auto& [ax_id, ax_fields] : section.axes )
+               {
+                mach_db.insert_if_missing( std::string_view{ax_id} ).push_back(ax_fields);
+               }
+            for( const auto& field : section.fields )
+               {// Not expected in a parax DB, kept as empty axes to be reported
+                mach_db.insert_if_missing( std::string_view{field.first} ).emplace_back();
+               }
+           });
+        return mach_db;
+       }
 
-//----------------------------------------------------------------------------
-[[nodiscard]] auto extract_mach_parax_db( const json::Node& db,
-                                          const macotec::MachineData& mach,
-                                          fnotify_t const& notify_issue )
-// Extracts a map of node groups :       ┌"ax"-{nam=val,...},{nam=val,...},...
-//                                       ├"ax"-{nam=val,...},{nam=val,...},...
-// from this DB structure:   root┐       └"ax"-{nam=val,...},{nam=val,...},...
-//                               ├mach┐
-//                               │    ├"common"┐
-//                               │    │        ├"ax"-{nam=val,...}
-//                               │    │        └···
-//                               │    ├"cut-bridge"┐
-//                               │    │            ├"dim"┐
-//                               │    │            │     ├"ax"-{nam=val,...}
-//                               │    │            │     └···
-//                               │    │            └···
-//                               │    ├"algn-span"┐
-//                               │    │           ├"dim"┐
-//                               │    │           │     ├"ax"-{nam=val,...}
-//                               │    │           │     └···
-//                               │    │           └···
-//                               │    ├"+option"┐
-//                               │    │         ├"ax"-{nam=val,...}
-//                               │    │         └···
-//                               │    └···
-//                               └···
-{
-    MG::vectmap<std::string_view,json::RefNodeList> mach_db;
-
-    const auto add_axfields_of = [&mach_db](const json::Node& node) -> void
+    //-----------------------------------------------------------------------
+    // The value that an adaptation would write in a field, that is
+    // "axis.param" for par2kax, without extracting all the groups
+    [[nodiscard]] std::optional<found_value_t> effective_value_of(const macotec::MachineData& mach, const std::string_view field_name, fnotify_t const& notify_issue) const
        {
-        for( const auto& [ax_id, ax_fields] : node.childs() )
+        const std::size_t i_dot = field_name.find('.');
+        const std::string_view ax_id = i_dot==std::string_view::npos ? std::string_view{} : field_name.substr(0, i_dot);
+        const std::string_view nam = i_dot==std::string_view::npos ? field_name : field_name.substr(i_dot+1);
+
+        const ParamValue* found_value = nullptr;
+        const section_t* found_section = nullptr;
+        const auto find_in = [&](const ParamsGroup& group, const section_t& section) noexcept
+           {// The last one wins, as in the groups
+            for( const auto& [field_nam, value] : group )
+               {
+                if( field_nam==nam )
+                   {
+                    found_value = &value;
+                    found_section = &section;
+                   }
+               }
+           };
+        visit_sections_for(mach, notify_issue, [&](const section_t& section)
            {
-            json::RefNodeList& ax_nodes = mach_db.insert_if_missing(ax_id);
-            ax_nodes.append_ref_of( ax_fields );
-           }
-       };
+            if( ax_id.empty() )
+               {
+                find_in(section.fields, section);
+               }
+            else for( const auto& [section_ax_id, ax_fields] : section.axes )
+               {
+                if( section_ax_id==ax_id ) find_in(ax_fields, section);
+               }
+           });
 
-    if( const json::Node* const mach_db_root = db.get_child(mach.family().id_string()) )
-       {// Good, got an entry for this machine
-        json::RefNodeList options_db; // Possible options are collected in a separate container
+        if( not found_value ) return std::nullopt;
+        return found_value_t{ *found_value, found_section->name };
+       }
 
-        for( const auto& [child_id, child] : mach_db_root->childs() )
+ private:
+    //-----------------------------------------------------------------------
+    // Just the shape that the node has: the leaves of an udt
+    // block or the axes of a parax one
+    template<typename NODE>
+    [[nodiscard]] static section_t section_of(const NODE& node, std::string&& name)
+       {
+        section_t section{ .name=std::move(name), .fields={}, .axes={} };
+        for( const auto& [nam, child] : node.childs() )
            {
-            if( child.is_leaf() )
+            if( child.has_childs() )
                {
-                notify_issue( std::format("DB: Ignoring orphan field `{}:{}` in {}", child_id, child.value(), mach.family().id_string()) );
+                section.axes.emplace_back( nam, group_of(child) );
                }
-            else if( child_id=="common" )
+            else
                {
-                add_axfields_of(child);
+                section.fields.emplace_back( nam, ParamValue{child.value()} );
                }
-            else if( child_id=="cut-bridge" )
+           }
+        return section;
+       }
+
+    //-----------------------------------------------------------------------
+    [[nodiscard]] static const section_t* section_of_dim(const std::vector<dim_section_t>& dims, const std::string_view dim) noexcept
+       {
+        for( const auto& dim_section : dims )
+           {
+            if( dim_section.dim==dim ) return &dim_section.section;
+           }
+        return nullptr;
+       }
+
+    //-----------------------------------------------------------------------
+    template<typename FADD>
+    void visit_sections_for(const macotec::MachineData& mach, fnotify_t const& notify_issue, FADD const& add) const
+       {
+        const auto it_fam = m_families.find( mach.family().id_string() );
+        if( it_fam==m_families.end() )
+           {
+            notify_issue( std::format("DB: Machine id `{}` not found in the {} DB entries", mach.family().id_string(), m_entries_count) );
+            return;
+           }
+        const family_t& fam = it_fam->second;
+
+        for( const step_t& step : fam.steps )
+           {
+            switch( step.kind )
                {
-                if( mach.has_cutbridge_dim() )
-                   {
-                    if( const json::Node* const cutbridge_db = child.get_child(mach.cutbridge_dim().string()) )
+                case step_kind::issue:
+                    notify_issue( std::string{step.issue} );
+                    break;
+
+                case step_kind::common:
+                    add(fam.common);
+                    break;
+
+                case step_kind::cut_bridge:
+                    if( mach.has_cutbridge_dim() )
                        {
-                        add_axfields_of(*cutbridge_db);
+                        if( const section_t* const section = section_of_dim(fam.cut_bridge_dims, mach.cutbridge_dim().string()) )
+                           {
+                            add(*section);
+                           }
+                        else
+                           {
+                            notify_issue( std::format("DB: Cut bridge dimension `{}` not found in {}:{{cut-bridge}}", mach.cutbridge_dim().string(), mach.family().id_string()) );
+                           }
                        }
-                    else
+                    break;
+
+                case step_kind::align_span:
+                    if( mach.has_align_dim() )
                        {
-                        notify_issue( std::format("DB: Cut bridge dimension `{}` not found in {}:{{{}}}", mach.cutbridge_dim().string(), mach.family().id_string(), child_id) );
+                        if( const section_t* const section = section_of_dim(fam.align_span_dims, mach.align_dim().string()) )
+                           {
+                            add(*section);
+                           }
+                        else
+                           {
+                            notify_issue( std::format("DB: Align dimension `{}` not found in {}:{{algn-span}}", mach.align_dim().string(), mach.family().id_string()) );
+                           }
                        }
-                   }
+                    break;
                }
-            else if( child_id=="algn-span" )
+           }
+
+        // Appending options last in order to overwrite the existing values
+        for( const auto& opt : fam.options )
+           {
+            if( mach.options().contains(opt.required) )
                {
-                if( mach.has_align_dim() )
-                   {
-                    if( const json::Node* const alignspan_db = child.get_child(mach.align_dim().string()) )
-                       {
-                        add_axfields_of(*alignspan_db);
-                       }
-                    else
-                       {
-                        notify_issue( std::format("DB: Align dimension `{}` not found in {}:{{{}}}", mach.align_dim().string(), mach.family().id_string(), child_id) );
-                       }
-                   }
+                add(opt.section);
                }
-            else if( child_id.starts_with('+') )
+           }
+       }
+};
+
+
+/////////////////////////////////////////////////////////////////////////////
+// The inverse of the extractions: the sections of any family that set
+// each field (or axis.param for par2kax), collected in a single pass
+// over the DB to audit what it covers
+class ParamsFieldsIndex final
+{
+ public:
+    struct setting_t final
+       {
+        std::string_view family;
+        std::string_view block; // "common", "cut-bridge", "algn-span" or "+option"
+        std::string_view dim; // Just for the dimensions blocks
+        ParamValue value;
+
+        [[nodiscard]] std::string section() const
+           {
+            return dim.empty() ? std::format("{}:{}", family, block) : std::format("{}:{}:{}", family, block, dim);
+           }
+       };
+
+ private:
+    std::map<std::string, std::vector<setting_t>, std::less<>> m_fields; // By name, or axis.param
+
+ public:
+    template<typename NODE>
+    explicit ParamsFieldsIndex(const NODE& db)
+       {
+        for( const auto& [fam_id, fam_node] : db.childs() )
+           {
+            for( const auto& [block_id, block] : fam_node.childs() )
                {
-                const std::string_view opt(child_id.begin()+1, child_id.end());
-                if( mach.options().has(opt) )
+                if( block_id=="common" or block_id.starts_with('+') )
                    {
-                    options_db.append_ref_of( child );
+                    add_fields_of(block, {fam_id, block_id, {}, ParamValue{{}}});
                    }
-                //else notify_issue( std::format("DB: Ignoring option `{}` for {}", opt, mach.string()) );
-               }
-            else
-               {
-                notify_issue( std::format("DB: Ignoring unrecognized block {}:{{{}}}", mach.family().id_string(), child_id) );
+                else if( block_id=="cut-bridge" or block_id=="algn-span" )
+                   {
+                    for( const auto& [dim_id, dim_block] : block.childs() )
+                       {
+                        add_fields_of(dim_block, {fam_id, block_id, dim_id, ParamValue{{}}});
+                       }
+                   }
+                // Orphan fields and unrecognized blocks are ignored by the extractions
                }
            }
+       }
 
-        // Appending options last in order to overwrite the existing values
-        for( const auto group_ref : options_db )
+    [[nodiscard]] const auto& fields() const noexcept { return m_fields; }
+    [[nodiscard]] std::size_t size() const noexcept { return m_fields.size(); }
+
+    [[nodiscard]] const std::vector<setting_t>* settings_of(const std::string_view field_name) const noexcept
+       {
+        if( const auto it=m_fields.find(field_name); it!=m_fields.end() )
            {
-            add_axfields_of(group_ref.get());
+            return &(it->second);
            }
+        return nullptr;
        }
-    else
+
+ private:
+    //-----------------------------------------------------------------------
+    template<typename NODE>
+    void add_fields_of(const NODE& block, const setting_t& where)
        {
-        notify_issue( std::format("DB: Machine id `{}` not found in the {} DB entries", mach.family().id_string(), db.childs().size()) );
+        for( const auto& [nam, node] : block.childs() )
+           {
+            if( node.is_leaf() )
+               {
+                add_setting(std::string{nam}, where, node.value());
+               }
+            else for( const auto& [par_nam, par_node] : node.childs() )
+               {// An axis
+                add_setting(std::format("{}.{}", nam, par_nam), where, par_node.value());
+               }
+           }
        }
 
-    return mach_db;
-}
+    //-----------------------------------------------------------------------
+    void add_setting(std::string&& field_name, setting_t where, const std::string_view val)
+       {
+        where.value = ParamValue{val};
+        m_fields[std::move(field_name)].push_back(where);
+       }
+};
 
 
 /////////////////////////////////////////////////////////////////////////////
+// Either parsed from json or a compiled image (see compile_params_db()),
+// both refer to the content, that's kept (usually memory mapped).
+// When just a machine will be extracted, the json can be parsed lazily:
+// the first level blocks are just located and then parsed only when
+// pertaining to the machine family (errors in the others won't be detected).
+// An image is never parsed: its first level nodes are sorted, so the
+// family is found by bisection and just its sections are collected.
+// The callers that extract many machines ask to index all the families
+// at load (parsing::indexed).
+// When a long running process reloads a changed json, the first level
+// blocks can be parsed incrementally: the families whose blocks content
+// didn't change are taken from the previous DB, keeping its content
 class ParamsDB final
 {
+ public:
+    enum class parsing : std::uint8_t { whole, lazy, incremental, indexed };
+
  private:
-    json::Node m_root;
+    struct family_source_t final
+       {
+        std::size_t hash = 0; // Of the content of its blocks
+        std::vector<std::string_view> blocks; // Their content, in m_content
+        std::shared_ptr<const sys::file_content> content; // The one its sections refer to
+        std::vector<std::string> issues; // Raised parsing its blocks
+       };
+
+    std::string m_path;
+    std::shared_ptr<const sys::file_content> m_content; // Can be shared with the next reloads
+    std::variant<json::Tree, json::Image, json::LazyRoot> m_db;
+    std::optional<ParamsIndex> m_index; // When asked for (or incremental), used for a machine
+    MG::vectmap<std::string_view, family_source_t> m_families_sources; // Just when parsing incrementally
+    std::size_t m_parsed_families_count = 0;
+
+    //-----------------------------------------------------------------------
+    // Just the family of the machine, when not indexed at load.
+    // The sections refer to m_content, not to the nodes,
+    // so a lazily parsed tree can be dropped
+    [[nodiscard]] ParamsIndex index_for(const macotec::MachineData& mach, fnotify_t const& notify_issue) const
+       {
+        const std::string_view fam_id = mach.family().id_string();
+        const auto index_of = [fam_id](const auto& root, const std::size_t entries_count)
+           {
+            ParamsIndex index(entries_count);
+            if( const auto fam_node = root.get_child(fam_id) )
+               {
+                index.add_family(fam_id, *fam_node);
+               }
+            return index;
+           };
+        if( const auto* const tree = std::get_if<json::Tree>(&m_db) )
+           {
+            return index_of(tree->root(), tree->root().childs().size());
+           }
+        if( const auto* const img = std::get_if<json::Image>(&m_db) )
+           {
+            return index_of(img->root(), img->root().childs().size());
+           }
+        const json::LazyRoot& lazy = std::get<json::LazyRoot>(m_db);
+        const json::Tree tree = lazy.tree_of(fam_id, notify_issue);
+        return index_of(tree.root(), lazy.keys_count());
+       }
 
  public:
-    explicit ParamsDB(const std::string& pth, fnotify_t const& notify_issue)
+    // The previous DB is used just when parsing incrementally
+    explicit ParamsDB(const std::string& pth, fnotify_t const& notify_issue, const parsing mode =parsing::whole, const ParamsDB* const previous =nullptr)
+      : ParamsDB{pth, sys::file_content(pth), notify_issue, mode, previous} // Could be a pipe, as /dev/fd/3
+       {}
+
+    // Content already read, the path is just for the messages
+    explicit ParamsDB(const std::string& pth, sys::file_content&& content, fnotify_t const& notify_issue, const parsing mode =parsing::whole, const ParamsDB* const previous =nullptr)
+      : m_path{pth}
+      , m_content{ std::make_shared<const sys::file_content>(mode==parsing::incremental ? owned_copy_of(content) : std::move(content)) }
+      , m_db{ load(m_path, m_content->as_string_view(), notify_issue, mode) }
+       {
+        if( const auto* const tree = std::get_if<json::Tree>(&m_db); tree and mode==parsing::indexed ) m_index.emplace( tree->root() );
+        else if( const auto* const img = std::get_if<json::Image>(&m_db); img and (mode==parsing::indexed or mode==parsing::incremental) ) m_index.emplace( img->root() );
+        else if( mode==parsing::incremental ) index_incrementally(previous, notify_issue);
+       }
+
+    // The nodes refer to m_content, that would move if a short string
+    ParamsDB(const ParamsDB&) = delete;
+    ParamsDB& operator=(const ParamsDB&) = delete;
+    ParamsDB(ParamsDB&&) = delete;
+    ParamsDB& operator=(ParamsDB&&) = delete;
+
+    [[nodiscard]] const std::string& path() const noexcept { return m_path; }
+    [[nodiscard]] bool is_compiled() const noexcept { return std::holds_alternative<json::Image>(m_db); }
+    [[nodiscard]] bool is_lazy() const noexcept { return std::holds_alternative<json::LazyRoot>(m_db) and not m_index; }
+    [[nodiscard]] bool is_indexed() const noexcept { return m_index.has_value(); }
+    [[nodiscard]] std::size_t parsed_families_count() const noexcept { return m_parsed_families_count; }
+
+    //-----------------------------------------------------------------------
+    // When parsed incrementally, tells if the blocks of a family have
+    // the same content, so what was extracted from the other is still valid
+    [[nodiscard]] bool has_same_family_of(const ParamsDB& other, const std::string_view fam_id) const noexcept
        {
-        const sys::memory_mapped_file dbfile_buf(pth.c_str());
-        json::parse(pth, dbfile_buf.as_string_view(), m_root, notify_issue);
+        const family_source_t* const source = source_of(fam_id);
+        const family_source_t* const other_source = other.source_of(fam_id);
+        return source and other_source and source->hash==other_source->hash and
+               source->content==other_source->content and source->blocks==other_source->blocks;
        }
 
-    [[nodiscard]] auto extract_udt_db_for(const macotec::MachineData& mach, fnotify_t const& notify_issue ) const { return extract_mach_udt_db(m_root, mach, notify_issue); }
-    [[nodiscard]] auto extract_parax_db_for(const macotec::MachineData& mach, fnotify_t const& notify_issue ) const { return extract_mach_parax_db(m_root, mach, notify_issue); }
+    [[nodiscard]] ParamsGroups extract_udt_db_for(const macotec::MachineData& mach, fnotify_t const& notify_issue ) const
+       {
+        if( m_index ) return m_index->udt_db_for(mach, notify_issue);
+        return index_for(mach, notify_issue).udt_db_for(mach, notify_issue);
+       }
+    [[nodiscard]] MG::vectmap<std::string_view,ParamsGroups> extract_parax_db_for(const macotec::MachineData& mach, fnotify_t const& notify_issue ) const
+       {
+        if( m_index ) return m_index->parax_db_for(mach, notify_issue);
+        return index_for(mach, notify_issue).parax_db_for(mach, notify_issue);
+       }
+
+    [[nodiscard]] std::optional<ParamsIndex::found_value_t> effective_value_of(const macotec::MachineData& mach, const std::string_view field_name, fnotify_t const& notify_issue) const
+       {
+        if( m_index ) return m_index->effective_value_of(mach, field_name, notify_issue);
+        return index_for(mach, notify_issue).effective_value_of(mach, field_name, notify_issue);
+       }
+
+    //-----------------------------------------------------------------------
+    // A lazy DB is parsed entirely for this, its nodes refer to m_content
+    [[nodiscard]] ParamsFieldsIndex fields_index(fnotify_t const& notify_issue) const
+       {
+        if( const auto* const tree = std::get_if<json::Tree>(&m_db) ) return ParamsFieldsIndex( tree->root() );
+        if( const auto* const img = std::get_if<json::Image>(&m_db) ) return ParamsFieldsIndex( img->root() );
+        return ParamsFieldsIndex( json::parse_tree(m_path, m_content->as_string_view(), notify_issue).root() );
+       }
+
+    [[nodiscard]] std::string info_string() const
+       {
+        if( const auto* const lazy = std::get_if<json::LazyRoot>(&m_db) )
+           {
+            if( m_index ) return std::format("{} first level nodes ({} parsed again)", lazy->keys_count(), m_parsed_families_count);
+            return std::format("{} first level nodes (parsed when needed)", lazy->keys_count());
+           }
+        const auto info_of = [](const auto& root){ return std::format("{} first level nodes ({} values)", root.childs().size(), root.total_values_count()); };
+        if( const auto* const tree = std::get_if<json::Tree>(&m_db) ) return info_of(tree->root());
+        return info_of( std::get<json::Image>(m_db).root() );
+       }
+
+ private:
+    [[nodiscard]] static std::variant<json::Tree, json::Image, json::LazyRoot> load(const std::string& pth, const std::string_view buf, fnotify_t const& notify_issue, const parsing mode)
+       {
+        if( json::Image::is_image(buf) )
+           {
+            return std::variant<json::Tree, json::Image, json::LazyRoot>{ std::in_place_type<json::Image>, buf };
+           }
+        if( mode==parsing::lazy or mode==parsing::incremental )
+           {
+            return std::variant<json::Tree, json::Image, json::LazyRoot>{ std::in_place_type<json::LazyRoot>, pth, buf };
+           }
+        return json::parse_tree(pth, buf, notify_issue);
+       }
+
+    //-----------------------------------------------------------------------
+    // The content kept by the next reloads must not be a mapping
+    // of the file, that's going to be modified
+    [[nodiscard]] static sys::file_content owned_copy_of(const sys::file_content& content)
+       {
+        return sys::file_content::of_string( std::string{content.as_string_view()} );
+       }
+
+    //-----------------------------------------------------------------------
+    [[nodiscard]] const family_source_t* source_of(const std::string_view fam_id) const noexcept
+       {
+        if( const auto it=m_families_sources.find(fam_id); it!=m_families_sources.end() )
+           {
+            return &(it->second);
+           }
+        return nullptr;
+       }
+
+    //-----------------------------------------------------------------------
+    // Parse just the families whose blocks changed since the previous DB.
+    // The ones that raised issues are parsed again, so that the messages
+    // have the current lines, and notified once when raised in shared blocks
+    void index_incrementally(const ParamsDB* const previous, fnotify_t const& notify_issue)
+       {
+        const json::LazyRoot& lazy = std::get<json::LazyRoot>(m_db);
+        ParamsIndex& index = m_index.emplace( lazy.keys_count() );
+        for( const std::string_view fam_id : lazy.keys() )
+           {
+            family_source_t& source = m_families_sources.insert_if_missing( std::string_view{fam_id} );
+            source.hash = lazy.hash_of(fam_id);
+            source.blocks = lazy.contents_of(fam_id);
+            if( const family_source_t* const prev_source = previous ? previous->source_of(fam_id) : nullptr;
+                prev_source and prev_source->issues.empty() and
+                prev_source->hash==source.hash and prev_source->blocks==source.blocks ) // Both buffers are alive
+               {
+                index.add_family_of(*previous->m_index, fam_id);
+                source.content = prev_source->content;
+               }
+            else
+               {
+                const json::Tree tree = lazy.tree_of(fam_id, [&source](std::string&& msg){ source.issues.push_back( std::move(msg) ); });
+                index.add_family(fam_id, *tree.root().get_child(fam_id));
+                source.content = m_content;
+                ++m_parsed_families_count;
+               }
+           }
+
+        std::vector<std::string_view> notified;
+        for( const auto& [fam_id, source] : m_families_sources )
+           {
+            for( const auto& issue : source.issues )
+               {
+                if( std::ranges::find(notified, issue)==notified.end() )
+                   {
+                    notified.push_back(issue);
+                    notify_issue( std::string{issue} );
+                   }
+               }
+           }
+       }
 
-    [[nodiscard]] const json::Node& root() const noexcept { return m_root; }
-    [[nodiscard]] std::string info_string() const { return std::format("{} first level nodes ({} values)", m_root.childs().size(), m_root.total_values_count()); }
 };
 
 
+//---------------------------------------------------------------------------
+// Write the image of a json DB, to be used without parsing
+void compile_params_db(const std::string& db_path, const std::string& out_path, fnotify_t const& notify_issue)
+{
+    const sys::file_content content(db_path);
+    if( json::Image::is_image(content.as_string_view()) )
+       {
+        throw std::runtime_error( std::format("{} is already compiled", db_path) );
+       }
+    const json::Tree tree = json::parse_tree(db_path, content.as_string_view(), notify_issue);
+    sys::file_write fw( out_path.c_str() );
+    fw << json::compile_image(tree);
+}
+
+
 
 
 }//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
@@ -273,11 +778,50 @@ class ParamsDB final
 /////////////////////////////////////////////////////////////////////////////
 #include "issues_collector.hpp" // MG::issues
 /////////////////////////////////////////////////////////////////////////////
+[[nodiscard]] std::string groups_to_string(const macotec::ParamsGroups& groups)
+   {// To compare the extracted groups
+    std::string s;
+    for( const auto& group : groups )
+       {
+        s += '{';
+        for( const auto& [nam, val] : group ) s += std::format("{}={};", nam, val.value());
+        s += '}';
+       }
+    return s;
+   }
+/////////////////////////////////////////////////////////////////////////////
 static ut::suite<"macotec_parameters_database"> macotec_parameters_database_tests = []
 {////////////////////////////////////////////////////////////////////////////
 
 struct issues_t final { int num=0; void operator()(std::string&& msg) noexcept {++num; ut::log << msg << '\n';}; };
 
+ut::test("macotec::ParamValue") = []
+   {
+    using enum macotec::ParamValue::kind;
+    ut::expect( macotec::ParamValue{""sv}.value_kind()==none );
+    ut::expect( macotec::ParamValue{"4282"sv}.value_kind()==integer );
+    ut::expect( macotec::ParamValue{"-12"sv}.value_kind()==integer );
+    ut::expect( macotec::ParamValue{"+1.5e3"sv}.value_kind()==floating );
+    ut::expect( macotec::ParamValue{".5"sv}.value_kind()==floating );
+    ut::expect( macotec::ParamValue{"\"4282\""sv}.value_kind()==quoted );
+    ut::expect( macotec::ParamValue{"inf"sv}.value_kind()==token );
+    ut::expect( macotec::ParamValue{"12mm"sv}.value_kind()==token );
+    ut::expect( macotec::ParamValue{"-"sv}.value_kind()==token );
+    ut::expect( ut::that % macotec::ParamValue{"+1.5e3"sv}.number()==1500.0 );
+
+    ut::expect( macotec::ParamValue{"4282"sv}.same_value_as("4282.0"sv) );
+    ut::expect( macotec::ParamValue{"4282.0"sv}.same_value_as("+4282"sv) );
+    ut::expect( macotec::ParamValue{"0.5"sv}.same_value_as(".50"sv) );
+    ut::expect( not macotec::ParamValue{"4282"sv}.same_value_as("4283"sv) );
+    ut::expect( not macotec::ParamValue{"4282"sv}.same_value_as("\"4282\""sv) );
+    ut::expect( not macotec::ParamValue{"4282"sv}.same_value_as(""sv) );
+    ut::expect( macotec::ParamValue{"\"abc\""sv}.same_value_as("\"abc\""sv) );
+    ut::expect( not macotec::ParamValue{"abc"sv}.same_value_as("ABC"sv) );
+    ut::expect( not macotec::ParamValue{"9007199254740993"sv}.same_value_as("9007199254740992"sv) ) << "integers should be compared exactly\n";
+    ut::expect( macotec::ParamValue{"9007199254740993"sv}.same_value_as("+9007199254740993"sv) );
+    ut::expect( macotec::ParamValue{"9007199254740992"sv}.same_value_as("9007199254740992.0"sv) );
+   };
+
 ut::test("macotec::ParamsDB::extract_udt_db_for()") = []
    {
     test::TemporaryFile f("~test-udt-db.txt",
@@ -382,10 +926,10 @@ ut::test("macotec::ParamsDB::extract_udt_db_for()") = []
     ut::expect( ut::that % mach_udt_db.size()==4u );
 
     std::size_t idx = 0;
-    for( const auto group_ref : mach_udt_db )
+    for( const auto& group : mach_udt_db )
        {
-        ut::expect( ut::that % group_ref.get().childs().size()>0u );
-        for( const auto& [nam, db_field] : group_ref.get().childs() )
+        ut::expect( ut::that % group.size()>0u );
+        for( const auto& [nam, db_field] : group )
            {
             ut::expect( db_field.has_value() ) << std::format("field {} hasn't a value\n", nam);
 
@@ -598,10 +1142,10 @@ ut::test("macotec::ParamsDB::extract_parax_db_for()") = []
     std::size_t idx = 0;
     for( const auto& [axid, db_axfields] : mach_parax_db )
        {
-        for( const auto group_ref : db_axfields )
+        for( const auto& group : db_axfields )
            {
-            ut::expect( ut::that % group_ref.get().childs().size()>0u );
-            for( const auto& [nam, db_field] : group_ref.get().childs() )
+            ut::expect( ut::that % group.size()>0u );
+            for( const auto& [nam, db_field] : group )
                {
                 ut::expect( db_field.has_value() ) << std::format("Axis field {}.{} hasn't a value\n", axid, nam);
 
@@ -657,6 +1201,281 @@ ut::test("macotec::ParamsDB::extract_parax_db_for()") = []
        }
    };
 
+ut::test("macotec::compile_params_db()") = []
+   {
+    test::TemporaryDirectory tmp_dir;
+    const auto json_db = tmp_dir.create_file("db.txt",
+        "WR,HP :\n"
+        "   {\n"
+        "    \"common\" : { com: wrhp, \"Co\" : { AxEnabled = 1 } }\n"
+        "    \"+opt\" : { opt: 1, com: opt }\n"
+        "   }\n"
+        "HP :\n"
+        "   {\n"
+        "    \"cut-bridge\" : { \"4.0\": { cb: 40 }, \"6.0\": { cb: 60, \"Ysup\" : { MaxPos = 6100 } } }\n"
+        "    \"algn-span\" : { \"4.6\": { as: 46 } }\n"
+        "   }\n"sv);
+    const auto img_db = tmp_dir.decl_file("db.m32db");
+
+    issues_t issues;
+    macotec::compile_params_db(json_db.path().string(), img_db.path().string(), std::ref(issues));
+    const macotec::ParamsDB db{ json_db.path().string(), std::ref(issues) };
+    const macotec::ParamsDB cdb{ img_db.path().string(), std::ref(issues) };
+    ut::expect( not db.is_compiled() and cdb.is_compiled() );
+    ut::expect( ut::that % cdb.info_string()==db.info_string() );
+
+    const macotec::MachineData mach{ "ActiveHP-6.0/4.6-(opt)"sv };
+    const std::string udt_db = groups_to_string(db.extract_udt_db_for(mach, std::ref(issues)));
+    ut::expect( ut::that % udt_db=="{as=46;}{com=wrhp;Co=;}{cb=60;Ysup=;}{com=opt;opt=1;}"sv );
+    ut::expect( ut::that % groups_to_string(cdb.extract_udt_db_for(mach, std::ref(issues)))==udt_db );
+    const macotec::ParamsDB icdb{ img_db.path().string(), std::ref(issues), macotec::ParamsDB::parsing::indexed };
+    ut::expect( not cdb.is_indexed() and icdb.is_indexed() ) << "an image should be indexed just when asked\n";
+    ut::expect( ut::that % groups_to_string(icdb.extract_udt_db_for(mach, std::ref(issues)))==udt_db );
+
+    const auto parax_db = db.extract_parax_db_for(mach, std::ref(issues));
+    const auto cparax_db = cdb.extract_parax_db_for(mach, std::ref(issues));
+    ut::expect( ut::fatal(ut::that % cparax_db.size()==parax_db.size()) );
+    for( auto it=parax_db.begin(), cit=cparax_db.begin(); it!=parax_db.end(); ++it, ++cit )
+       {
+        ut::expect( ut::that % cit->first==it->first );
+        ut::expect( ut::that % groups_to_string(cit->second)==groups_to_string(it->second) );
+       }
+    ut::expect( ut::that % issues.num==0 ) << "no issues expected\n";
+
+    ut::expect( ut::throws<std::runtime_error>([&]{ macotec::compile_params_db(img_db.path().string(), img_db.path().string(), std::ref(issues)); }) ) << "should refuse to compile an image\n";
+   };
+
+
+ut::test("macotec::ParamsDB lazy parsing") = []
+   {
+    test::TemporaryDirectory tmp_dir;
+    const auto json_db = tmp_dir.create_file("db.txt",
+        "WR,HP :\n"
+        "   {\n"
+        "    \"common\" : { com: wrhp, \"Co\" : { AxEnabled = 1 } }\n"
+        "    \"+opt\" : { opt: 1, com: opt }\n"
+        "   }\n"
+        "HP :\n"
+        "   {\n"
+        "    \"cut-bridge\" : { \"6.0\": { cb: 60, \"Ysup\" : { MaxPos = 6100 } } }\n"
+        "    \"algn-span\" : { \"4.6\": { as: 46 } }\n"
+        "   }\n"sv);
+
+    issues_t issues;
+    const macotec::ParamsDB db{ json_db.path().string(), std::ref(issues) };
+    const macotec::ParamsDB ldb{ json_db.path().string(), std::ref(issues), macotec::ParamsDB::parsing::lazy };
+    ut::expect( not db.is_lazy() and ldb.is_lazy() );
+    ut::expect( ut::that % ldb.info_string()=="2 first level nodes (parsed when needed)"sv );
+
+    const macotec::MachineData mach{ "ActiveHP-6.0/4.6-(opt)"sv };
+    ut::expect( ut::that % groups_to_string(ldb.extract_udt_db_for(mach, std::ref(issues)))==groups_to_string(db.extract_udt_db_for(mach, std::ref(issues))) );
+    const auto parax_db = db.extract_parax_db_for(mach, std::ref(issues));
+    const auto lparax_db = ldb.extract_parax_db_for(mach, std::ref(issues));
+    ut::expect( ut::fatal(ut::that % lparax_db.size()==parax_db.size()) );
+    for( auto it=parax_db.begin(), lit=lparax_db.begin(); it!=parax_db.end(); ++it, ++lit )
+       {
+        ut::expect( ut::that % lit->first==it->first );
+        ut::expect( ut::that % groups_to_string(lit->second)==groups_to_string(it->second) );
+       }
+    ut::expect( ut::that % issues.num==0 ) << "no issues expected\n";
+
+    // Errors in the blocks of other families are not detected
+    const auto bad_db = tmp_dir.create_file("bad-db.txt",
+        "WR : { common : { com = { } } }\n"
+        "HP : { common : { com: hp } }\n"sv);
+    const macotec::ParamsDB bad_ldb{ bad_db.path().string(), std::ref(issues), macotec::ParamsDB::parsing::lazy };
+    ut::expect( ut::that % groups_to_string(bad_ldb.extract_udt_db_for(mach, std::ref(issues)))=="{com=hp;}"sv );
+    ut::expect( ut::throws([&]{ std::ignore = bad_ldb.extract_udt_db_for(macotec::MachineData{"ActiveWR-4.9/4.6"sv}, std::ref(issues)); }) );
+   };
+
+ut::test("macotec::ParamsDB incremental parsing") = []
+   {
+    const std::string buf =
+        "WR,HP :\n"
+        "   {\n"
+        "    \"common\" : { com: wrhp }\n"
+        "   }\n"
+        "HP :\n"
+        "   {\n"
+        "    \"cut-bridge\" : { \"6.0\": { cb: 60 } }\n"
+        "   }\n"
+        "W :\n"
+        "   {\n"
+        "    \"common\" : { com: w }\n"
+        "   }\n";
+    std::string edited_buf = buf;
+    edited_buf.replace(edited_buf.find("cb: 60"), 6, "cb: 61");
+
+    issues_t issues;
+    auto db = std::make_unique<const macotec::ParamsDB>("db", sys::file_content::of_string(std::string{buf}), std::ref(issues), macotec::ParamsDB::parsing::incremental);
+    ut::expect( not db->is_lazy() );
+    ut::expect( ut::that % db->parsed_families_count()==3u );
+
+    const auto edited_db = std::make_unique<const macotec::ParamsDB>("db", sys::file_content::of_string(std::string{edited_buf}), std::ref(issues), macotec::ParamsDB::parsing::incremental, db.get());
+    ut::expect( ut::that % edited_db->parsed_families_count()==1u ) << "just the HP blocks changed\n";
+    ut::expect( edited_db->has_same_family_of(*db, "WR"sv) and edited_db->has_same_family_of(*db, "W"sv) );
+    ut::expect( not edited_db->has_same_family_of(*db, "HP"sv) );
+    db.reset(); // The reused sections should still be valid
+
+    // Content moved by some lines, not changed
+    const auto shifted_db = std::make_unique<const macotec::ParamsDB>("db", sys::file_content::of_string("// Added\n\n"s + edited_buf), std::ref(issues), macotec::ParamsDB::parsing::incremental, edited_db.get());
+    ut::expect( ut::that % shifted_db->parsed_families_count()==0u ) << "moved blocks are the same\n";
+    ut::expect( shifted_db->has_same_family_of(*edited_db, "HP"sv) );
+
+    const macotec::ParamsDB whole_db{ "db", sys::file_content::of_string(std::string{edited_buf}), std::ref(issues) };
+    for( const auto mach_str : {"ActiveHP-6.0/4.6"sv, "ActiveWR-4.9/3.2"sv, "ActiveW-4.0/4.6"sv, "ActiveWR-4.0/4.6-(opp,lowe)"sv} )
+       {
+        const macotec::MachineData mach{ mach_str };
+        MG::issues extract_issues, whole_issues;
+        ut::expect( ut::that % groups_to_string(edited_db->extract_udt_db_for(mach, std::ref(extract_issues)))==groups_to_string(whole_db.extract_udt_db_for(mach, std::ref(whole_issues))) ) << mach_str << '\n';
+        ut::expect( std::ranges::equal(extract_issues, whole_issues) ) << "same issues expected for " << mach_str << '\n';
+       }
+    ut::expect( ut::that % groups_to_string(edited_db->extract_udt_db_for(macotec::MachineData{"ActiveHP-6.0/4.6"sv}, std::ref(issues)))=="{com=wrhp;}{cb=61;}"sv );
+    ut::expect( ut::that % issues.num==0 ) << "no issues expected\n";
+   };
+
+
+ut::test("macotec::ParamsIndex") = []
+   {
+    const std::string_view buf =
+        "WR,HP :\n"
+        "   {\n"
+        "    orphan: 1\n"
+        "    \"common\" : { com: wrhp, \"Co\" : { AxEnabled = 1 } }\n"
+        "    \"+opt\" : { opt: 1, com: opt, \"Co\" : { AxEnabled = 0 } }\n"
+        "    \"+lowe\" : { lowe: 1 }\n"
+        "    \"unknown\" : { x: 1 }\n"
+        "   }\n"
+        "HP :\n"
+        "   {\n"
+        "    \"cut-bridge\" : { \"4.0\": { cb: 40 }, \"6.0\": { cb: 60, \"Ysup\" : { MaxPos = 6100 } } }\n"
+        "    \"algn-span\" : { \"4.6\": { as: 46 } }\n"
+        "   }\n"sv;
+    issues_t parse_issues;
+    const json::Tree tree = json::parse_tree("test", buf, std::ref(parse_issues));
+    const macotec::ParamsIndex index(tree.root());
+    const auto ignore_issue = [](std::string&&) noexcept {};
+
+    const auto parax_to_string = [](const MG::vectmap<std::string_view,macotec::ParamsGroups>& parax_db)
+       {
+        std::string s;
+        for( const auto& [ax_id, ax_groups] : parax_db ) s += std::format("{}:{} ", ax_id, groups_to_string(ax_groups));
+        return s;
+       };
+
+    // In the DB order (the nodes are sorted), options last; the blocks
+    // in an udt DB and the fields in a parax DB are kept to be reported
+    MG::issues issues;
+    const macotec::MachineData hp{ "ActiveHP-6.0/4.6-(opt)"sv };
+    ut::expect( ut::that % groups_to_string(index.udt_db_for(hp, std::ref(issues)))=="{as=46;}{com=wrhp;Co=;}{cb=60;Ysup=;}{com=opt;opt=1;Co=;}"sv );
+    ut::expect( ut::fatal(ut::that % issues.size()==2u) );
+    ut::expect( ut::that % issues.at(0)=="DB: Ignoring orphan field `orphan:1` in HP"sv );
+    ut::expect( ut::that % issues.at(1)=="DB: Ignoring unrecognized block HP:{unknown}"sv );
+    ut::expect( ut::that % parax_to_string(index.parax_db_for(hp, ignore_issue))=="as:{} Co:{AxEnabled=1;}{AxEnabled=0;} com:{}{} Ysup:{MaxPos=6100;} cb:{} opt:{} "sv );
+
+    MG::issues dims_issues;
+    ut::expect( ut::that % groups_to_string(index.udt_db_for(macotec::MachineData{"ActiveHP-4.9/3.2-(lowe,opt)"sv}, std::ref(dims_issues)))=="{com=wrhp;Co=;}{lowe=1;}{com=opt;opt=1;Co=;}"sv );
+    ut::expect( ut::fatal(ut::that % dims_issues.size()==4u) );
+    ut::expect( ut::that % dims_issues.at(0)=="DB: Align dimension `3.2` not found in HP:{algn-span}"sv );
+    ut::expect( ut::that % dims_issues.at(1)=="DB: Cut bridge dimension `4.9` not found in HP:{cut-bridge}"sv );
+
+    ut::expect( ut::that % groups_to_string(index.udt_db_for(macotec::MachineData{"ActiveHP-4.0/4.6-(rot)"sv}, ignore_issue))=="{as=46;}{com=wrhp;Co=;}{cb=40;}"sv );
+    ut::expect( ut::that % groups_to_string(index.udt_db_for(macotec::MachineData{"ActiveWR-4.0/4.6"sv}, ignore_issue))=="{com=wrhp;Co=;}"sv );
+
+    MG::issues fam_issues;
+    ut::expect( index.udt_db_for(macotec::MachineData{"ActiveW-4.0/4.6"sv}, std::ref(fam_issues)).empty() );
+    ut::expect( ut::fatal(ut::that % fam_issues.size()==1u) );
+    ut::expect( ut::that % fam_issues.at(0)=="DB: Machine id `W` not found in the 2 DB entries"sv );
+    ut::expect( ut::that % parse_issues.num==0 ) << "no parse issues expected\n";
+   };
+
+
+ut::test("macotec::ParamsDB::effective_value_of()") = []
+   {
+    test::TemporaryFile f("~test-query-db.txt",
+        "WR,HP :\n"
+        "   {\n"
+        "    \"common\" : { com: wrhp, spd: 10, \"Co\" : { AxEnabled = 1 } }\n"
+        "    \"+opt\" : { com: opt, \"Co\" : { AxEnabled = 0 } }\n"
+        "   }\n"
+        "HP :\n"
+        "   {\n"
+        "    \"cut-bridge\" : { \"6.0\": { spd: 60, \"Ysup\" : { MaxPos = 6100 } } }\n"
+        "   }\n"sv);
+    issues_t issues;
+    const macotec::ParamsDB db{ f.path().string(), std::ref(issues) };
+    const macotec::ParamsDB ldb{ f.path().string(), std::ref(issues), macotec::ParamsDB::parsing::lazy };
+
+    for( const macotec::ParamsDB* const pdb : {&db, &ldb} )
+       {
+        const auto check = [&](const std::string_view mach_str, const std::string_view field, const std::string_view expected_val, const std::string_view expected_section)
+           {
+            const auto found = pdb->effective_value_of(macotec::MachineData{mach_str}, field, std::ref(issues));
+            if( expected_val.empty() )
+               {
+                ut::expect( not found ) << field << " shouldn't be set for " << mach_str << '\n';
+               }
+            else if( found )
+               {
+                ut::expect( ut::that % found->value.value()==expected_val );
+                ut::expect( ut::that % found->section==expected_section );
+               }
+            else
+               {
+                ut::expect( false ) << field << " not found for " << mach_str << '\n';
+               }
+           };
+        check("ActiveHP-6.0/4.6"sv, "com"sv, "wrhp"sv, "HP:common"sv);
+        check("ActiveHP-6.0/4.6-(opt)"sv, "com"sv, "opt"sv, "HP:+opt"sv);
+        check("ActiveHP-6.0/4.6"sv, "spd"sv, "60"sv, "HP:cut-bridge:6.0"sv);
+        check("ActiveWR-4.0/4.6"sv, "spd"sv, "10"sv, "WR:common"sv);
+        check("ActiveHP-6.0/4.6-(opt)"sv, "Co.AxEnabled"sv, "0"sv, "HP:+opt"sv);
+        check("ActiveHP-6.0/4.6"sv, "Ysup.MaxPos"sv, "6100"sv, "HP:cut-bridge:6.0"sv);
+        check("ActiveHP-6.0/4.6"sv, "none"sv, ""sv, ""sv);
+        check("ActiveHP-6.0/4.6"sv, "Co.none"sv, ""sv, ""sv);
+       }
+    ut::expect( ut::that % issues.num==0 ) << "no issues expected\n";
+   };
+
+ut::test("macotec::ParamsFieldsIndex") = []
+   {
+    test::TemporaryFile f("~test-fields-index-db.txt",
+        "WR,HP :\n"
+        "   {\n"
+        "    orphan: 1\n"
+        "    \"common\" : { com: wrhp, \"Co\" : { AxEnabled = 1 } }\n"
+        "    \"+opt\" : { com: opt }\n"
+        "    \"unknown\" : { x: 1 }\n"
+        "   }\n"
+        "HP :\n"
+        "   {\n"
+        "    \"cut-bridge\" : { \"4.0\": { cb: 40 }, \"6.0\": { cb: 60, \"Ysup\" : { MaxPos = 6100 } } }\n"
+        "   }\n"sv);
+    issues_t issues;
+    for( const auto mode : {macotec::ParamsDB::parsing::whole, macotec::ParamsDB::parsing::lazy} )
+       {
+        const macotec::ParamsDB db{ f.path().string(), std::ref(issues), mode };
+        const macotec::ParamsFieldsIndex index = db.fields_index(std::ref(issues));
+
+        const auto settings_string = [&index](const std::string_view field_name) -> std::string
+           {
+            std::string s;
+            if( const auto settings = index.settings_of(field_name) )
+               {
+                for( const auto& setting : *settings ) s += std::format("{}={};", setting.section(), setting.value.value());
+               }
+            return s;
+           };
+        ut::expect( ut::that % index.size()==4u );
+        ut::expect( ut::that % settings_string("com"sv)=="HP:+opt=opt;HP:common=wrhp;WR:+opt=opt;WR:common=wrhp;"sv );
+        ut::expect( ut::that % settings_string("cb"sv)=="HP:cut-bridge:4.0=40;HP:cut-bridge:6.0=60;"sv );
+        ut::expect( ut::that % settings_string("Co.AxEnabled"sv)=="HP:common=1;WR:common=1;"sv );
+        ut::expect( ut::that % settings_string("Ysup.MaxPos"sv)=="HP:cut-bridge:6.0=6100;"sv );
+        ut::expect( not index.settings_of("orphan"sv) and not index.settings_of("x"sv) ) << "ignored as in the extractions\n";
+       }
+    ut::expect( ut::that % issues.num==0 ) << "no issues expected\n";
+   };
+
                                                            // ├F
 ut::test("test udt orphan field") = []                     // │ ├common
    {                                                       // │ │ ┕ok:fval
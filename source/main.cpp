@@ -7,9 +7,26 @@
 
 #include "adapt_udt_file.hpp" // app::adapt_udt()
 #include "adapt_parax_file.hpp" // app::adapt_parax()
+#include "adapt_fleet.hpp" // app::adapt_fleet(), app::update_fleet()
+#include "jobs_manifest.hpp" // app::run_jobs_manifest(), app::run_jobs()
+#include "adapt_server.hpp" // app::serve(), app::request_to_server()
+#include "watch_adapt.hpp" // app::watch_adapt()
+#include "filter_adapt.hpp" // app::filter_stdin_to_stdout()
+#include "overlays_cache.hpp" // app::OverlaysCache
+#include "query_db.hpp" // app::query_db()
+#include "db_coverage.hpp" // app::report_db_coverage()
+#include "macotec_parameters_database.hpp" // macotec::compile_params_db()
 #include "handle_output_file.hpp" // app::handle_output_file()
 
 
+//---------------------------------------------------------------------------
+// When filtering, stdout is for the output
+[[nodiscard]] std::FILE* msgs_stream_of(const app::Arguments& args) noexcept
+{
+    return args.job().is_filter() ? stderr : stdout;
+}
+
+
 //---------------------------------------------------------------------------
 int main( const int argc, const char* const argv[] )
 {
@@ -17,13 +34,95 @@ int main( const int argc, const char* const argv[] )
     try{
         args.parse(argc, argv);
 
-        const auto verbose_print = [verb=args.verbose()](const std::string_view msg, const auto&... args){ if(verb) std::vprint_unicode(msg, std::make_format_args(args...)); };
+        if( not args.client_socket().empty() )
+           {
+            return app::request_to_server( args.client_socket(), args.client_args() );
+           }
+
+        const auto verbose_print = [verb=args.verbose(), msgs=msgs_stream_of(args)](const std::string_view msg, const auto&... args){ if(verb) std::vprint_unicode(msgs, msg, std::make_format_args(args...)); };
 
         verbose_print("---- {} (build " __DATE__ ") ----\n", app::name);
 
         MG::issues issues;
 
-        if( args.job().is_update_udt() )
+        if( not args.compile_db().empty() )
+           {
+            verbose_print("Compiling {} to {}\n", args.compile_db(), args.compiled_db_path());
+            macotec::compile_params_db( args.compile_db(), args.compiled_db_path(), std::ref(issues) );
+           }
+        else if( args.db_coverage() )
+           {
+            verbose_print("Reporting the fields set by {}\n", args.job().db_file().path().string());
+            app::report_db_coverage( args.job(),
+                                     [](const std::string_view msg, const auto&... msg_args){ std::vprint_unicode(msg, std::make_format_args(msg_args...)); },
+                                     std::ref(issues) );
+           }
+        else if( not args.query_fields().empty() )
+           {
+            verbose_print("Querying {} for {} machines\n", args.job().db_file().path().string(), args.job().machs().size());
+            app::query_db( args.job().db_file().path().string(),
+                           args.job().machs(),
+                           args.query_fields(),
+                           [](const std::string_view msg, const auto&... msg_args){ std::vprint_unicode(msg, std::make_format_args(msg_args...)); },
+                           std::ref(issues) );
+           }
+        else if( not args.server_socket().empty() )
+           {
+            verbose_print("Serving requests on {}\n", args.server_socket());
+            app::serve( args.server_socket(), verbose_print );
+           }
+        else if( not args.jobs_manifest().empty() )
+           {
+            verbose_print("Running jobs of {}\n", args.jobs_manifest());
+            app::run_jobs_manifest( args.jobs_manifest(),
+                                    args.options(),
+                                    verbose_print,
+                                    std::ref(issues) );
+           }
+        else if( args.job().is_filter() )
+           {
+            verbose_print("Filtering stdin using {}\n", args.job().db_file().path().string());
+            app::filter_stdin_to_stdout( args.job(),
+                                         args.options(),
+                                         verbose_print,
+                                         std::ref(issues) );
+           }
+        else if( args.job().is_adapt_fleet() )
+           {
+            verbose_print("Adapting fleet {}\n", args.job().fleet_dir().string());
+            app::adapt_fleet( args.job().fleet_dir().string(),
+                              args.job().db_file().path().string(),
+                              args.job().parax_db_file().path().string(),
+                              args.options(),
+                              verbose_print,
+                              std::ref(issues) );
+           }
+        else if( args.job().is_update_fleet() )
+           {
+            verbose_print("Updating fleet {} using {}\n", args.job().fleet_dir().string(), args.job().target_file().path().string());
+            app::update_fleet( args.job().target_file().path().string(),
+                               args.job().fleet_dir().string(),
+                               args.options(),
+                               verbose_print,
+                               std::ref(issues) );
+           }
+        else if( args.watch() )
+           {
+            verbose_print("Watching {} and {}\n", args.job().target_file().path().string(), args.job().db_file().path().string());
+            app::watch_adapt( args.job(),
+                              args.options(),
+                              [](const std::string_view msg, const auto&... msg_args){ std::vprint_unicode(msg, std::make_format_args(msg_args...)); } );
+           }
+        else if( args.is_multi_job() )
+           {
+            verbose_print("Adapting {} files for {}\n", args.jobs().size(), args.job().mach_data().string());
+            app::run_jobs( app::named_after_targets(args.jobs()),
+                           args.options(),
+                           args.quiet(),
+                           verbose_print,
+                           std::ref(issues) );
+           }
+        else if( args.job().is_update_udt() )
            {
             verbose_print("Updating {} using {}\n", args.job().db_file().path().string(), args.job().target_file().path().string());
             const bool same_mach =
@@ -36,16 +135,51 @@ int main( const int argc, const char* const argv[] )
             const auto template_file = app::empty_if_or(not same_mach, args.job().target_file().path());
             app::handle_output_file( args.quiet(), args.job().out_path(), args.job().db_file().path(), template_file );
            }
-        else if( args.job().is_adapt_udt() )
+        else if( args.job().is_adapt_udt() and args.job().is_multi_mach() )
            {
-            verbose_print("Adapting {} for {} basing on DB {}\n", args.job().target_file().path().filename().string(), args.job().mach_data().string(), args.job().db_file().path().filename().string());
+            verbose_print("Adapting {} for {} machines basing on DB {}\n", args.job().target_file().path().filename().string(), args.job().machs().size(), args.job().db_file().path().filename().string());
             app::adapt_udt( args.job().target_file().path().string(),
                             args.job().db_file().path().string(),
-                            args.job().out_path().string(),
-                            args.job().mach_data(),
+                            args.job().mach_outputs(),
                             args.options(),
                             verbose_print,
                             std::ref(issues) );
+           }
+        else if( args.job().is_adapt_parax() and args.job().is_multi_mach() )
+           {
+            verbose_print("Adapting {} for {} machines basing on DB {}\n", args.job().target_file().path().filename().string(), args.job().machs().size(), args.job().db_file().path().filename().string());
+            app::adapt_parax( args.job().target_file().path().string(),
+                              args.job().db_file().path().string(),
+                              args.job().mach_outputs(),
+                              args.options(),
+                              verbose_print,
+                              std::ref(issues) );
+           }
+        else if( args.job().is_adapt_udt() )
+           {
+            verbose_print("Adapting {} for {} basing on DB {}\n", args.job().target_file().path().filename().string(), args.job().mach_data().string(), args.job().db_file().path().filename().string());
+            if( not args.overlays_cache().empty() )
+               {
+                app::OverlaysCache cache( args.overlays_cache() );
+                app::adapt_udt( args.job().target_file().path().string(),
+                                args.job().db_file().path().string(),
+                                args.job().out_path().string(),
+                                args.job().mach_data(),
+                                cache,
+                                args.options(),
+                                verbose_print,
+                                std::ref(issues) );
+               }
+            else
+               {
+                app::adapt_udt( args.job().target_file().path().string(),
+                                args.job().db_file().path().string(),
+                                args.job().out_path().string(),
+                                args.job().mach_data(),
+                                args.options(),
+                                verbose_print,
+                                std::ref(issues) );
+               }
             app::handle_output_file( args.quiet(), args.job().out_path(), args.job().target_file().path() );
            }
         else if( args.job().is_adapt_parax() )
@@ -69,7 +203,7 @@ int main( const int argc, const char* const argv[] )
            {
             for( const auto& issue : issues )
                {
-                std::print("! {}\n", issue);
+                std::print(msgs_stream_of(args), "! {}\n", issue);
                }
             return 1;
            }
@@ -79,7 +213,7 @@ int main( const int argc, const char* const argv[] )
 
     catch( std::invalid_argument& e )
        {
-        std::print("!! {}\n", e.what());
+        std::print(msgs_stream_of(args), "!! {}\n", e.what());
         if( not args.quiet() )
            {
             args.print_usage();
@@ -88,7 +222,7 @@ int main( const int argc, const char* const argv[] )
 
     catch( parse::error& e)
        {
-        std::print("!! [{}:{}] {}\n", e.file(), e.line(), e.what());
+        std::print(msgs_stream_of(args), "!! [{}:{}] {}\n", e.file(), e.line(), e.what());
         if( not args.quiet() )
            {
             sys::edit_text_file( e.file(), e.line() );
@@ -97,7 +231,7 @@ int main( const int argc, const char* const argv[] )
 
     catch( std::exception& e )
        {
-        std::print("!! {}\n", e.what());
+        std::print(msgs_stream_of(args), "!! {}\n", e.what());
        }
 
     return 2;
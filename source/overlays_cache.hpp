@@ -0,0 +1,378 @@
+﻿#pragma once
+//  ---------------------------------------------
+//  Keep on disk the udt overlays already resolved
+//  for a machine, so the next runs don't need to
+//  parse the DB and extract them again
+//  ---------------------------------------------
+//  #include "overlays_cache.hpp" // app::OverlaysCache
+//  ---------------------------------------------
+#include <cstdint> // std::uint64_t
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <utility> // std::pair
+#include <algorithm> // std::ranges::all_of
+#include <random> // std::random_device
+#include <system_error> // std::error_code
+#include <format>
+#include <filesystem> // std::filesystem
+
+#include "fnotify_type.hpp" // fnotify_t
+#include "file_content.hpp" // sys::file_content
+#include "file_write.hpp" // sys::file_write
+#include "options_set.hpp" // MG::options_set
+#include "macotec_parameters_database.hpp" // macotec::ParamsDB, macotec::ParamValue
+#include "udt_file_descriptor.hpp" // udt::File
+#include "adapt_udt_file.hpp" // app::overlay_mach_name()
+
+namespace fs = std::filesystem;
+using namespace std::literals; // "..."sv
+
+
+namespace app //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+//---------------------------------------------------------------------------
+// A hash that doesn't depend on the build, to name files
+[[nodiscard]] constexpr std::uint64_t stable_hash_of(const std::string_view sv) noexcept
+{// FNV-1a
+    std::uint64_t hash = 0xcbf29ce484222325u;
+    for( const char ch : sv )
+       {
+        hash ^= static_cast<unsigned char>(ch);
+        hash *= 0x100000001b3u;
+       }
+    return hash;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// The values that the DB imposes to a machine udt file, the groups
+// already resolved with the last one winning, with the issues
+// raised while parsing and extracting
+class FlatUdtOverlay final
+{
+ private:
+    std::vector<std::pair<std::string,std::string>> m_values; // label=value
+    std::vector<std::string> m_issues;
+
+ public:
+    [[nodiscard]] const auto& values() const noexcept { return m_values; }
+    [[nodiscard]] const auto& issues() const noexcept { return m_issues; }
+
+    //-----------------------------------------------------------------------
+    [[nodiscard]] static FlatUdtOverlay of(const macotec::ParamsDB& db, const macotec::MachineData& mach, std::vector<std::string>&& parse_issues)
+       {
+        FlatUdtOverlay flat;
+        flat.m_issues = std::move(parse_issues);
+        const auto record_issue = [&flat](std::string&& msg){ flat.m_issues.push_back( std::move(msg) ); };
+        std::map<std::string_view, std::size_t> idx_by_label;
+        for( const auto& group : db.extract_udt_db_for(mach, record_issue) )
+           {
+            for( const auto& [nam, db_field] : group )
+               {
+                if( not db_field.has_value() )
+                   {
+                    record_issue( std::format("Node {} hasn't a value in {}", nam, db.path()) );
+                   }
+                else if( const auto it=idx_by_label.find(nam); it!=idx_by_label.end() )
+                   {
+                    flat.m_values[it->second].second = db_field.value();
+                   }
+                else
+                   {
+                    idx_by_label.emplace(nam, flat.m_values.size());
+                    flat.m_values.emplace_back(nam, db_field.value());
+                   }
+               }
+           }
+        return flat;
+       }
+
+    //-----------------------------------------------------------------------
+    // Lines of "label=value", with the issues marked by a leading '!'
+    [[nodiscard]] std::string serialized() const
+       {
+        std::string s;
+        for( const auto& issue : m_issues )
+           {
+            s += std::format("!{}\n", issue);
+           }
+        for( const auto& [lbl, val] : m_values )
+           {
+            s += std::format("{}={}\n", lbl, val);
+           }
+        return s;
+       }
+
+    [[nodiscard]] bool is_serializable() const noexcept
+       {
+        const auto is_single_line = [](const std::string_view sv) noexcept { return not sv.contains('\n'); };
+        return std::ranges::all_of(m_issues, is_single_line) and
+               std::ranges::all_of(m_values, [&](const auto& lbl_val){ return not lbl_val.first.contains('=') and is_single_line(lbl_val.first) and is_single_line(lbl_val.second); });
+       }
+
+    [[nodiscard]] static FlatUdtOverlay deserialized(std::string_view buf)
+       {
+        FlatUdtOverlay flat;
+        while( not buf.empty() )
+           {
+            const std::size_t i_eol = buf.find('\n');
+            const std::string_view line = buf.substr(0, i_eol);
+            buf.remove_prefix( i_eol==std::string_view::npos ? buf.size() : i_eol+1 );
+            if( line.starts_with('!') )
+               {
+                flat.m_issues.emplace_back( line.substr(1) );
+               }
+            else if( const std::size_t i_eq = line.find('='); i_eq!=std::string_view::npos )
+               {
+                flat.m_values.emplace_back( line.substr(0, i_eq), line.substr(i_eq+1) );
+               }
+           }
+        return flat;
+       }
+};
+
+
+//---------------------------------------------------------------------------
+// Collect in the overlay the resolved DB values for the udt file
+void overlay_udt_for( const udt::File& udt_file,
+                      const FlatUdtOverlay& flat_db,
+                      sipro::TxtOverlay& overlay,
+                      fnotify_t const& notify_issue )
+{
+    for( const auto& issue : flat_db.issues() )
+       {
+        notify_issue( std::string{issue} );
+       }
+    for( const auto& [lbl, val] : flat_db.values() )
+       {
+        if( const auto udt_field = udt_file.get_field_by_label(lbl) )
+           {
+            if( not macotec::ParamValue{val}.same_value_as(overlay.value_of(*udt_field)) )
+               {// Skipping the no-op writes as overlay_udt_for() on the DB does
+                overlay.modify_value( *udt_field, val );
+               }
+           }
+        else
+           {
+            overlay.add_mod_issue( std::format("Not found: {}={}", lbl, val) );
+           }
+       }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// A directory of files named after the hashes of DB content and machine:
+// a changed DB gets another name, so the stale files are just not used
+class OverlaysCache final
+{
+ private:
+    static constexpr std::string_view header = "m32-pars-adapt udt overlay 1"sv;
+    fs::path m_dir;
+    bool m_last_was_hit = false;
+
+ public:
+    explicit OverlaysCache(const fs::path& dir)
+      : m_dir{dir}
+       {
+        fs::create_directories(m_dir);
+       }
+
+    [[nodiscard]] const fs::path& dir() const noexcept { return m_dir; }
+    [[nodiscard]] bool last_was_hit() const noexcept { return m_last_was_hit; }
+
+    //-----------------------------------------------------------------------
+    [[nodiscard]] FlatUdtOverlay udt_overlay_for(const std::string& db_path, const macotec::MachineData& mach)
+       {
+        const std::string mach_str{ mach.string() };
+        sys::file_content db_content(db_path); // Could be a pipe, read once
+        const std::uint64_t db_hash = stable_hash_of(db_content.as_string_view());
+        const fs::path cache_path = m_dir / std::format("{:016x}-{:016x}.udt-overlay", db_hash, stable_hash_of(mach_str));
+        const std::string key = std::format("{}\n{:016x} {}\n", header, db_hash, mach_str);
+
+        if( fs::is_regular_file(cache_path) and fs::file_size(cache_path)>0 )
+           {
+            const sys::file_content cached(cache_path.string());
+            if( const std::string_view buf = cached.as_string_view(); buf.starts_with(key) )
+               {
+                m_last_was_hit = true;
+                return FlatUdtOverlay::deserialized( buf.substr(key.size()) );
+               }
+           }
+        m_last_was_hit = false;
+
+        std::vector<std::string> parse_issues;
+        const macotec::ParamsDB db{ db_path, std::move(db_content), [&parse_issues](std::string&& msg){ parse_issues.push_back( std::move(msg) ); }, macotec::ParamsDB::parsing::lazy };
+        FlatUdtOverlay flat = FlatUdtOverlay::of(db, mach, std::move(parse_issues));
+        if( flat.is_serializable() )
+           {// Written aside and then renamed, for concurrent runs
+            const fs::path temp_path = fs::path(cache_path).concat(std::format(".{:x}.tmp", std::random_device{}()));
+            try{
+                   {
+                    sys::file_write fw( temp_path.string().c_str() );
+                    fw << key << flat.serialized();
+                   }
+                fs::rename(temp_path, cache_path);
+               }
+            catch(std::exception&)
+               {// Not cached, the overlay is good anyway
+                std::error_code ec;
+                fs::remove(temp_path, ec);
+               }
+           }
+        return flat;
+       }
+};
+
+
+//---------------------------------------------------------------------------
+// Adapt an udt file to a machine taking the DB values from the cache
+template<typename FPRINT>
+void adapt_udt( const std::string& target_file,
+                const std::string& db_file,
+                const std::string& out_path,
+                const macotec::MachineData& mach_data,
+                OverlaysCache& cache,
+                const MG::options_set& options,
+                FPRINT const& verbose_print,
+                fnotify_t const& notify_issue )
+{
+    const udt::File udt_file(target_file, std::ref(notify_issue));
+
+    sipro::TxtOverlay overlay;
+    const macotec::MachineData mach = overlay_mach_name(udt_file, mach_data, overlay, notify_issue);
+    const FlatUdtOverlay flat_db = cache.udt_overlay_for(db_file, mach);
+
+    verbose_print("  udt file: {}\n"
+                  "  DB: {} values for {} ({} cache)\n",
+                  udt_file.info_string(),
+                  flat_db.values().size(),
+                  mach.string(),
+                  cache.last_was_hit() ? "from"sv : "stored in"sv);
+
+    overlay_udt_for(udt_file, flat_db, overlay, notify_issue);
+
+    verbose_print("  Modified {} values, {} issues\n", overlay.modified_values_count(), overlay.mod_issues().size());
+
+    udt_file.write_to( out_path, overlay, options );
+}
+
+}//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+#ifdef TEST_UNITS ///////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+static ut::suite<"overlays_cache"> overlays_cache_tests = []
+{////////////////////////////////////////////////////////////////////////////
+
+struct issues_t final { int num=0; void operator()(std::string&& msg) noexcept {++num; ut::log << msg << '\n';}; };
+
+const auto value_of = [](const app::FlatUdtOverlay& flat, const std::string_view lbl) -> std::string_view
+   {
+    const auto it = std::ranges::find(flat.values(), lbl, [](const auto& lbl_val){ return std::string_view{lbl_val.first}; });
+    return it!=flat.values().end() ? std::string_view{it->second} : "<none>"sv;
+   };
+
+ut::test("app::OverlaysCache") = [&value_of]
+   {
+    test::TemporaryDirectory tmp_dir;
+    const auto db_file = tmp_dir.create_file("udt-overlays.txt",
+        "HP:{\n"
+        "    \"common\": { vnType: 11, vaName: \"a=b\" }\n"
+        "    \"cut-bridge\" : { \"6.0\": { vnType: 12 } }\n"
+        "    \"+lowe\" : { vnType: 13 }\n"
+        "   }\n"sv);
+    const macotec::MachineData mach{"ActiveHP-6.0/4.6-(lowe)"sv};
+    const macotec::MachineData other_mach{"ActiveHP-6.0/4.6"sv};
+
+    app::OverlaysCache cache( tmp_dir.path() / "cache" );
+    const app::FlatUdtOverlay flat = cache.udt_overlay_for(db_file.path().string(), mach);
+    ut::expect( not cache.last_was_hit() );
+    ut::expect( ut::fatal(ut::that % flat.values().size()==2u) );
+    ut::expect( ut::that % value_of(flat, "vnType"sv)=="13"sv ) << "last group should win\n";
+    ut::expect( ut::that % value_of(flat, "vaName"sv)=="a=b"sv );
+
+    const app::FlatUdtOverlay cached = cache.udt_overlay_for(db_file.path().string(), mach);
+    ut::expect( cache.last_was_hit() );
+    ut::expect( cached.values()==flat.values() );
+
+    std::ignore = cache.udt_overlay_for(db_file.path().string(), other_mach);
+    ut::expect( not cache.last_was_hit() ) << "another machine isn't cached yet\n";
+
+    std::ignore = tmp_dir.create_file("udt-overlays.txt",
+        "HP:{\n"
+        "    \"common\": { vnType: 21 }\n"
+        "   }\n"sv);
+    const app::FlatUdtOverlay changed = cache.udt_overlay_for(db_file.path().string(), mach);
+    ut::expect( not cache.last_was_hit() ) << "changed DB shouldn't use the cache\n";
+    ut::expect( ut::fatal(ut::that % changed.values().size()==1u) );
+    ut::expect( ut::that % value_of(changed, "vnType"sv)=="21"sv );
+   };
+
+ut::test("app::OverlaysCache not writable") = [&value_of]
+   {
+    test::TemporaryDirectory tmp_dir;
+    const auto db_file = tmp_dir.create_file("udt-overlays.txt",
+        "HP:{\n"
+        "    \"common\": { vnType: 11 }\n"
+        "   }\n"sv);
+    const macotec::MachineData mach{"ActiveHP-6.0/4.6"sv};
+
+    // A directory in place of the cache file makes the rename fail
+    const fs::path cache_dir = tmp_dir.path() / "cache";
+    fs::path cache_path;
+       {
+        app::OverlaysCache cache(cache_dir);
+        std::ignore = cache.udt_overlay_for(db_file.path().string(), mach);
+        ut::expect( ut::fatal(fs::directory_iterator(cache_dir)!=fs::directory_iterator{}) );
+        cache_path = fs::directory_iterator(cache_dir)->path();
+       }
+    fs::remove(cache_path);
+    fs::create_directories(cache_path / "occupied");
+
+    app::OverlaysCache cache(cache_dir);
+    app::FlatUdtOverlay flat;
+    ut::expect( ut::nothrow([&]{ flat = cache.udt_overlay_for(db_file.path().string(), mach); }) ) << "a cache that can't be written shouldn't fail\n";
+    ut::expect( not cache.last_was_hit() );
+    ut::expect( ut::that % value_of(flat, "vnType"sv)=="11"sv );
+    const auto is_temp = [](const fs::directory_entry& entry){ return entry.path().extension()==".tmp"; };
+    ut::expect( std::ranges::none_of(fs::directory_iterator(cache_dir), is_temp) ) << "temporary file should be removed\n";
+   };
+
+ut::test("app::adapt_udt() with cache") = []
+   {
+    test::TemporaryDirectory tmp_dir;
+    const auto udt = tmp_dir.create_file("MachSettings.udt",
+        "va0 = \"ActiveHP-6.0/4.6\" # Mandatory field 'vaMachName'\n"
+        "vn123 = 0 # Should be overwritten 'vnType'\n"sv);
+    const auto db = tmp_dir.create_file("udt-overlays.txt",
+        "HP:{\n"
+        "    \"common\": { vnType: 11, vnMissing: 1 }\n"
+        "   }\n"sv);
+    const auto out_direct = tmp_dir.decl_file("out-direct.udt");
+    const auto out_cached = tmp_dir.decl_file("out-cached.udt");
+    const macotec::MachineData mach{"ActiveHP-6.0/4.6"sv};
+    const MG::options_set options{"no-timestamp"sv};
+    const auto no_print = [](const std::string_view, const auto&...){};
+
+    issues_t issues;
+    app::adapt_udt(udt.path().string(), db.path().string(), out_direct.path().string(), mach, options, no_print, std::ref(issues));
+    app::OverlaysCache cache( tmp_dir.path() / "cache" );
+    for( int i=0; i<2; ++i )
+       {
+        app::adapt_udt(udt.path().string(), db.path().string(), out_cached.path().string(), mach, cache, options, no_print, std::ref(issues));
+        ut::expect( ut::that % out_cached.content()==out_direct.content() ) << "cached overlay should give the same output\n";
+       }
+    ut::expect( cache.last_was_hit() );
+    ut::expect( ut::that % issues.num==0 ) << "no issues expected\n";
+   };
+
+};///////////////////////////////////////////////////////////////////////////
+#endif // TEST_UNITS ////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
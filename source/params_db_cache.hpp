@@ -0,0 +1,290 @@
+﻿#pragma once
+//  ---------------------------------------------
+//  Keep the parameters databases parsed in memory
+//  together with the overlays extracted for the
+//  machines requested so far, reloading a file
+//  (just its changed blocks) only when its
+//  content changes
+//  ---------------------------------------------
+//  #include "params_db_cache.hpp" // app::ParamsDBCache
+//  ---------------------------------------------
+#include <cstddef> // std::size_t
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <memory> // std::unique_ptr
+#include <functional> // std::hash, std::less
+#include <filesystem> // std::filesystem
+
+#include "fnotify_type.hpp" // fnotify_t
+#include "memory_mapped_file.hpp" // sys::memory_mapped_file
+#include "macotec_parameters_database.hpp" // macotec::ParamsDB
+
+namespace fs = std::filesystem;
+
+
+namespace app //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+//---------------------------------------------------------------------------
+[[nodiscard]] std::size_t hash_of_file_content(const fs::path& pth)
+{
+    const sys::memory_mapped_file file_buf( pth.string().c_str() );
+    return std::hash<std::string_view>{}( file_buf.as_string_view() );
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// A parsed parameters DB with the overlays already extracted for the
+// machines requested so far. The issues raised while parsing and
+// extracting are recorded and notified again at each use.
+// When reloaded, the unchanged blocks of the previous one are reused
+// and so what was extracted for their machine families
+class CachedParamsDB final
+{
+ private:
+    template<typename T> struct extracted_t final
+       {
+        T db;
+        std::vector<std::string> issues;
+        std::string family; // The DB blocks it depends on
+       };
+    using udt_db_t = macotec::ParamsGroups;
+    using parax_db_t = MG::vectmap<std::string_view, macotec::ParamsGroups>;
+
+    std::unique_ptr<const macotec::ParamsDB> m_db; // Extracted groups refer to its content
+    std::vector<std::string> m_parse_issues;
+    fs::file_time_type m_mtime;
+    std::size_t m_hash;
+    std::map<std::string, extracted_t<udt_db_t>, std::less<>> m_udt_dbs;
+    std::map<std::string, extracted_t<parax_db_t>, std::less<>> m_parax_dbs;
+
+ public:
+    explicit CachedParamsDB(const fs::path& pth, CachedParamsDB* const previous =nullptr)
+      : m_mtime{ fs::last_write_time(pth) }
+      , m_hash{ hash_of_file_content(pth) }
+       {
+        m_db = std::make_unique<const macotec::ParamsDB>( pth.string(),
+                                                          [this](std::string&& msg){ m_parse_issues.push_back( std::move(msg) ); },
+                                                          macotec::ParamsDB::parsing::incremental,
+                                                          previous ? previous->m_db.get() : nullptr );
+        if( previous )
+           {
+            keep_unchanged_of(m_udt_dbs, std::move(previous->m_udt_dbs), *previous->m_db);
+            keep_unchanged_of(m_parax_dbs, std::move(previous->m_parax_dbs), *previous->m_db);
+           }
+       }
+
+    [[nodiscard]] const macotec::ParamsDB& db() const noexcept { return *m_db; }
+    [[nodiscard]] const std::string& path() const noexcept { return m_db->path(); }
+
+    //-----------------------------------------------------------------------
+    // Tells if the file is unchanged, the content is checked only when touched
+    [[nodiscard]] bool is_up_to_date()
+       {
+        const fs::file_time_type mtime = fs::last_write_time(m_db->path());
+        if( mtime==m_mtime )
+           {
+            return true;
+           }
+        if( hash_of_file_content(m_db->path())==m_hash )
+           {
+            m_mtime = mtime;
+            return true;
+           }
+        return false;
+       }
+
+    //-----------------------------------------------------------------------
+    void notify_parse_issues(fnotify_t const& notify_issue) const
+       {
+        for( const auto& issue : m_parse_issues )
+           {
+            notify_issue( std::string{issue} );
+           }
+       }
+
+    //-----------------------------------------------------------------------
+    [[nodiscard]] const udt_db_t& udt_db_for(const macotec::MachineData& mach, fnotify_t const& notify_issue)
+       {
+        return get_or_extract(m_udt_dbs, mach, notify_issue, [this, &mach](fnotify_t const& notify){ return m_db->extract_udt_db_for(mach, notify); });
+       }
+    [[nodiscard]] std::size_t udt_dbs_count() const noexcept { return m_udt_dbs.size(); }
+
+    //-----------------------------------------------------------------------
+    [[nodiscard]] const parax_db_t& parax_db_for(const macotec::MachineData& mach, fnotify_t const& notify_issue)
+       {
+        return get_or_extract(m_parax_dbs, mach, notify_issue, [this, &mach](fnotify_t const& notify){ return m_db->extract_parax_db_for(mach, notify); });
+       }
+
+ private:
+    //-----------------------------------------------------------------------
+    template<typename T, typename FEXTRACT>
+    [[nodiscard]] static const T& get_or_extract( std::map<std::string, extracted_t<T>, std::less<>>& cache,
+                                                  const macotec::MachineData& mach,
+                                                  fnotify_t const& notify_issue,
+                                                  FEXTRACT const& extract )
+       {
+        const std::string mach_str{ mach.string() };
+        auto it = cache.find(mach_str);
+        if( it==cache.end() )
+           {
+            extracted_t<T> extracted;
+            extracted.db = extract([&extracted](std::string&& msg){ extracted.issues.push_back( std::move(msg) ); });
+            extracted.family = mach.family().id_string();
+            it = cache.emplace(mach_str, std::move(extracted)).first;
+           }
+        for( const auto& issue : it->second.issues )
+           {
+            notify_issue( std::string{issue} );
+           }
+        return it->second.db;
+       }
+
+    //-----------------------------------------------------------------------
+    // What was extracted from the unchanged blocks refers to content
+    // that the reloaded DB keeps, so is still valid
+    template<typename T>
+    void keep_unchanged_of( std::map<std::string, extracted_t<T>, std::less<>>& cache,
+                            std::map<std::string, extracted_t<T>, std::less<>>&& prev_cache,
+                            const macotec::ParamsDB& prev_db )
+       {
+        for( auto& [mach_str, extracted] : prev_cache )
+           {
+            if( m_db->has_same_family_of(prev_db, extracted.family) )
+               {
+                cache.emplace(mach_str, std::move(extracted));
+               }
+           }
+       }
+};
+
+
+/////////////////////////////////////////////////////////////////////////////
+// The databases used so far, not thread safe
+class ParamsDBCache final
+{
+ private:
+    std::map<fs::path, CachedParamsDB> m_dbs;
+    std::size_t m_loads_count = 0;
+
+ public:
+    [[nodiscard]] std::size_t size() const noexcept { return m_dbs.size(); }
+    [[nodiscard]] std::size_t loads_count() const noexcept { return m_loads_count; }
+
+    //-----------------------------------------------------------------------
+    // Get the DB, parsing it again if the file changed since last time
+    [[nodiscard]] CachedParamsDB& get(const fs::path& pth, fnotify_t const& notify_issue)
+       {
+        const fs::path key = fs::weakly_canonical(pth);
+        auto it = m_dbs.find(key);
+        if( it==m_dbs.end() or not it->second.is_up_to_date() )
+           {
+            ++m_loads_count;
+            if( it==m_dbs.end() ) it = m_dbs.emplace(key, CachedParamsDB(key)).first;
+            else it->second = CachedParamsDB(key, &it->second);
+           }
+        it->second.notify_parse_issues(notify_issue);
+        return it->second;
+       }
+};
+
+}//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+#ifdef TEST_UNITS ///////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+static ut::suite<"params_db_cache"> params_db_cache_tests = []
+{////////////////////////////////////////////////////////////////////////////
+
+struct issues_t final { int num=0; void operator()(std::string&& msg) noexcept {++num; ut::log << msg << '\n';}; };
+
+ut::test("app::ParamsDBCache") = []
+   {
+    test::TemporaryDirectory tmp_dir;
+    const auto db_file = tmp_dir.create_file("udt-overlays.txt",
+        "HP:{\n"
+        "    \"common\": { vnType: 11 }\n"
+        "    \"cut-bridge\" : { \"6.0\": { vnType: 12 } }\n"
+        "    \"algn-span\" : { \"4.6\": { vnType: 13 } }\n"
+        "   }\n"sv);
+    const macotec::MachineData mach{"ActiveHP-6.0/4.6"sv};
+
+    issues_t issues;
+    app::ParamsDBCache cache;
+       {
+        app::CachedParamsDB& db = cache.get(db_file.path(), std::ref(issues));
+        const macotec::ParamsGroups& udt_db = db.udt_db_for(mach, std::ref(issues));
+        ut::expect( ut::that % udt_db.size()==3u );
+        ut::expect( &udt_db == &db.udt_db_for(mach, std::ref(issues)) ) << "extraction should be reused\n";
+       }
+    ut::expect( ut::that % cache.loads_count()==1u );
+
+    // Touched but not modified
+    fs::last_write_time(db_file.path(), fs::last_write_time(db_file.path()) + std::chrono::seconds(1));
+    std::ignore = cache.get(db_file.path(), std::ref(issues));
+    ut::expect( ut::that % cache.loads_count()==1u ) << "unchanged content shouldn't be reloaded\n";
+
+    // Modified
+    const auto orig_mtime = fs::last_write_time(db_file.path());
+    tmp_dir.create_file("udt-overlays.txt",
+        "HP:{\n"
+        "    \"common\": { vnType: 21 }\n"
+        "   }\n"sv);
+    fs::last_write_time(db_file.path(), orig_mtime + std::chrono::seconds(1));
+       {
+        app::CachedParamsDB& db = cache.get(db_file.path(), std::ref(issues));
+        ut::expect( ut::that % cache.loads_count()==2u ) << "modified DB should be reloaded\n";
+        const macotec::ParamsGroups& udt_db = db.udt_db_for(mach, std::ref(issues));
+        ut::expect( ut::fatal(ut::that % udt_db.size()==1u) );
+        ut::expect( ut::that % udt_db.front().front().second.value()=="21"sv );
+       }
+    ut::expect( ut::that % cache.size()==1u );
+    ut::expect( ut::that % issues.num==0 ) << "no issues expected\n";
+   };
+
+ut::test("app::ParamsDBCache reload of changed blocks") = []
+   {
+    test::TemporaryDirectory tmp_dir;
+    const auto db_file = tmp_dir.create_file("udt-overlays.txt",
+        "HP:{ \"common\": { vnType: 11 } }\n"
+        "WR:{ \"common\": { vnType: 21 } }\n"sv);
+    const macotec::MachineData mach_hp{"ActiveHP-6.0/4.6"sv};
+    const macotec::MachineData mach_wr{"ActiveWR-4.9/4.6"sv};
+
+    issues_t issues;
+    app::ParamsDBCache cache;
+       {
+        app::CachedParamsDB& db = cache.get(db_file.path(), std::ref(issues));
+        std::ignore = db.udt_db_for(mach_hp, std::ref(issues));
+        std::ignore = db.udt_db_for(mach_wr, std::ref(issues));
+        ut::expect( ut::that % db.udt_dbs_count()==2u );
+       }
+
+    const auto orig_mtime = fs::last_write_time(db_file.path());
+    tmp_dir.create_file("udt-overlays.txt",
+        "HP:{ \"common\": { vnType: 11 } }\n"
+        "WR:{ \"common\": { vnType: 22 } }\n"sv);
+    fs::last_write_time(db_file.path(), orig_mtime + std::chrono::seconds(1));
+       {
+        app::CachedParamsDB& db = cache.get(db_file.path(), std::ref(issues));
+        ut::expect( ut::that % cache.loads_count()==2u ) << "modified DB should be reloaded\n";
+        ut::expect( ut::that % db.db().parsed_families_count()==1u ) << "just the WR block should be parsed again\n";
+        ut::expect( ut::that % db.udt_dbs_count()==1u ) << "the HP extraction should be kept\n";
+        const macotec::ParamsGroups& hp_db = db.udt_db_for(mach_hp, std::ref(issues));
+        ut::expect( ut::fatal(ut::that % hp_db.size()==1u) );
+        ut::expect( ut::that % hp_db.front().front().second.value()=="11"sv );
+        const macotec::ParamsGroups& wr_db = db.udt_db_for(mach_wr, std::ref(issues));
+        ut::expect( ut::fatal(ut::that % wr_db.size()==1u) );
+        ut::expect( ut::that % wr_db.front().front().second.value()=="22"sv );
+       }
+    ut::expect( ut::that % issues.num==0 ) << "no issues expected\n";
+   };
+
+};///////////////////////////////////////////////////////////////////////////
+#endif // TEST_UNITS ////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
@@ -5,10 +5,18 @@
 //  ---------------------------------------------
 //  #include "parax_file_descriptor.hpp" // parax::File
 //  ---------------------------------------------
-#include <map>
+#include <cstdint> // std::uint16_t, std::uint32_t
+#include <vector>
+#include <span>
+#include <optional>
+#include <algorithm> // std::ranges::sort, std::ranges::lower_bound
+#include <utility> // std::as_const
+#include <iterator> // std::make_move_iterator
 #include <format>
 
+#include "flat_hash_index.hpp" // MG::flat_hash_index
 #include "string_utilities.hpp" // str::unquoted
+#include "string_conversions.hpp" // str::to_num_or<>()
 #include "sipro_txt_parser.hpp" // sipro::TxtParser
 #include "sipro_txt_file_descriptor.hpp" // sipro::TxtFile
 
@@ -20,11 +28,48 @@ namespace parax //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 class File final : public sipro::TxtFile
 {
     using field_t = sipro::TxtField;
-    using fields_t = std::map<std::string_view, field_t>;
-    using blocks_t = std::map<std::string_view, fields_t>;
+
+ public:
+    /////////////////////////////////////////////////////////////////////////
+    // An entry of the axes directory, its fields are a contiguous
+    // range of the fields of the file, sorted by name
+    class Axis final
+    {
+     private:
+        std::string_view m_name;
+        std::optional<std::uint16_t> m_id; // AxId
+        std::span<field_t> m_fields;
+
+     public:
+        explicit Axis(const std::string_view nam, const std::optional<std::uint16_t> id, const std::span<field_t> fields) noexcept
+          : m_name(nam)
+          , m_id(id)
+          , m_fields(fields)
+           {}
+
+        [[nodiscard]] std::string_view name() const noexcept { return m_name; }
+        [[nodiscard]] std::optional<std::uint16_t> id() const noexcept { return m_id; }
+        [[nodiscard]] std::span<const field_t> fields() const noexcept { return m_fields; }
+
+        [[nodiscard]] const field_t* get_field(const std::string_view var_name) const noexcept
+           {
+            const auto it = std::ranges::lower_bound(m_fields, var_name, {}, &field_t::var_name);
+            return it!=m_fields.end() and it->var_name()==var_name ? &*it : nullptr;
+           }
+        [[nodiscard]] field_t* get_field(const std::string_view var_name) noexcept
+           {
+            return const_cast<field_t*>( std::as_const(*this).get_field(var_name) );
+           }
+
+     private:
+        friend class File;
+        void set_fields(const std::span<field_t> fields) noexcept { m_fields = fields; }
+    };
 
  private:
-    blocks_t m_axblocks; // Axes fields
+    std::vector<field_t> m_fields; // All the axes fields, sorted by axis and name
+    std::vector<Axis> m_axes; // Sorted by name
+    std::vector<std::pair<std::uint16_t,std::uint32_t>> m_axes_by_id; // Sorted AxId, index in m_axes
 
  public:
     explicit File(const std::string& pth, fnotify_t const& notify_issue)
@@ -33,34 +78,42 @@ class File final : public sipro::TxtFile
         parse( notify_issue );
        }
 
+    explicit File(const std::string& name, sys::file_content&& content, fnotify_t const& notify_issue)
+      : sipro::TxtFile{name, std::move(content)}
+       {
+        parse( notify_issue );
+       }
+
+
+    [[nodiscard]] const std::vector<Axis>& axes() const noexcept { return m_axes; } // By axis name
 
     //-----------------------------------------------------------------------
-    [[nodiscard]] fields_t* get_fields_of_axis(const std::string_view axid) noexcept
+    [[nodiscard]] const Axis* get_fields_of_axis(const std::string_view axid) const noexcept
        {
-        if( auto it=m_axblocks.find(axid); it!=m_axblocks.end() )
-           {
-            return &(it->second);
-           }
-        return nullptr;
+        const auto it = std::ranges::lower_bound(m_axes, axid, {}, &Axis::name);
+        return it!=m_axes.end() and it->name()==axid ? &*it : nullptr;
+       }
+    [[nodiscard]] Axis* get_fields_of_axis(const std::string_view axid) noexcept
+       {
+        return const_cast<Axis*>( std::as_const(*this).get_fields_of_axis(axid) );
+       }
+
+    //-----------------------------------------------------------------------
+    [[nodiscard]] const Axis* get_axis_by_id(const std::uint16_t id) const noexcept
+       {
+        const auto it = std::ranges::lower_bound(m_axes_by_id, id, {}, &std::pair<std::uint16_t,std::uint32_t>::first);
+        return it!=m_axes_by_id.end() and it->first==id ? &m_axes[it->second] : nullptr;
        }
 
 
     //-----------------------------------------------------------------------
-    [[nodiscard]] static const field_t* get_field_by_varname(const fields_t& fields, const std::string_view key) noexcept
+    [[nodiscard]] static const field_t* get_field_by_varname(const Axis& axis, const std::string_view key) noexcept
        {
-        if( auto it=fields.find(key); it!=fields.end() )
-           {
-            return &(it->second);
-           }
-        return nullptr;
+        return axis.get_field(key);
        }
-    [[nodiscard]] static field_t* get_field_by_varname(fields_t& fields, const std::string_view key) noexcept
+    [[nodiscard]] static field_t* get_field_by_varname(Axis& axis, const std::string_view key) noexcept
        {
-        if( auto it=fields.find(key); it!=fields.end() )
-           {
-            return &(it->second);
-           }
-        return nullptr;
+        return axis.get_field(key);
        }
 
 
@@ -68,12 +121,9 @@ class File final : public sipro::TxtFile
     [[nodiscard]] std::size_t modified_values_count() const noexcept
        {
         std::size_t count = 0;
-        for( auto& [axid, axblock] : m_axblocks )
+        for( const field_t& field : m_fields )
            {
-            for( auto& [var_name, field] : axblock )
-               {
-                if( field.is_value_modified() ) ++count;
-               }
+            if( field.is_value_modified() ) ++count;
            }
         return count;
        }
@@ -82,11 +132,21 @@ class File final : public sipro::TxtFile
     //-----------------------------------------------------------------------
     [[nodiscard]] std::string info_string() const
        {
-        return std::format("{} lines, {} axes", m_lines.size(), m_axblocks.size());
+        return std::format("{} lines, {} axes", lines_count(), m_axes.size());
        }
 
 
  private:
+    // The blocks collect their fields at the end of m_fields,
+    // the axes ranges are set once the fields won't move anymore
+    struct block_t final
+       {
+        std::string_view name;
+        std::optional<std::uint16_t> id;
+        std::size_t first_field;
+        std::size_t fields_count;
+       };
+
     //-----------------------------------------------------------------------
     void parse(fnotify_t const& notify_issue)
        {
@@ -94,21 +154,27 @@ class File final : public sipro::TxtFile
         parser.set_file_path( path() );
         parser.set_on_notify_issue(notify_issue);
 
+        std::vector<block_t> blocks;
+        MG::flat_hash_index blocks_by_name;
+        const auto name_of_block = [&blocks](const MG::flat_hash_index::pos_type pos) noexcept { return blocks[pos].name; };
+
         // A context for collecting axis fields
         class curr_ax_block_t final
         {
          private:
             std::string_view m_tagname;
             std::size_t m_line_idx = 0;
-            fields_t m_collected_fields;
+            std::size_t m_first_field = 0;
+            MG::flat_hash_index m_fields_by_name; // Reused for each block
             bool m_inside = false;
 
          public:
-            void start(const std::string_view nam, const std::size_t lin)
+            void start(const std::string_view nam, const std::size_t lin, const std::size_t first_field)
                {
                 m_tagname = nam;
                 m_line_idx = lin;
-                m_collected_fields.clear();
+                m_first_field = first_field;
+                m_fields_by_name.clear();
                 m_inside = true;
                }
 
@@ -120,12 +186,14 @@ class File final : public sipro::TxtFile
             [[nodiscard]] explicit operator bool() const noexcept { return m_inside; }
             [[nodiscard]] std::string_view tag_name() const noexcept { return m_tagname; }
             [[nodiscard]] std::size_t line_idx() const noexcept { return m_line_idx; }
-            [[nodiscard]] auto& collected_fields() noexcept { return m_collected_fields; }
+            [[nodiscard]] std::size_t first_field() const noexcept { return m_first_field; }
+            [[nodiscard]] auto& fields_by_name() noexcept { return m_fields_by_name; }
         } curr_ax_block;
 
+        const auto name_of_field = [this](const MG::flat_hash_index::pos_type pos) noexcept { return m_fields[pos].var_name(); };
+
         while( const auto& line = parser.next_line() )
            {
-            field_t* line_associated_field = nullptr;
             if( curr_ax_block )
                {// Collecting the fields of an axis
                 if( parser.is_inside_note_block() )
@@ -136,62 +204,65 @@ class File final : public sipro::TxtFile
                     if( line.name()==curr_ax_block.tag_name() )
                        {
                         curr_ax_block.end();
-                        if( curr_ax_block.collected_fields().empty() )
+                        const std::span<const field_t> collected_fields{m_fields.begin() + static_cast<std::ptrdiff_t>(curr_ax_block.first_field()), m_fields.end()};
+                        bool discard = true;
+                        if( collected_fields.empty() )
                            {
                             notify_issue( std::format("[{}:{}] No fields collected in axis block"sv, path(), curr_ax_block.line_idx()) );
                            }
                         // I need the axis name to store the collected fields
-                        else if( const field_t* const ax_name_field = get_field_by_varname(curr_ax_block.collected_fields(),"Name") )
+                        else if( const auto ax_name_pos = curr_ax_block.fields_by_name().find("Name"sv, name_of_field) )
                            {
-                            const std::string_view ax_name = str::unquoted(ax_name_field->value());
-                            if( m_axblocks.contains(ax_name) )
+                            const std::string_view ax_name = str::unquoted(m_fields[*ax_name_pos].value());
+                            if( const auto pos = static_cast<MG::flat_hash_index::pos_type>(blocks.size());
+                                blocks_by_name.find_or_insert(ax_name, pos, name_of_block)!=pos )
                                {
                                 notify_issue( std::format("[{}:{}] Duplicate axis name `{}`"sv, path(), curr_ax_block.line_idx(), ax_name) );
                                }
                             else
                                {
-                                const auto [it, inserted] = m_axblocks.insert( {ax_name, std::move(curr_ax_block.collected_fields())} );
-                                assert(curr_ax_block.collected_fields().empty()); // After move should be empty
-                                if( not inserted )
+                                std::optional<std::uint16_t> ax_id;
+                                if( const auto ax_id_pos = curr_ax_block.fields_by_name().find("AxId"sv, name_of_field) )
                                    {
-                                    notify_issue( std::format("[{}:{}] Axis block `{}` was not inserted"sv, path(), curr_ax_block.line_idx(), ax_name) );
+                                    if( const auto id = str::to_num_or<std::uint16_t>(m_fields[*ax_id_pos].value()) ) ax_id = *id;
                                    }
+                                blocks.push_back({ax_name, ax_id, curr_ax_block.first_field(), collected_fields.size()});
+                                discard = false;
                                }
                            }
                         else
                            {
                             notify_issue( std::format("[{}:{}] `Name` not found in axis block"sv, path(), curr_ax_block.line_idx()) );
                            }
+
+                        if( discard )
+                           {// Discarded block, its fields won't outlive the parsing
+                            m_fields.erase(m_fields.begin() + static_cast<std::ptrdiff_t>(curr_ax_block.first_field()), m_fields.end());
+                           }
                        }
                     else if( line.name()!="Note"sv )
                        {
-                        notify_issue( std::format("[{}:{}] Unexpected end tag `{}` inside axis block"sv, path(), m_lines.size()+1, line.name()) );
+                        notify_issue( std::format("[{}:{}] Unexpected end tag `{}` inside axis block"sv, path(), lines_count()+1, line.name()) );
                        }
                    }
                 else if( line.is_start_tag() )
                    {
-                    notify_issue( std::format("[{}:{}] Unexpected start tag `{}` inside axis block"sv, path(), m_lines.size()+1, line.name()) );
+                    notify_issue( std::format("[{}:{}] Unexpected start tag `{}` inside axis block"sv, path(), lines_count()+1, line.name()) );
                    }
                 else if( line.is_assignment() )
                    {// Collect axis fields
-                    if( curr_ax_block.collected_fields().contains(line.name()) )
+                    if( const auto pos = static_cast<MG::flat_hash_index::pos_type>(m_fields.size());
+                        curr_ax_block.fields_by_name().find_or_insert(line.name(), pos, name_of_field)!=pos )
                        {
-                        notify_issue( std::format("[{}:{}] Duplicate field `{}`"sv, path(), m_lines.size()+1, line.name()) );
+                        notify_issue( std::format("[{}:{}] Duplicate field `{}`"sv, path(), lines_count()+1, line.name()) );
                        }
                     else
                        {
-                        // Populate the map of fields
-                        const auto [it, inserted] = curr_ax_block.collected_fields().try_emplace( line.name(), // key
-                                                                                                  line.name(),
-                                                                                                  line.value(),
-                                                                                                  line.comment(),
-                                                                                                  ""sv,
-                                                                                                  m_lines.size() );
-                        line_associated_field = &(it->second);
-                        if( not inserted )
-                           {
-                            notify_issue( std::format("[{}:{}] Field `{}` was not inserted"sv, path(), m_lines.size()+1, line.name()) );
-                           }
+                        m_fields.emplace_back( line.name(),
+                                               line.value(),
+                                               line.comment(),
+                                               ""sv,
+                                               lines_count() );
                        }
                    }
                }
@@ -202,19 +273,58 @@ class File final : public sipro::TxtFile
                    }
                 else if( line.is_start_tag() and line.name().ends_with("Ax") )
                    {// Detect entering Ax definition block [Start###Ax]
-                    curr_ax_block.start(line.name(), m_lines.size()+1);
+                    curr_ax_block.start(line.name(), lines_count()+1, m_fields.size());
                    }
                 else if( line.is_assignment() )
                    {
-                    notify_issue( std::format("[{}:{}] Unexpected field `{}` outside axis block"sv, path(), m_lines.size()+1, line.name()) );
+                    notify_issue( std::format("[{}:{}] Unexpected field `{}` outside axis block"sv, path(), lines_count()+1, line.name()) );
                    }
                }
 
             // All lines are collected to reproduce the original file
-            m_lines.emplace_back( line.content(), line_associated_field );
+            add_line( line.content() );
            }
 
         parser.check_unclosed_note_block();
+
+        // A field of an unterminated block won't be associated to its line
+        if( curr_ax_block ) m_fields.erase(m_fields.begin() + static_cast<std::ptrdiff_t>(curr_ax_block.first_field()), m_fields.end());
+
+        build_axes_directory(blocks);
+       }
+
+    //-----------------------------------------------------------------------
+    // Arranging the fields by axis name and field name, then
+    // associating them to their lines
+    void build_axes_directory(std::vector<block_t>& blocks)
+       {
+        std::ranges::sort(blocks, {}, &block_t::name);
+
+        std::vector<field_t> sorted_fields;
+        sorted_fields.reserve( m_fields.size() );
+        m_axes.reserve( blocks.size() );
+        for( const auto& block : blocks )
+           {
+            const auto first = m_fields.begin() + static_cast<std::ptrdiff_t>(block.first_field);
+            std::ranges::sort(first, first + static_cast<std::ptrdiff_t>(block.fields_count), {}, &field_t::var_name);
+            m_axes.emplace_back(block.name, block.id, std::span<field_t>{});
+            sorted_fields.insert(sorted_fields.end(), std::make_move_iterator(first), std::make_move_iterator(first + static_cast<std::ptrdiff_t>(block.fields_count)));
+           }
+        m_fields = std::move(sorted_fields);
+
+        std::size_t first = 0;
+        for( std::size_t i=0; i<m_axes.size(); ++i )
+           {
+            m_axes[i].set_fields( std::span<field_t>{m_fields}.subspan(first, blocks[i].fields_count) );
+            first += blocks[i].fields_count;
+            if( const auto id = m_axes[i].id() ) m_axes_by_id.emplace_back(*id, static_cast<std::uint32_t>(i));
+           }
+        std::ranges::sort(m_axes_by_id);
+
+        for( field_t& field : m_fields )
+           {
+            associate_field(field);
+           }
        }
 };
 
@@ -225,6 +335,29 @@ class File final : public sipro::TxtFile
 
 
 
+/////////////////////////////////////////////////////////////////////////////
+#if defined(TEST_UNITS) or defined(TEST_BENCHMARKS) /////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+// Axes with distinct names and ids, not in name order
+[[nodiscard]] std::string parax_generated_axes(const std::size_t axes_count)
+   {
+    std::string buf;
+    for( std::size_t i=axes_count; i>0; --i )
+       {
+        buf += std::format("[StartEthercatAx]\n"
+                           "  AxId = {}\n"
+                           "  Name = \"Ax{:03}\"\n"
+                           "  TimeAcc = 0.3\n"
+                           "  MinPos = -{}\n"
+                           "  MaxPos = {}\n"
+                           "[EndEthercatAx]\n", i, i, i, i);
+       }
+    return buf;
+   }
+#endif //////////////////////////////////////////////////////////////////////
+
+
+
 /////////////////////////////////////////////////////////////////////////////
 #ifdef TEST_UNITS ///////////////////////////////////////////////////////////
 /////////////////////////////////////////////////////////////////////////////
@@ -344,7 +477,7 @@ ut::test("basic") = []
     ut::expect( ut::fatal(Xs_MinPos!=nullptr) ) << "Field MinPos not found in axis Xs\n";
 
     const std::string_view new_val = "-123.456"sv;
-    Xs_MinPos->modify_value(new_val);
+    par_file.modify_value(*Xs_MinPos, new_val);
     ut::expect( ut::that % par_file.modified_values_count()==1u );
 
     // Rewrite file
@@ -555,6 +688,80 @@ ut::test("unexpected end tag") = []
     ut::expect( ut::that % out.str() == buf );
    };
 
+
+ut::test("axes directory") = []
+   {
+    constexpr std::size_t axes_count = 30;
+    test::TemporaryFile f("~test-parax-axes.txt", parax_generated_axes(axes_count));
+
+    MG::issues issues;
+    parax::File par_file(f.path().string(), std::ref(issues));
+    ut::expect( ut::that % issues.size()==0u ) << "no issues expected\n";
+    ut::expect( ut::fatal(ut::that % par_file.axes().size()==axes_count) );
+    ut::expect( std::ranges::is_sorted(par_file.axes(), {}, &parax::File::Axis::name) );
+    ut::expect( ut::that % par_file.axes().front().fields().size()==5u );
+    ut::expect( ut::that % par_file.axes().front().fields().front().var_name()=="AxId"sv ) << "fields should be sorted by name\n";
+
+    std::size_t found = 0;
+    for( std::size_t i=1; i<=axes_count; ++i )
+       {
+        const auto* const by_name = par_file.get_fields_of_axis(std::format("Ax{:03}", i));
+        const auto* const by_id = par_file.get_axis_by_id(static_cast<std::uint16_t>(i));
+        if( by_name and by_name==by_id and by_name->get_field("MaxPos"sv) and by_name->get_field("MaxPos"sv)->value()==std::format("{}", i) ) ++found;
+       }
+    ut::expect( ut::that % found==axes_count );
+    ut::expect( par_file.get_axis_by_id(0)==nullptr and par_file.get_fields_of_axis("Ax"sv)==nullptr );
+
+    // Modifying a field through the directory
+    auto* const ax = par_file.get_fields_of_axis("Ax007"sv);
+    ut::expect( ut::fatal(ax!=nullptr) );
+    auto* const min_pos = parax::File::get_field_by_varname(*ax, "MinPos"sv);
+    ut::expect( ut::fatal(min_pos!=nullptr) );
+    par_file.modify_value(*min_pos, "-70"sv);
+    ut::expect( ut::that % par_file.modified_values_count()==1u );
+    MG::string_write out;
+    par_file.write_to(out, {}, ""sv);
+    ut::expect( out.str().contains("  Name = \"Ax007\"\n  TimeAcc = 0.3\n  MinPos = -70\n"sv) ) << "line should be associated to the field\n";
+   };
+
 };///////////////////////////////////////////////////////////////////////////
 #endif // TEST_UNITS ////////////////////////////////////////////////////////
 /////////////////////////////////////////////////////////////////////////////
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+#ifdef TEST_BENCHMARKS //////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+static ut::suite<"parax_file_descriptor_benchmarks"> parax_file_descriptor_benchmarks = []
+{////////////////////////////////////////////////////////////////////////////
+
+ut::test("axes directory throughput") = []
+   {
+    constexpr std::size_t axes_count = 3000;
+    test::TemporaryFile f("~test-parax-axes.txt", parax_generated_axes(axes_count));
+
+    constexpr std::size_t reps = 10;
+    const auto ignore_issue = [](std::string&&) noexcept {};
+    const double parse_elapsed = test::seconds_taken(reps, [&]{ std::ignore = parax::File(f.path().string(), ignore_issue).axes().size(); });
+    const parax::File par_file(f.path().string(), ignore_issue);
+
+    std::vector<std::string> names;
+    for( std::size_t i=1; i<=axes_count; ++i ) names.push_back( std::format("Ax{:03}", i) );
+    std::size_t found = 0;
+    const double lookup_elapsed = test::seconds_taken(reps, [&]
+       {
+        for( std::size_t i=1; i<=axes_count; ++i )
+           {
+            const auto* const by_name = par_file.get_fields_of_axis(names[i-1]);
+            if( by_name and by_name==par_file.get_axis_by_id(static_cast<std::uint16_t>(i)) ) ++found;
+           }
+       });
+    ut::expect( ut::that % found==reps*axes_count );
+    ut::log << std::format("{} axes: parse {:.2f} ms, lookups by name and id {:.1f} M/s\n",
+                           axes_count, parse_elapsed/reps*1e3, static_cast<double>(found)/lookup_elapsed/1e6);
+   };
+
+};///////////////////////////////////////////////////////////////////////////
+#endif // TEST_BENCHMARKS ///////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,95 @@
+﻿#pragma once
+//  ---------------------------------------------
+//  Tell the values that the DB imposes to some
+//  fields of some machines, without adapting
+//  ---------------------------------------------
+//  #include "query_db.hpp" // app::query_db()
+//  ---------------------------------------------
+#include <string>
+#include <string_view>
+#include <vector>
+#include <format>
+
+#include "fnotify_type.hpp" // fnotify_t
+#include "macotec_machine_data.hpp" // macotec::MachineData
+#include "macotec_parameters_database.hpp" // macotec::ParamsDB
+
+using namespace std::literals; // "..."sv
+
+
+namespace app //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+//---------------------------------------------------------------------------
+// Print the effective value of each field (or axis.param) for each
+// machine, with the DB section that set it
+template<typename FPRINT>
+void query_db( const std::string& db_path,
+               const std::vector<macotec::MachineData>& machs,
+               const std::vector<std::string>& fields_names,
+               FPRINT const& print,
+               fnotify_t const& notify_issue )
+{
+    const macotec::ParamsDB db{ db_path, notify_issue, macotec::ParamsDB::parsing::indexed }; // Queried for each field
+    const auto ignore_issue = [](std::string&&) noexcept {};
+    for( const auto& mach : machs )
+       {
+        bool first = true; // The issues of a machine are the same for each field
+        for( const auto& field_name : fields_names )
+           {
+            const auto found = first ? db.effective_value_of(mach, field_name, notify_issue)
+                                     : db.effective_value_of(mach, field_name, ignore_issue);
+            first = false;
+            if( found )
+               {
+                print("{} {}={} ({})\n", mach.string(), field_name, found->value.value(), found->section);
+               }
+            else
+               {
+                print("{} {} not set\n", mach.string(), field_name);
+               }
+           }
+       }
+}
+
+}//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+#ifdef TEST_UNITS ///////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+static ut::suite<"query_db"> query_db_tests = []
+{////////////////////////////////////////////////////////////////////////////
+
+struct issues_t final { int num=0; void operator()(std::string&& msg) noexcept {++num; ut::log << msg << '\n';}; };
+
+ut::test("app::query_db()") = []
+   {
+    test::TemporaryFile db("~test-query-db.txt",
+        "HP :\n"
+        "   {\n"
+        "    \"common\" : { vqBlade_SpdMax: 4000 }\n"
+        "    \"cut-bridge\" : { \"6.0\": { vqBlade_SpdMax: 4282 } }\n"
+        "   }\n"sv);
+
+    issues_t issues;
+    std::string out;
+    const auto print = [&out](const std::string_view msg, const auto&... args){ out += std::vformat(msg, std::make_format_args(args...)); };
+    app::query_db( db.path().string(),
+                   {macotec::MachineData{"ActiveHP-6.0/4.6-(lowe,fast)"sv}, macotec::MachineData{"ActiveHP-4.9/4.6"sv}},
+                   {"vqBlade_SpdMax"s, "vqOther"s},
+                   print,
+                   std::ref(issues) );
+    ut::expect( ut::that % out=="ActiveHP-6.0/4.6-(lowe,fast) vqBlade_SpdMax=4282 (HP:cut-bridge:6.0)\n"
+                                "ActiveHP-6.0/4.6-(lowe,fast) vqOther not set\n"
+                                "ActiveHP-4.9/4.6 vqBlade_SpdMax=4000 (HP:common)\n"
+                                "ActiveHP-4.9/4.6 vqOther not set\n"sv );
+    ut::expect( ut::that % issues.num==1 ) << "just the missing dimension of the second machine\n";
+   };
+
+};///////////////////////////////////////////////////////////////////////////
+#endif // TEST_UNITS ////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
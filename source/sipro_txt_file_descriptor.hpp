@@ -4,11 +4,19 @@
 //  ---------------------------------------------
 //  #include "sipro_txt_file_descriptor.hpp" // sipro::TxtFile
 //  ---------------------------------------------
+#include <cstdint> // std::uint32_t
+#include <cassert>
+#include <limits> // std::numeric_limits
+#include <stdexcept> // std::runtime_error
 #include <vector>
+#include <algorithm> // std::ranges::count
 #include <string>
 #include <string_view>
+#include <unordered_map>
 
-#include "memory_mapped_file.hpp" // sys::memory_mapped_file
+#include "file_content.hpp" // sys::file_content
+#include "string_arena.hpp" // MG::string_arena
+#include "text_patches.hpp" // MG::text_patches
 #include "output_streamable_concept.hpp" // MG::OutputStreamable
 #include "file_write.hpp" // sys::file_write()
 #include "timestamp.hpp" // MG::get_human_readable_timestamp()
@@ -20,62 +28,112 @@ namespace sipro //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 {
 
 /////////////////////////////////////////////////////////////////////////////
+// The views of a field are all in its line after the name,
+// so just their 32 bit offsets from the name are stored
 class TxtField final
 {
+    friend class TxtFile; // The modified values are in its arena
+
  private:
-    std::string_view m_name;
-    std::string_view m_value;
-    std::string m_mod_val;
-    std::string_view m_comment;
-    std::string_view m_label;
-    std::size_t m_line_idx;
+    const char* m_name_ptr;
+    const char* m_mod_val_ptr = nullptr;
+    std::uint32_t m_name_len;
+    std::uint32_t m_value_off, m_value_len;
+    std::uint32_t m_comment_off, m_comment_len;
+    std::uint32_t m_label_off, m_label_len;
+    std::uint32_t m_mod_val_len = 0;
+    std::uint32_t m_line_idx;
 
  public:
     explicit TxtField( const std::string_view nam,
                        const std::string_view val,
                        const std::string_view cmt,
                        const std::string_view lbl,
-                       const std::size_t ln_idx )
-      : m_name(nam)
-      , m_value(val)
-      , m_comment(cmt)
-      , m_label(lbl)
-      , m_line_idx(ln_idx)
+                       const std::size_t ln_idx ) noexcept
+      : m_name_ptr(nam.data())
+      , m_name_len(static_cast<std::uint32_t>(nam.size()))
+      , m_value_off(offset_of(val))
+      , m_value_len(static_cast<std::uint32_t>(val.size()))
+      , m_comment_off(offset_of(cmt))
+      , m_comment_len(static_cast<std::uint32_t>(cmt.size()))
+      , m_label_off(offset_of(lbl))
+      , m_label_len(static_cast<std::uint32_t>(lbl.size()))
+      , m_line_idx(static_cast<std::uint32_t>(ln_idx))
        {}
 
-    [[nodiscard]] std::string_view var_name() const noexcept { return m_name; }
+    [[nodiscard]] std::string_view var_name() const noexcept { return {m_name_ptr, m_name_len}; }
 
-    [[nodiscard]] std::string_view value() const noexcept { return m_mod_val.empty() ? m_value : m_mod_val; }
-    [[nodiscard]] bool is_value_modified() const noexcept { return not m_mod_val.empty(); }
-    void modify_value(const std::string_view new_val) { m_mod_val = new_val; }
+    [[nodiscard]] std::string_view value() const noexcept { return is_value_modified() ? std::string_view{m_mod_val_ptr, m_mod_val_len} : view_at(m_value_off, m_value_len); }
+    [[nodiscard]] bool is_value_modified() const noexcept { return m_mod_val_len>0; }
 
-    [[nodiscard]] constexpr bool has_comment() const noexcept { return not m_comment.empty(); }
-    [[nodiscard]] constexpr std::string_view comment() const noexcept { return m_comment; }
+    [[nodiscard]] constexpr bool has_comment() const noexcept { return m_comment_len>0; }
+    [[nodiscard]] std::string_view comment() const noexcept { return view_at(m_comment_off, m_comment_len); }
 
-    [[nodiscard]] constexpr bool has_label() const noexcept { return not m_label.empty(); }
-    [[nodiscard]] constexpr std::string_view label() const noexcept { return m_label; }
+    [[nodiscard]] constexpr bool has_label() const noexcept { return m_label_len>0; }
+    [[nodiscard]] std::string_view label() const noexcept { return view_at(m_label_off, m_label_len); }
 
     [[nodiscard]] std::size_t line_index() const noexcept { return m_line_idx; }
+
+ private:
+    [[nodiscard]] std::uint32_t offset_of(const std::string_view sv) const noexcept
+       {
+        if( sv.empty() ) return 0;
+        assert( sv.data()>=m_name_ptr );
+        return static_cast<std::uint32_t>(sv.data() - m_name_ptr);
+       }
+
+    [[nodiscard]] std::string_view view_at(const std::uint32_t off, const std::uint32_t len) const noexcept
+       {
+        if( len==0 ) return {};
+        return {m_name_ptr + off, len};
+       }
+
+    void set_modified_value(const std::string_view stored_val) noexcept
+       {
+        m_mod_val_ptr = stored_val.data();
+        m_mod_val_len = static_cast<std::uint32_t>(stored_val.size());
+       }
 };
 
 
 /////////////////////////////////////////////////////////////////////////////
-class TxtLine final
+// Copy-on-write modifications layered over a parsed TxtFile, so that
+// the same parsed file can be the base of many different outputs
+class TxtOverlay final
 {
  private:
-    std::string_view m_content;
-    TxtField* m_associated_field;
+    std::unordered_map<const TxtField*, std::string> m_mod_vals;
+    std::vector<std::string> m_mod_issues; // Modifications problems
 
  public:
-    explicit TxtLine(const std::string_view l, TxtField* const p =nullptr)
-      : m_content(l)
-      , m_associated_field(p)
-       {}
+    [[nodiscard]] std::string_view value_of(const TxtField& field) const noexcept
+       {
+        if( const auto it=m_mod_vals.find(&field); it!=m_mod_vals.end() )
+           {
+            return it->second;
+           }
+        return field.value();
+       }
 
-    [[nodiscard]] std::string_view content() const noexcept { return m_content; }
+    [[nodiscard]] bool is_value_modified(const TxtField& field) const noexcept
+       {
+        return modifies(field) or field.is_value_modified();
+       }
+
+    [[nodiscard]] bool modifies(const TxtField& field) const noexcept
+       {
+        return m_mod_vals.contains(&field);
+       }
 
-    [[nodiscard]] const TxtField* associated_field() const noexcept { return m_associated_field; }
-    [[nodiscard]] TxtField* associated_field() noexcept { return m_associated_field; }
+    void modify_value(const TxtField& field, const std::string_view new_val)
+       {
+        m_mod_vals.insert_or_assign(&field, std::string{new_val});
+       }
+
+    [[nodiscard]] std::size_t modified_values_count() const noexcept { return m_mod_vals.size(); }
+
+    [[nodiscard]] const std::vector<std::string>& mod_issues() const noexcept { return m_mod_issues; }
+    void add_mod_issue(std::string&& issue) { m_mod_issues.push_back( std::move(issue) ); }
 };
 
 
@@ -84,16 +142,32 @@ class TxtFile
 {
  private:
     const std::string m_path;
-    const sys::memory_mapped_file m_file_buf;
+    const sys::file_content m_file_buf;
     std::vector<std::string> m_mod_issues; // Modifications problems
- protected:
-    std::vector<TxtLine> m_lines;
+    // The lines are contiguous in the buffer (after a possible
+    // BOM), their ends are enough. The parallel array has their fields
+    std::uint32_t m_lines_begin = 0;
+    std::vector<std::uint32_t> m_lines_ends;
+    std::vector<TxtField*> m_lines_fields;
+    MG::string_arena m_mod_vals; // The modified values of the fields
 
  public:
     explicit TxtFile(const std::string& pth)
       : m_path{pth}
-      , m_file_buf{m_path.c_str()}
-       {}
+      , m_file_buf{m_path}
+       {
+        check_size();
+        reserve_lines();
+       }
+
+    // Content not coming from a file, the name is just for the messages
+    explicit TxtFile(const std::string& name, sys::file_content&& content)
+      : m_path{name}
+      , m_file_buf{std::move(content)}
+       {
+        check_size();
+        reserve_lines();
+       }
 
     [[nodiscard]] std::string_view buf() const noexcept { return m_file_buf.as_string_view(); }
     [[nodiscard]] const std::string& path() const noexcept { return m_path; }
@@ -101,71 +175,171 @@ class TxtFile
     [[nodiscard]] const std::vector<std::string>& mod_issues() const noexcept { return m_mod_issues; }
     void add_mod_issue(std::string&& issue) { m_mod_issues.push_back( std::move(issue) ); }
 
+    [[nodiscard]] std::size_t lines_count() const noexcept { return m_lines_ends.size(); }
+
+    //-----------------------------------------------------------------------
+    // The new value is kept by this file, the field must be one of mine
+    void modify_value(TxtField& field, const std::string_view new_val)
+       {
+        field.set_modified_value( m_mod_vals.store(new_val) );
+       }
+
+    //-----------------------------------------------------------------------
+    // Make permanent the modifications collected in an overlay
+    void apply(const TxtOverlay& overlay)
+       {
+        for( TxtField* const field : m_lines_fields )
+           {
+            if( field and overlay.modifies(*field) )
+               {
+                modify_value( *field, overlay.value_of(*field) );
+               }
+           }
+        m_mod_issues.insert(m_mod_issues.end(), overlay.mod_issues().begin(), overlay.mod_issues().end());
+       }
+
+    //-----------------------------------------------------------------------
+    void write_to(const std::string& pth, const MG::options_set& options, const std::string_view add_info ={}) const
+       {
+        write_to(pth, TxtOverlay{}, options, add_info);
+       }
+    void write_to(MG::OutputStreamable auto& fw, const MG::options_set& options, const std::string_view add_info) const
+       {
+        write_to(fw, TxtOverlay{}, options, add_info);
+       }
+
     //-----------------------------------------------------------------------
-    void write_to(const std::string& pth, const MG::options_set& options, const std::string_view add_info ={})
+    // Write applying the modifications of an overlay: the output is
+    // my buffer with the modified lines patched, written in one go
+    void write_to(const std::string& pth, const TxtOverlay& overlay, const MG::options_set& options, const std::string_view add_info ={}) const
        {
+        const MG::text_patches patches = patches_of(options, add_info, overlay);
+        const std::vector<std::string_view> fragments = patches.fragments_of(buf(), lines_begin(), lines_end());
         sys::file_write fw( pth.c_str() );
-        write_to(fw, options, add_info);
+        fw.write_all(fragments);
        }
-    void write_to(MG::OutputStreamable auto& fw, const MG::options_set& options, const std::string_view add_info)
+    void write_to(MG::OutputStreamable auto& fw, const TxtOverlay& overlay, const MG::options_set& options, const std::string_view add_info) const
        {
-        const std::string_view endline = not m_lines.empty() and
-                                         m_lines.front().content().length()>1 and
-                                         m_lines.front().content()[m_lines.front().content().length()-2]=='\r'
+        const MG::text_patches patches = patches_of(options, add_info, overlay);
+        for( const std::string_view fragment : patches.fragments_of(buf(), lines_begin(), lines_end()) )
+           {
+            fw << fragment;
+           }
+       }
+
+ private:
+    //-----------------------------------------------------------------------
+    void check_size() const
+       {
+        if( buf().size() > std::numeric_limits<std::uint32_t>::max() )
+           {
+            throw std::runtime_error( std::format("{} is too big", m_path) );
+           }
+       }
+
+    //-----------------------------------------------------------------------
+    // Counting the lines is much cheaper than growing the arrays
+    void reserve_lines()
+       {
+        const std::size_t lines_count = static_cast<std::size_t>(std::ranges::count(buf(), '\n')) + 1u;
+        m_lines_ends.reserve(lines_count);
+        m_lines_fields.reserve(lines_count);
+       }
+
+    [[nodiscard]] std::size_t lines_begin() const noexcept { return m_lines_begin; }
+    [[nodiscard]] std::size_t lines_end() const noexcept { return m_lines_ends.empty() ? m_lines_begin : m_lines_ends.back(); }
+
+    //-----------------------------------------------------------------------
+    // The lines of the modified fields and the info
+    // added before [EndNote], in ascending order
+    [[nodiscard]] MG::text_patches patches_of(const MG::options_set& options, const std::string_view add_info, const TxtOverlay& overlay) const
+       {
+        MG::text_patches patches;
+        const std::string_view endline = lines_count()>0 and
+                                         line_content(0).length()>1 and
+                                         line_content(0)[line_content(0).length()-2]=='\r'
                                          ? "\r\n"sv : "\n"sv;
         bool block_comment_notyetfound = true;
-        for( const auto& line : m_lines )
+        for( std::size_t i=0; i<lines_count(); ++i )
            {
-            const TxtField* const field = line.associated_field();
-            if( field and field->is_value_modified() )
+            const std::string_view line = line_content(i);
+            const TxtField* const field = m_lines_fields[i];
+            if( field and overlay.is_value_modified(*field) )
                {// This line is a field with modified value, reconstructing the line
                 // Detect indentation
-                const std::ptrdiff_t indent_len = field->var_name().data() - line.content().data();
+                const std::ptrdiff_t indent_len = field->var_name().data() - line.data();
                 assert(indent_len>=0);
-                fw << line.content().substr(0u, static_cast<std::size_t>(indent_len))
-                   << field->var_name()
-                   << " = "sv
-                   << field->value();
+                const auto line_begin = static_cast<std::size_t>(line.data() - buf().data());
+                patches.replace(line_begin + static_cast<std::size_t>(indent_len), line_begin + line.size());
+                patches << field->var_name()
+                        << " = "sv
+                        << overlay.value_of(*field);
 
                 if( field->has_comment() )
                    {
-                    fw << " # "sv << field->comment();
+                    patches << " # "sv << field->comment();
                     if( field->has_label() )
                        {
-                        fw << " '"sv << field->label() << '\'';
+                        patches << " '"sv << field->label() << '\'';
                        }
                    }
 
-                fw << endline;
+                patches << endline;
                }
-            else if( block_comment_notyetfound and line.content().contains("[EndNote]") )
+            else if( block_comment_notyetfound and line.contains("[EndNote]") )
                {
                 block_comment_notyetfound = false;
                 // Adding some info on generated file
-                fw << "    "sv;
+                const auto line_begin = static_cast<std::size_t>(line.data() - buf().data());
+                patches.replace(line_begin, line_begin);
+                patches << "    "sv;
                 if( not options.contains("no-timestamp"sv) )
                    {
-                    fw << MG::get_human_readable_timestamp() << ' ';
+                    patches << MG::get_human_readable_timestamp() << ' ';
                    }
-                fw << app::name << ", "sv << std::to_string(mod_issues().size()) << " issues"sv << endline;
+                patches << app::name << ", "sv << std::to_string(mod_issues().size() + overlay.mod_issues().size()) << " issues"sv << endline;
                 if( not add_info.empty() )
                    {
-                    fw << "    "sv << add_info << endline;
+                    patches << "    "sv << add_info << endline;
                    }
                 for( const auto& issue : mod_issues() )
                    {
-                    fw << "    ! "sv << issue << endline;
+                    patches << "    ! "sv << issue << endline;
+                   }
+                for( const auto& issue : overlay.mod_issues() )
+                   {
+                    patches << "    ! "sv << issue << endline;
                    }
-                fw << line.content();
-               }
-            else
-               {// Write original unmodified line
-                fw << line.content();
                }
            }
+        return patches;
        }
 
  protected:
+    //-----------------------------------------------------------------------
+    // The parsed lines must be added in order
+    void add_line(const std::string_view content)
+       {
+        if( m_lines_ends.empty() )
+           {
+            m_lines_begin = static_cast<std::uint32_t>(content.data() - buf().data());
+           }
+        assert( content.data()==buf().data() + (m_lines_ends.empty() ? m_lines_begin : m_lines_ends.back()) );
+        m_lines_ends.push_back( static_cast<std::uint32_t>(content.data() + content.size() - buf().data()) );
+        m_lines_fields.push_back(nullptr);
+       }
+
+    void associate_field(TxtField& field) noexcept { m_lines_fields[field.line_index()] = &field; }
+
+    // An upper bound of the fields, to reserve their arrays
+    [[nodiscard]] std::size_t expected_lines_count() const noexcept { return m_lines_ends.capacity(); }
+
+    [[nodiscard]] std::string_view line_content(const std::size_t i) const noexcept
+       {
+        const std::uint32_t start = i>0 ? m_lines_ends[i-1] : m_lines_begin;
+        return buf().substr(start, m_lines_ends[i]-start);
+       }
+
     //-----------------------------------------------------------------------
     [[nodiscard]] static auto extract_comment_label(const std::string_view sv) noexcept
        {// "comment 'label'" => "comment", "label"
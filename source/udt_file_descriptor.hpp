@@ -5,9 +5,14 @@
 //  ---------------------------------------------
 //  #include "udt_file_descriptor.hpp" // udt::File
 //  ---------------------------------------------
+#include <cstdint> // std::uint16_t
 #include <map>
+#include <utility> // std::pair
+#include <vector>
+#include <algorithm> // std::ranges::sort, std::ranges::lower_bound
 #include <format>
 
+#include "flat_hash_index.hpp" // MG::flat_hash_index
 #include "string_similarity.hpp" // str::are_similar
 #include "string_utilities.hpp" // str::trim_right()
 #include "sipro_txt_parser.hpp" // sipro::TxtParser
@@ -22,33 +27,51 @@ namespace udt //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 class File final : public sipro::TxtFile
 {
     using field_t = sipro::TxtField;
-    using fields_t = std::map<std::string_view, field_t>;
+    using fields_t = std::vector<field_t>; // Sorted by label
+    struct label_of_pos final
+       {// Key of m_fields_by_label
+        const fields_t& fields;
+        [[nodiscard]] std::string_view operator()(const MG::flat_hash_index::pos_type pos) const noexcept { return fields[pos].label(); }
+       };
 
  private:
     fields_t m_fields;
+    MG::flat_hash_index m_fields_by_label;
 
  public:
+    class RenameIndex;
+    static constexpr std::uint16_t rename_max_index_distance = 20;
+    static constexpr std::size_t rename_comment_prefix_len = 3; // Typically the unit of measure
+
     explicit File(const std::string& pth, fnotify_t const& notify_issue)
       : sipro::TxtFile{pth}
        {
         parse( notify_issue );
        }
 
+    explicit File(const std::string& name, sys::file_content&& content, fnotify_t const& notify_issue)
+      : sipro::TxtFile{name, std::move(content)}
+       {
+        parse( notify_issue );
+       }
+
+
+    [[nodiscard]] const fields_t& fields() const noexcept { return m_fields; } // By label
 
     //-----------------------------------------------------------------------
     [[nodiscard]] const field_t* get_field_by_label(const std::string_view varlbl) const noexcept
        {
-        if( const auto it=m_fields.find(varlbl); it!=m_fields.end() )
+        if( const auto pos=m_fields_by_label.find(varlbl, label_of_pos{m_fields}) )
            {
-            return &(it->second);
+            return &m_fields[*pos];
            }
         return nullptr;
        }
     [[nodiscard]] field_t* get_field_by_label(const std::string_view varlbl) noexcept
        {
-        if( const auto it=m_fields.find(varlbl); it!=m_fields.end() )
+        if( const auto pos=m_fields_by_label.find(varlbl, label_of_pos{m_fields}) )
            {
-            return &(it->second);
+            return &m_fields[*pos];
            }
         return nullptr;
        }
@@ -58,7 +81,7 @@ class File final : public sipro::TxtFile
     [[nodiscard]] std::size_t modified_values_count() const noexcept
        {
         std::size_t count = 0;
-        for( const auto& [varlbl, field] : m_fields )
+        for( const field_t& field : m_fields )
            {
             if( field.is_value_modified() ) ++count;
            }
@@ -69,33 +92,44 @@ class File final : public sipro::TxtFile
     //-----------------------------------------------------------------------
     [[nodiscard]] std::string info_string() const
        {
-        return std::format("{} lines, {} fields", m_lines.size(), m_fields.size());
+        return std::format("{} lines, {} fields", lines_count(), m_fields.size());
        }
 
 
     //-----------------------------------------------------------------------
     void overwrite_values_from(File const& other_file) noexcept
        {
-        for( const auto& [his_varlbl, his_field] : other_file.m_fields )
+        sipro::TxtOverlay overlay;
+        overwrite_values_from(other_file, overlay);
+        apply(overlay);
+       }
+
+    //-----------------------------------------------------------------------
+    // Collect in the overlay the values of the other file, leaving this untouched.
+    // When merging many files, an index of this can speed up the renames detection
+    void overwrite_values_from(File const& other_file, sipro::TxtOverlay& overlay, const RenameIndex* const rename_index =nullptr) const
+       {
+        for( const field_t& his_field : other_file.m_fields )
            {
+            const std::string_view his_varlbl = his_field.label();
             if( his_varlbl == "vqMachSettingsVer"sv )
                {// Skipping: I'll keep my own value
                }
-            else if( auto my_field = get_field_by_label(his_varlbl);
+            else if( const auto my_field = get_field_by_label(his_varlbl);
                      my_field!=nullptr )
                {// I have its field, update my value
-                my_field->modify_value( his_field.value() );
+                overlay.modify_value( *my_field, his_field.value() );
                }
             // Field not found, detect possible renames
-            else if( const auto [renmd_varlbl, renmd_field] = detect_rename_of(his_field);
+            else if( const auto [renmd_varlbl, renmd_field] = detect_rename_of(his_field, overlay, rename_index);
                      renmd_field!=nullptr )
                {
-                add_mod_issue( std::format("Renamed: {}={} => {}={} (verify)", his_varlbl, his_field.value(), renmd_varlbl, renmd_field->value()) );
-                renmd_field->modify_value( his_field.value() );
+                overlay.add_mod_issue( std::format("Renamed: {}={} => {}={} (verify)", his_varlbl, his_field.value(), renmd_varlbl, overlay.value_of(*renmd_field)) );
+                overlay.modify_value( *renmd_field, his_field.value() );
                }
             else
                {
-                add_mod_issue( std::format("Not found: {}={} (removed or renamed)", his_varlbl, his_field.value()) );
+                overlay.add_mod_issue( std::format("Not found: {}={} (removed or renamed)", his_varlbl, his_field.value()) );
                }
            }
        }
@@ -105,117 +139,256 @@ class File final : public sipro::TxtFile
     //-----------------------------------------------------------------------
     void parse(fnotify_t const& notify_issue)
        {
-        std::map<std::string_view, std::string_view> var_names;
+        std::vector<std::string_view> var_names;
+        var_names.reserve( expected_lines_count() );
+        MG::flat_hash_index var_names_index( expected_lines_count() );
+        m_fields.reserve( expected_lines_count() );
+        m_fields_by_label.reserve( expected_lines_count() );
         sipro::TxtParser parser( buf() );
         parser.set_file_path( path() );
         parser.set_on_notify_issue(notify_issue);
 
         while( const auto& line = parser.next_line() )
            {
-            field_t* line_associated_field = nullptr;
-
             if( line.is_assignment() )
                {
                 const auto [cmt, lbl] = extract_comment_label( line.comment() );
 
-                if( var_names.contains(line.name()) )
+                if( const auto pos = static_cast<MG::flat_hash_index::pos_type>(var_names.size());
+                    var_names_index.find_or_insert(line.name(), pos, [&var_names](const auto p) noexcept { return var_names[p]; })!=pos )
                    {
-                    notify_issue( std::format("[{}:{}] Duplicate variable name `{}`"sv, path(), m_lines.size()+1, line.name()) );
+                    notify_issue( std::format("[{}:{}] Duplicate variable name `{}`"sv, path(), lines_count()+1, line.name()) );
                    }
                 else
                    {
-                    var_names.try_emplace(line.name(), lbl);
+                    var_names.push_back( line.name() );
                    }
 
                 if( lbl.empty() )
                    {
-                    notify_issue( std::format("[{}:{}] Unlabeled variable `{}`"sv, path(), m_lines.size()+1, line.name()) );
+                    notify_issue( std::format("[{}:{}] Unlabeled variable `{}`"sv, path(), lines_count()+1, line.name()) );
                    }
-                else if( m_fields.contains(lbl) )
+                else if( const auto pos = static_cast<MG::flat_hash_index::pos_type>(m_fields.size());
+                         m_fields_by_label.find_or_insert(lbl, pos, label_of_pos{m_fields})!=pos )
                    {
-                    notify_issue( std::format("[{}:{}] Duplicate variable label `{}`"sv, path(), m_lines.size()+1, lbl) );
+                    notify_issue( std::format("[{}:{}] Duplicate variable label `{}`"sv, path(), lines_count()+1, lbl) );
                    }
                 else
                    {
-                    const auto [it, inserted] = m_fields.try_emplace( lbl, // key
-                                                                      line.name(),
-                                                                      line.value(),
-                                                                      cmt,
-                                                                      lbl,
-                                                                      m_lines.size() );
-                    line_associated_field = &(it->second);
-                    if( not inserted )
-                       {
-                        notify_issue( std::format("[{}:{}] Field `{}` was not inserted"sv, path(), m_lines.size()+1, lbl) );
-                       }
+                    m_fields.emplace_back( line.name(),
+                                           line.value(),
+                                           cmt,
+                                           lbl,
+                                           lines_count() );
                    }
                }
 
             // All lines are collected to reproduce the original file
-            m_lines.emplace_back( line.content(), line_associated_field );
+            add_line( line.content() );
            }
 
         parser.check_unclosed_note_block();
+
+        // Now that the fields won't move, sorting them by label
+        // and associating them to their lines
+        std::ranges::sort(m_fields, {}, &field_t::label);
+        m_fields_by_label.clear();
+        for( std::size_t i=0; i<m_fields.size(); ++i )
+           {
+            field_t& field = m_fields[i];
+            std::ignore = m_fields_by_label.find_or_insert(field.label(), static_cast<MG::flat_hash_index::pos_type>(i), label_of_pos{m_fields});
+            associate_field(field);
+           }
        }
 
+    //-----------------------------------------------------------------------
+    [[nodiscard]] std::pair<std::string_view,const field_t*> detect_rename_of(field_t const& his_field, const sipro::TxtOverlay& overlay, const RenameIndex* const rename_index) const noexcept;
 
     //-----------------------------------------------------------------------
-    [[nodiscard]] std::pair<std::string_view,field_t*> detect_rename_of(field_t const& his_field) noexcept
+    [[nodiscard]] static bool is_rename_of(field_t const& my_field, field_t const& his_field, const sipro::Register& his_reg, const sipro::TxtOverlay& overlay)
        {
-        try{
-            const sipro::Register his_reg(his_field.var_name());
-
-            for( auto& [my_varlbl, my_field] : m_fields )
+        if( my_field.var_name() == his_field.var_name() ) // Stesso registro...
+           {
+            return str::have_same_prefix(my_field.comment(), his_field.comment(), rename_comment_prefix_len) and //...Stesso inizio commento (unità di misura)...
+                   str::are_similar(my_field.comment(), his_field.comment(), 0.7); //...Commento piuttosto simile
+           }
+        else if( his_reg.is_valid() ) //...Il suo è un registro Sipro...
+           {
+            if( const sipro::Register my_reg(my_field.var_name());
+                my_reg.is_valid() ) //...Anche il mio è un registro Sipro...
                {
-                if( my_field.var_name() == his_field.var_name() ) // Stesso registro...
+                const auto sim_threshold = [](const double delta) constexpr -> double
+                   {// Parto da 0.7 e tendo verso 1.0 allontanandomi
+                    return 1.0 - ( (1.0-0.7) / (1.0 + 0.05*(delta-1.0)) );
+                   };
+                using idx_t = decltype(my_reg.index());
+                const auto calc_delta_idx = [](const idx_t idx1, const idx_t idx2) constexpr -> double
                    {
-                    if( str::have_same_prefix(my_field.comment(), his_field.comment(), 3) and //...Stesso inizio commento (unità di misura)...
-                        str::are_similar(my_field.comment(), his_field.comment(), 0.7) ) //...Commento piuttosto simile
-                       {//...È una ridenominazione
-                        return {my_varlbl, &my_field};
-                       }
-                   }
-                else if( his_reg.is_valid() ) //...Il suo è un registro Sipro...
+                    double diff = static_cast<double>(idx1) - static_cast<double>(idx2);
+                    if(diff<0.0) diff = -diff;
+                    return diff;
+                   };
+                const double delta_idx = calc_delta_idx(my_reg.index(), his_reg.index());
+                return are_same_type(my_reg,his_reg) and //...Registri dello stesso tipo...
+                       delta_idx<rename_max_index_distance and // ...L'indirizzo non è troppo lontano...
+                       overlay.value_of(my_field) == his_field.value() and // ...Stesso letterale del valore...
+                       str::have_same_prefix(my_field.comment(), his_field.comment(), rename_comment_prefix_len) and //...Stesso inizio commento (unità di misura)...
+                       str::are_similar(my_field.comment(), his_field.comment(), sim_threshold(delta_idx)); //...Commento simile in base a distanza registri...
+               }
+           }
+        return false;
+       }
+};
+
+
+/////////////////////////////////////////////////////////////////////////////
+// The fields of a file that could be a rename of a missing one:
+// same register, or register of same type not too far, and in both
+// cases same comment prefix. Built once and shared when merging many
+// files, spares the scan of all fields and most of the similarities
+class File::RenameIndex final
+{
+ private:
+    struct candidate_t final
+       {
+        std::size_t ordinal; // To preserve the fields order
+        std::uint16_t reg_index;
+        std::string_view label;
+        const field_t* field;
+       };
+    using key_t = std::pair<std::string_view,std::string_view>; // Var name or register type, comment prefix
+    std::map<key_t, std::vector<candidate_t>> m_by_var_name;
+    std::map<key_t, std::vector<candidate_t>> m_by_reg_type; // Sorted by register index
+
+ public:
+    explicit RenameIndex(const File& file)
+       {
+        std::size_t ordinal = 0;
+        for( const field_t& field : file.m_fields )
+           {
+            const candidate_t cand{ .ordinal=ordinal++, .reg_index=0, .label=field.label(), .field=&field };
+            if( field.comment().size()<rename_comment_prefix_len )
+               {// Cannot be a rename
+                continue;
+               }
+            const std::string_view cmt_prefix = field.comment().substr(0, rename_comment_prefix_len);
+            m_by_var_name[{field.var_name(), cmt_prefix}].push_back(cand);
+            if( const sipro::Register reg(field.var_name()); reg.is_valid() )
+               {
+                m_by_reg_type[{reg.iec_type(), cmt_prefix}].emplace_back(cand).reg_index = reg.index();
+               }
+           }
+        for( auto& [reg_type, cands] : m_by_reg_type )
+           {
+            std::ranges::stable_sort(cands, {}, &candidate_t::reg_index);
+           }
+       }
+
+    //-----------------------------------------------------------------------
+    // In the same order of the fields, to get the same first match
+    [[nodiscard]] std::vector<std::pair<std::string_view,const field_t*>> candidates_of(field_t const& his_field, const sipro::Register& his_reg) const
+       {
+        if( his_field.comment().size()<rename_comment_prefix_len )
+           {
+            return {};
+           }
+        const std::string_view cmt_prefix = his_field.comment().substr(0, rename_comment_prefix_len);
+
+        std::vector<const candidate_t*> found;
+        if( const auto it=m_by_var_name.find({his_field.var_name(), cmt_prefix}); it!=m_by_var_name.end() )
+           {
+            for( const auto& cand : it->second ) found.push_back(&cand);
+           }
+        if( his_reg.is_valid() )
+           {
+            if( const auto it=m_by_reg_type.find({his_reg.iec_type(), cmt_prefix}); it!=m_by_reg_type.end() )
+               {
+                const std::uint16_t min_idx = his_reg.index()<rename_max_index_distance ? 0u : static_cast<std::uint16_t>(his_reg.index() - rename_max_index_distance + 1u);
+                const auto first = std::ranges::lower_bound(it->second, min_idx, {}, &candidate_t::reg_index);
+                for( auto i=first; i!=it->second.end() and i->reg_index<his_reg.index()+rename_max_index_distance; ++i )
                    {
-                    if( const sipro::Register my_reg(my_field.var_name());
-                        my_reg.is_valid() ) //...Anche il mio è un registro Sipro...
-                       {
-                        const auto sim_threshold = [](const double delta) constexpr -> double
-                           {// Parto da 0.7 e tendo verso 1.0 allontanandomi
-                            return 1.0 - ( (1.0-0.7) / (1.0 + 0.05*(delta-1.0)) );
-                           };
-                        using idx_t = decltype(my_reg.index());
-                        const auto calc_delta_idx = [](const idx_t idx1, const idx_t idx2) constexpr -> double
-                           {
-                            double diff = static_cast<double>(idx1) - static_cast<double>(idx2);
-                            if(diff<0.0) diff = -diff;
-                            return diff;
-                           };
-                        const double delta_idx = calc_delta_idx(my_reg.index(), his_reg.index());
-                        if( are_same_type(my_reg,his_reg) and //...Registri dello stesso tipo...
-                            delta_idx<20 and // ...L'indirizzo non è troppo lontano...
-                            my_field.value() == his_field.value() and // ...Stesso letterale del valore...
-                            str::have_same_prefix(my_field.comment(), his_field.comment(), 3) and //...Stesso inizio commento (unità di misura)...
-                            str::are_similar(my_field.comment(), his_field.comment(), sim_threshold(delta_idx)) ) //...Commento simile in base a distanza registri...
-                           {//...È una ridenominazione
-                            return {my_varlbl, &my_field};
-                           }
-                       }
+                    found.push_back(&*i);
                    }
                }
            }
-        catch(...){}
-        return {{},nullptr};
+        std::ranges::sort(found, {}, &candidate_t::ordinal);
+        const auto [dup_begin, dup_end] = std::ranges::unique(found, {}, &candidate_t::ordinal);
+        found.erase(dup_begin, dup_end);
+
+        std::vector<std::pair<std::string_view,const field_t*>> candidates;
+        candidates.reserve( found.size() );
+        for( const candidate_t* cand : found )
+           {
+            candidates.emplace_back(cand->label, cand->field);
+           }
+        return candidates;
        }
 };
 
 
+//---------------------------------------------------------------------------
+std::pair<std::string_view,const sipro::TxtField*> File::detect_rename_of(field_t const& his_field, const sipro::TxtOverlay& overlay, const RenameIndex* const rename_index) const noexcept
+{
+    try{
+        const sipro::Register his_reg(his_field.var_name());
+        if( rename_index )
+           {
+            for( const auto& [my_varlbl, my_field] : rename_index->candidates_of(his_field, his_reg) )
+               {
+                if( is_rename_of(*my_field, his_field, his_reg, overlay) ) return {my_varlbl, my_field};
+               }
+           }
+        else
+           {
+            for( const field_t& my_field : m_fields )
+               {
+                if( is_rename_of(my_field, his_field, his_reg, overlay) ) return {my_field.label(), &my_field};
+               }
+           }
+       }
+    catch(...){}
+    return {{},nullptr};
+}
+
+
 }//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 
 
 
 
 
+/////////////////////////////////////////////////////////////////////////////
+#if defined(TEST_UNITS) or defined(TEST_BENCHMARKS) /////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+// A big file with distinct registers and labels
+[[nodiscard]] std::string udt_generated_content(const int fields_count)
+   {
+    std::string content = "[StartNote]\n  Generated\n[EndNote]\n[StartUdt]\n  [StartVars]\n";
+    for( int i=0; i<fields_count; ++i )
+       {
+        content += std::format("    vq{} = {}.5 # [mm] Parameter number {} 'vqParam_{}'\n", i, i, i, i);
+       }
+    content += "  [EndVars]\n[EndUdt]\n";
+    return content;
+   }
+
+//---------------------------------------------------------------------------
+// The template has the registers shifted and some comments changed
+[[nodiscard]] std::pair<std::string,std::string> udt_renamed_contents(const int fields_count)
+   {
+    std::string old_content, new_content;
+    for( int i=0; i<fields_count; ++i )
+       {
+        const char* const unit = i%3==0 ? "[mm]" : i%3==1 ? "[s]" : "[mm/s]";
+        old_content += std::format("vq{} = {} # {} Parameter {} of group {} 'vqOld_{}'\n", i, i%7, unit, i, i/10, i);
+        new_content += std::format("vq{} = {} # {} Parameter {} of group {} 'vqNew_{}'\n", i + i%5, i%7, i%11==0 ? "[m]" : unit, i%13==0 ? i+1 : i, i/10, i);
+       }
+    return {old_content, new_content};
+   }
+#endif //////////////////////////////////////////////////////////////////////
+
+
+
 /////////////////////////////////////////////////////////////////////////////
 #ifdef TEST_UNITS ///////////////////////////////////////////////////////////
 /////////////////////////////////////////////////////////////////////////////
@@ -298,7 +471,7 @@ ut::test("basic") = []
     auto* const vqEnabledSettings = udt_file.get_field_by_label("vqEnabledSettings"sv);
     ut::expect( ut::fatal(vqEnabledSettings!=nullptr) ) << "vqEnabledSettings not found\n";
     const std::string_view new_val = "1234.567"sv;
-    vqEnabledSettings->modify_value(new_val);
+    udt_file.modify_value(*vqEnabledSettings, new_val);
     ut::expect( ut::that % udt_file.modified_values_count()==1u );
 
     // Rewrite file
@@ -372,6 +545,82 @@ ut::test("detect tricky rename") = []
    };
 
 
+ut::test("overwrite values in an overlay") = []
+   {
+    test::TemporaryFile f_old("~test-overlay-old.udt", "vn100 = oldval # Comment 'Kept'\nvn101 = 1 # Comment 'Removed'\n"sv);
+    test::TemporaryFile f_new("~test-overlay-new.udt", "vn100 = newval # Comment 'Kept'\n"sv);
+
+    issues_t issues;
+    const udt::File udt_old(f_old.path().string(), std::ref(issues));
+    const udt::File udt_new(f_new.path().string(), std::ref(issues));
+    ut::expect( ut::that % issues.num==0 ) << "no issues expected\n";
+
+    sipro::TxtOverlay overlay;
+    udt_new.overwrite_values_from(udt_old, overlay);
+
+    const auto* const fld = udt_new.get_field_by_label("Kept"sv);
+    ut::expect( ut::fatal(fld!=nullptr) ) << "Field not found\n";
+    ut::expect( ut::that % fld->value()=="newval"sv ) << "file should be untouched\n";
+    ut::expect( ut::that % overlay.value_of(*fld)=="oldval"sv );
+    ut::expect( ut::that % overlay.modified_values_count()==1u );
+    ut::expect( ut::that % udt_new.mod_issues().size()==0u );
+    ut::expect( ut::fatal(overlay.mod_issues().size()==1u) );
+    ut::expect( ut::that % overlay.mod_issues().back()=="Not found: Removed=1 (removed or renamed)"sv );
+   };
+
+
+ut::test("rename index") = []
+   {
+    test::TemporaryFile f_old("~test-index-old.udt",
+        "vn100 = oldval # Comment 'Previous'\n"
+        "vq1255 = val # [mm] Comment 'TrickyPrev'\n"
+        "vq1200 = val # [mm] Comment 'TooFar'\n"
+        "vd10 = 1.5 # [s] Some time 'Kept'\n"sv);
+    test::TemporaryFile f_new("~test-index-new.udt",
+        "vn100 = newval # Comment mod 'Renamed'\n"
+        "vq1262 = val # [mm] Comment2 'TrickyRenamed'\n"
+        "vq1230 = val # [mm] Comment3 'FarAway'\n"
+        "vd10 = 0.0 # [s] Some time 'Kept'\n"sv);
+
+    issues_t issues;
+    const udt::File udt_old(f_old.path().string(), std::ref(issues));
+    const udt::File udt_new(f_new.path().string(), std::ref(issues));
+    ut::expect( ut::that % issues.num==0 ) << "no issues expected\n";
+
+    sipro::TxtOverlay overlay_scan, overlay_indexed;
+    udt_new.overwrite_values_from(udt_old, overlay_scan);
+    const udt::File::RenameIndex rename_index(udt_new);
+    udt_new.overwrite_values_from(udt_old, overlay_indexed, &rename_index);
+
+    ut::expect( ut::that % overlay_indexed.modified_values_count()==overlay_scan.modified_values_count() );
+    ut::expect( ut::fatal(ut::that % overlay_indexed.mod_issues().size()==3u) );
+    ut::expect( overlay_indexed.mod_issues()==overlay_scan.mod_issues() ) << "index should give the same renames\n";
+    ut::expect( ut::that % overlay_indexed.mod_issues().back()=="Renamed: TrickyPrev=val => TrickyRenamed=val (verify)"sv );
+   };
+
+
+ut::test("rename index against scan") = []
+   {
+    const auto [old_content, new_content] = udt_renamed_contents(300);
+    test::TemporaryFile f_old("~test-renames-old.udt", old_content);
+    test::TemporaryFile f_new("~test-renames-new.udt", new_content);
+
+    issues_t issues;
+    const udt::File udt_old(f_old.path().string(), std::ref(issues));
+    const udt::File udt_new(f_new.path().string(), std::ref(issues));
+
+    sipro::TxtOverlay overlay_scan, overlay_indexed;
+    udt_new.overwrite_values_from(udt_old, overlay_scan);
+    const udt::File::RenameIndex rename_index(udt_new);
+    udt_new.overwrite_values_from(udt_old, overlay_indexed, &rename_index);
+
+    ut::expect( ut::that % overlay_indexed.modified_values_count()==overlay_scan.modified_values_count() );
+    ut::expect( overlay_indexed.mod_issues()==overlay_scan.mod_issues() ) << "index should give the same renames\n";
+    const auto renames_count = std::ranges::count_if(overlay_scan.mod_issues(), [](const std::string& issue){ return issue.starts_with("Renamed:"sv); });
+    ut::expect( renames_count>0 and static_cast<std::size_t>(renames_count)<overlay_scan.mod_issues().size() ) << "expected both renames and missing fields\n";
+   };
+
+
 ut::test("unlabeled variable") = []
    {
     test::TemporaryFile f("~test-unlabeled.udt",
@@ -415,6 +664,198 @@ ut::test("duplicate variable label") = []
     ut::expect( issues.at(0).contains(":3] Duplicate variable label `Same`"sv) ) << issues.at(0);
    };
 
+ut::test("many fields") = []
+   {
+    constexpr int fields_count = 2000;
+    test::TemporaryFile f("~test-scaled.udt", udt_generated_content(fields_count));
+
+    issues_t issues;
+    const udt::File udt_file(f.path().string(), std::ref(issues));
+    ut::expect( ut::that % issues.num==0 ) << "no issues expected\n";
+    ut::expect( ut::fatal(ut::that % udt_file.fields().size()==static_cast<std::size_t>(fields_count)) );
+    int found = 0;
+    for( int i=0; i<fields_count; ++i )
+       {
+        if( const auto* const field = udt_file.get_field_by_label(std::format("vqParam_{}", i));
+            field and field->var_name()==std::format("vq{}", i) ) ++found;
+       }
+    ut::expect( ut::that % found==fields_count );
+    ut::expect( udt_file.get_field_by_label(std::format("vqParam_{}", fields_count))==nullptr );
+   };
+
+ut::test("write applying an overlay") = []
+   {
+    test::TemporaryFile f("~test-scaled.udt", udt_generated_content(300));
+
+    issues_t issues;
+    const udt::File udt_file(f.path().string(), std::ref(issues));
+    ut::expect( ut::that % issues.num==0 ) << "no issues expected\n";
+
+    sipro::TxtOverlay overlay;
+    for( int i=0; i<300; i+=50 )
+       {
+        const auto* const field = udt_file.get_field_by_label(std::format("vqParam_{}", i));
+        ut::expect( ut::fatal(field!=nullptr) );
+        overlay.modify_value(*field, "0"sv);
+       }
+    const MG::options_set options{"no-timestamp"sv};
+
+    // In one go or streaming the pieces
+    test::TemporaryFile f_out("~test-scaled-out.udt");
+    test::TemporaryFile f_streamed("~test-scaled-streamed.udt");
+    udt_file.write_to(f_out.path().string(), overlay, options);
+       {
+        sys::file_write fw( f_streamed.path().string().c_str() );
+        udt_file.write_to(fw, overlay, options, {});
+       }
+
+    const std::string out = f_out.content();
+    ut::expect( ut::that % out==f_streamed.content() ) << "should write the same\n";
+    ut::expect( out.contains("    vq50 = 0 # [mm] Parameter number 50 'vqParam_50'\n"sv) );
+    ut::expect( out.contains("    vq51 = 51.5 # [mm] Parameter number 51 'vqParam_51'\n"sv) );
+    ut::expect( out.contains("  Generated\n    "sv) and out.contains(" 0 issues\n[EndNote]\n"sv) );
+    ut::expect( out.ends_with("    vq299 = 299.5 # [mm] Parameter number 299 'vqParam_299'\n  [EndVars]\n[EndUdt]\n"sv) );
+   };
+
 };///////////////////////////////////////////////////////////////////////////
 #endif // TEST_UNITS ////////////////////////////////////////////////////////
 /////////////////////////////////////////////////////////////////////////////
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+#ifdef TEST_BENCHMARKS //////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+static ut::suite<"udt_file_descriptor_benchmarks"> udt_file_descriptor_benchmarks = []
+{////////////////////////////////////////////////////////////////////////////
+
+ut::test("parse and lookup throughput") = []
+   {
+    const std::string content = udt_generated_content(20000);
+    test::TemporaryFile f("~test-scaled.udt", content);
+
+    constexpr std::size_t reps = 30;
+    const auto ignore_issue = [](std::string&&) noexcept {};
+    const double parse_elapsed = test::seconds_taken(reps, [&]{ std::ignore = udt::File(f.path().string(), ignore_issue).fields().size(); });
+    const std::size_t heap_before = test::heap_in_use;
+    const udt::File udt_file(f.path().string(), ignore_issue);
+    const std::size_t file_heap = test::heap_in_use - heap_before; // The content is mapped
+
+    std::vector<std::string> labels;
+    for( const auto& field : udt_file.fields() ) labels.emplace_back( field.label() );
+    std::map<std::string_view, const sipro::TxtField*> by_label_map; // The previous container, as reference
+    for( const auto& field : udt_file.fields() ) by_label_map.try_emplace(field.label(), &field);
+
+    const auto lookups_per_s = [&labels](const auto& lookup) -> double
+       {
+        std::size_t found = 0;
+        const double elapsed = test::seconds_taken(reps, [&]{ for( const auto& lbl : labels ) if( lookup(lbl) ) ++found; });
+        ut::expect( ut::that % found==reps*labels.size() );
+        return static_cast<double>(found) / elapsed;
+       };
+    const double flat = lookups_per_s([&udt_file](const std::string_view lbl){ return udt_file.get_field_by_label(lbl)!=nullptr; });
+    const double map = lookups_per_s([&by_label_map](const std::string_view lbl){ return by_label_map.find(lbl)!=by_label_map.end(); });
+    ut::log << std::format("{} KiB, {} fields: parse {:.1f} MiB/s, heap {} KiB ({:.1f} bytes per field), lookup by label {:.1f} M/s (std::map {:.1f} M/s)\n",
+                           content.size()/1024, labels.size(),
+                           reps * static_cast<double>(content.size()) / (1024.0*1024.0) / parse_elapsed,
+                           file_heap/1024, static_cast<double>(file_heap)/static_cast<double>(labels.size()),
+                           flat/1e6, map/1e6);
+   };
+
+
+ut::test("write throughput") = []
+   {
+    test::TemporaryFile f("~test-scaled.udt", udt_generated_content(20000));
+    const auto ignore_issue = [](std::string&&) noexcept {};
+    const udt::File udt_file(f.path().string(), ignore_issue);
+
+    sipro::TxtOverlay overlay;
+    for( int i=0; i<20000; i+=50 )
+       {
+        const auto* const field = udt_file.get_field_by_label(std::format("vqParam_{}", i));
+        ut::expect( ut::fatal(field!=nullptr) );
+        overlay.modify_value(*field, "0"sv);
+       }
+    const MG::options_set options{"no-timestamp"sv};
+
+    // The previous writer, streaming each line and rebuilding
+    // token by token the modified ones
+    std::vector<std::string_view> lines;
+    std::vector<const sipro::TxtField*> lines_fields;
+       {
+        sipro::TxtParser parser( udt_file.buf() );
+        while( const auto& line = parser.next_line() ) lines.push_back( line.content() );
+        lines_fields.resize( lines.size() );
+        for( const auto& field : udt_file.fields() ) lines_fields[field.line_index()] = &field;
+       }
+    const auto write_per_token = [&](const std::string& pth)
+       {
+        sys::file_write fw( pth.c_str() );
+        bool block_comment_notyetfound = true;
+        for( std::size_t i=0; i<lines.size(); ++i )
+           {
+            const std::string_view line = lines[i];
+            const sipro::TxtField* const field = lines_fields[i];
+            if( field and overlay.is_value_modified(*field) )
+               {
+                fw << line.substr(0u, static_cast<std::size_t>(field->var_name().data() - line.data()))
+                   << field->var_name() << " = "sv << overlay.value_of(*field);
+                if( field->has_comment() )
+                   {
+                    fw << " # "sv << field->comment();
+                    if( field->has_label() ) fw << " '"sv << field->label() << '\'';
+                   }
+                fw << "\n"sv;
+               }
+            else if( block_comment_notyetfound and line.contains("[EndNote]") )
+               {
+                block_comment_notyetfound = false;
+                fw << "    "sv << app::name << ", "sv << std::to_string(udt_file.mod_issues().size() + overlay.mod_issues().size()) << " issues"sv << "\n"sv << line;
+               }
+            else
+               {
+                fw << line;
+               }
+           }
+       };
+
+    constexpr std::size_t reps = 20;
+    test::TemporaryFile f_old("~test-scaled-old.udt");
+    test::TemporaryFile f_new("~test-scaled-new.udt");
+    const double old_elapsed = test::seconds_taken(reps, [&]{ write_per_token(f_old.path().string()); });
+    const double new_elapsed = test::seconds_taken(reps, [&]{ udt_file.write_to(f_new.path().string(), overlay, options); });
+
+    const std::string out = f_new.content();
+    ut::expect( ut::that % out==f_old.content() ) << "the writers should agree\n";
+    const double mib = reps * static_cast<double>(out.size()) / (1024.0*1024.0);
+    ut::log << std::format("{} KiB with {} modified values: patches {:.1f} MiB/s, per token {:.1f} MiB/s\n",
+                           out.size()/1024, overlay.modified_values_count(), mib/new_elapsed, mib/old_elapsed);
+   };
+
+
+ut::test("rename index against scan") = []
+   {
+    const auto [old_content, new_content] = udt_renamed_contents(3000);
+    test::TemporaryFile f_old("~test-renames-old.udt", old_content);
+    test::TemporaryFile f_new("~test-renames-new.udt", new_content);
+    const auto ignore_issue = [](std::string&&) noexcept {};
+    const udt::File udt_old(f_old.path().string(), ignore_issue);
+    const udt::File udt_new(f_new.path().string(), ignore_issue);
+
+    constexpr std::size_t reps = 3;
+    std::size_t issues_count = 0;
+    const double scan = test::seconds_taken(reps, [&]{ sipro::TxtOverlay overlay;
+                                                       udt_new.overwrite_values_from(udt_old, overlay);
+                                                       issues_count = overlay.mod_issues().size(); });
+    const double index_build = test::seconds_taken(reps, [&]{ std::ignore = udt::File::RenameIndex(udt_new); });
+    const udt::File::RenameIndex rename_index(udt_new);
+    const double indexed = test::seconds_taken(reps, [&]{ sipro::TxtOverlay overlay;
+                                                          udt_new.overwrite_values_from(udt_old, overlay, &rename_index);
+                                                          ut::expect( ut::that % overlay.mod_issues().size()==issues_count ); });
+    ut::log << std::format("{} fields, {} issues: scan {:.1f} ms, indexed {:.1f} ms (index built in {:.1f} ms)\n",
+                           udt_new.fields().size(), issues_count, scan*1e3/reps, indexed*1e3/reps, index_build*1e3/reps);
+   };
+
+};///////////////////////////////////////////////////////////////////////////
+#endif // TEST_BENCHMARKS ///////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,266 @@
+﻿#pragma once
+//  ---------------------------------------------
+//  Adapt again a file each time it or its
+//  parameters DB is saved, keeping both
+//  parsed in memory between the iterations
+//  ---------------------------------------------
+//  #include "watch_adapt.hpp" // app::watch_adapt()
+//  ---------------------------------------------
+#include <string>
+#include <string_view>
+#include <vector>
+#include <optional>
+#include <memory> // std::unique_ptr
+#include <stop_token> // std::stop_token
+#include <stdexcept> // std::runtime_error
+#include <format>
+#include <filesystem> // std::filesystem
+
+#include "os-detect.hpp" // POSIX
+#include "file_watcher.hpp" // sys::file_watcher
+#include "file_write.hpp" // sys::file_write
+#include "string_write.hpp" // MG::string_write
+#include "issues_collector.hpp" // MG::issues
+#include "options_set.hpp" // MG::options_set
+#include "job_unit.hpp" // app::JobUnit
+#include "params_db_cache.hpp" // app::CachedParamsDB
+#include "adapt_udt_file.hpp" // app::overlay_mach_name(), app::overlay_udt_for()
+#include "adapt_parax_file.hpp" // app::overlay_parax_for()
+
+namespace fs = std::filesystem;
+using namespace std::literals; // "..."sv
+
+
+namespace app //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+/////////////////////////////////////////////////////////////////////////////
+// The parsed target and DB of an adaptation, each one reloaded
+// only when its file changes. The output is rewritten only if
+// its content differs, regardless of the timestamp
+class WatchedAdaptation final
+{
+ private:
+    fs::path m_target_path;
+    fs::path m_db_path;
+    fs::path m_out_path;
+    macotec::MachineData m_mach_data;
+    MG::options_set m_options;
+    bool m_is_parax;
+
+    std::optional<udt::File> m_udt_file;
+    std::optional<parax::File> m_parax_file;
+    std::vector<std::string> m_target_issues;
+    std::unique_ptr<CachedParamsDB> m_db;
+    std::optional<std::string> m_last_output; // Without timestamp
+    std::size_t m_modified_values_count = 0;
+
+ public:
+    explicit WatchedAdaptation(const JobUnit& job, const MG::options_set& options)
+      : m_target_path{ job.target_file().path() }
+      , m_db_path{ job.db_file().path() }
+      , m_out_path{ job.out_path() }
+      , m_mach_data{ job.mach_data() }
+      , m_options{ options }
+      , m_is_parax{ job.is_adapt_parax() }
+       {}
+
+    [[nodiscard]] const fs::path& target_path() const noexcept { return m_target_path; }
+    [[nodiscard]] const fs::path& db_path() const noexcept { return m_db_path; }
+    [[nodiscard]] std::size_t modified_values_count() const noexcept { return m_modified_values_count; }
+
+    //-----------------------------------------------------------------------
+    void reload_target()
+       {
+        m_udt_file.reset();
+        m_parax_file.reset();
+        m_target_issues.clear();
+        const auto record_issue = [this](std::string&& msg){ m_target_issues.push_back( std::move(msg) ); };
+        if( m_is_parax ) m_parax_file.emplace(m_target_path.string(), record_issue);
+        else             m_udt_file.emplace(m_target_path.string(), record_issue);
+       }
+
+    //-----------------------------------------------------------------------
+    void reload_db()
+       {
+        // Just the changed blocks are parsed again
+        m_db = std::make_unique<CachedParamsDB>(m_db_path, m_db.get());
+       }
+
+    //-----------------------------------------------------------------------
+    // Returns true if the output was rewritten
+    bool update_output(fnotify_t const& notify_issue)
+       {
+        if( not m_udt_file and not m_parax_file ) reload_target();
+        if( not m_db ) reload_db();
+
+        for( const auto& issue : m_target_issues )
+           {
+            notify_issue( std::string{issue} );
+           }
+        m_db->notify_parse_issues(notify_issue);
+
+        sipro::TxtOverlay overlay;
+        const sipro::TxtFile& file = m_is_parax ? static_cast<const sipro::TxtFile&>(*m_parax_file) : *m_udt_file;
+        std::string add_info;
+        if( m_is_parax )
+           {
+            overlay_parax_for(*m_parax_file, m_db->parax_db_for(m_mach_data, notify_issue), m_db->path(), overlay, notify_issue);
+            add_info = std::format("Machine: {}", m_mach_data.string());
+           }
+        else
+           {
+            const macotec::MachineData mach_data = overlay_mach_name(*m_udt_file, m_mach_data, overlay, notify_issue);
+            overlay_udt_for(*m_udt_file, m_db->udt_db_for(mach_data, notify_issue), m_db->path(), overlay, notify_issue);
+           }
+        m_modified_values_count = overlay.modified_values_count();
+
+        MG::options_set cmp_options{ m_options };
+        cmp_options.insert("no-timestamp"sv);
+        MG::string_write out;
+        file.write_to(out, overlay, cmp_options, add_info);
+        if( m_last_output and *m_last_output==out.str() and fs::exists(m_out_path) )
+           {
+            return false;
+           }
+
+        if( m_options.contains("no-timestamp"sv) )
+           {
+            sys::file_write fw( m_out_path.string().c_str() );
+            fw << out.str();
+           }
+        else
+           {
+            file.write_to(m_out_path.string(), overlay, m_options, add_info);
+           }
+        m_last_output = out.str();
+        return true;
+       }
+};
+
+
+//---------------------------------------------------------------------------
+// Adapt and then again each time the target or the DB are saved
+template<typename FPRINT>
+void watch_adapt( const JobUnit& job,
+                  const MG::options_set& options,
+                  FPRINT const& print,
+                  std::stop_token stop ={} )
+{
+  #if defined(POSIX)
+    WatchedAdaptation adaptation(job, options);
+    sys::file_watcher watcher;
+    watcher.add(adaptation.target_path());
+    watcher.add(adaptation.db_path());
+
+    const fs::path target_path = fs::absolute(adaptation.target_path()).lexically_normal();
+    const fs::path db_path = fs::absolute(adaptation.db_path()).lexically_normal();
+    std::vector<fs::path> changed{ target_path, db_path };
+    while( true )
+       {
+        MG::issues issues;
+        try{
+            for( const auto& pth : changed )
+               {
+                if( pth==target_path ) adaptation.reload_target();
+                else if( pth==db_path ) adaptation.reload_db();
+               }
+            const bool rewritten = adaptation.update_output( std::ref(issues) );
+            print("{} modified {} values, {} issues, {}\n", job.out_path().string(), adaptation.modified_values_count(), issues.size(), rewritten ? "rewritten"sv : "unchanged"sv);
+           }
+        catch( parse::error& e )
+           {
+            issues( std::format("[{}:{}] {}", e.file(), e.line(), e.what()) );
+           }
+        catch( std::exception& e )
+           {
+            issues( e.what() );
+           }
+        for( const auto& issue : issues )
+           {
+            print("! {}\n", issue);
+           }
+
+        do{ changed = watcher.wait_changes(200); }
+        while( changed.empty() and not stop.stop_requested() );
+        if( stop.stop_requested() )
+           {
+            break;
+           }
+       }
+  #else
+    throw std::runtime_error("Watch mode needs inotify, unavailable here");
+  #endif
+}
+
+}//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+#ifdef TEST_UNITS ///////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+static ut::suite<"watch_adapt"> watch_adapt_tests = []
+{////////////////////////////////////////////////////////////////////////////
+
+struct issues_t final { int num=0; void operator()(std::string&& msg) noexcept {++num; ut::log << msg << '\n';}; };
+
+ut::test("app::WatchedAdaptation") = []
+   {
+    test::TemporaryDirectory tmp_dir;
+    const auto udt = tmp_dir.create_file("MachSettings.udt",
+        "va0 = \"ActiveHP-6.0/4.6\" # Mandatory field 'vaMachName'\n"
+        "vn123 = 0 # Should be overwritten 'vnType'\n"
+        "vn124 = 0 # Another 'vnOther'\n"sv);
+    const auto db = tmp_dir.create_file("udt-overlays.txt",
+        "HP:{\n"
+        "    \"common\": { vnType: 11 }\n"
+        "   }\n"sv);
+    const auto out = tmp_dir.decl_file("out.udt");
+
+    app::JobUnit job;
+    job.set_target_file(udt.path().string());
+    job.set_db_file(db.path().string());
+    job.add_mach_data("ActiveHP-6.0/4.6"sv);
+    job.detect_task();
+    job.ensure_out_path(out.path().string());
+
+    issues_t issues;
+    app::WatchedAdaptation adaptation(job, {});
+    ut::expect( adaptation.update_output(std::ref(issues)) ) << "first output should be written\n";
+    ut::expect( ut::that % adaptation.modified_values_count()==2u );
+    ut::expect( not adaptation.update_output(std::ref(issues)) ) << "same output shouldn't be rewritten\n";
+
+    std::ignore = tmp_dir.create_file("udt-overlays.txt",
+        "HP:{\n"
+        "    \"common\": { vnType: 11, vnOther: 22 }\n"
+        "   }\n"sv);
+    adaptation.reload_db();
+    ut::expect( adaptation.update_output(std::ref(issues)) ) << "changed DB should rewrite output\n";
+    ut::expect( ut::that % adaptation.modified_values_count()==3u );
+    check_field(udt::File(out.path().string(), std::ref(issues)), "vn124"sv, "22"sv, "Another"sv, "vnOther"sv);
+
+    std::ignore = tmp_dir.create_file("MachSettings.udt",
+        "va0 = \"ActiveHP-6.0/4.6\" # Mandatory field 'vaMachName'\n"
+        "vn123 = 0 # Should be overwritten 'vnType'\n"
+        "vn124 = 0 # Another 'vnOther'\n"
+        "vn125 = 0 # New 'vnNew'\n"sv);
+    adaptation.reload_target();
+    ut::expect( adaptation.update_output(std::ref(issues)) ) << "changed target should rewrite output\n";
+    check_field(udt::File(out.path().string(), std::ref(issues)), "vn125"sv, "0"sv, "New"sv, "vnNew"sv);
+
+    std::ignore = tmp_dir.create_file("udt-overlays.txt",
+        "HP:{\n"
+        "    \"common\": { vnType: 11, vnOther: 22, vnNew: 0.0 }\n"
+        "   }\n"sv);
+    adaptation.reload_db();
+    ut::expect( not adaptation.update_output(std::ref(issues)) ) << "numerically same value shouldn't rewrite output\n";
+    ut::expect( ut::that % adaptation.modified_values_count()==3u );
+
+    ut::expect( ut::that % issues.num==0 ) << "no issues expected\n";
+   };
+
+};///////////////////////////////////////////////////////////////////////////
+#endif // TEST_UNITS ////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
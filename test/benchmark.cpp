@@ -0,0 +1,64 @@
+﻿#define BOOST_UT_DISABLE_MODULE
+//#include <https://raw.githubusercontent.com/boost-ext/ut/master/include/boost/ut.hpp>
+#include "ut.hpp" // import boost.ut;
+namespace ut = boost::ut;
+
+// Timings of the optimized code, kept out of the unit tests
+#define TEST_BENCHMARKS
+#include "test_facilities.hpp" // test::*
+
+#include <cstdlib> // std::malloc, std::free
+#include <new> // std::bad_alloc
+#include <atomic>
+
+//---------------------------------------------------------------------------
+// The heap bytes in use, to measure the memory taken by an object
+namespace test { std::atomic<std::size_t> heap_in_use = 0; }
+
+void* operator new(std::size_t size)
+{// The size is kept before the returned block
+    constexpr std::size_t header = alignof(std::max_align_t);
+    void* const p = std::malloc(size + header);
+    if( not p ) throw std::bad_alloc{};
+    *static_cast<std::size_t*>(p) = size;
+    test::heap_in_use += size;
+    return static_cast<char*>(p) + header;
+}
+
+void operator delete(void* const p) noexcept
+{
+    if( p )
+       {
+        constexpr std::size_t header = alignof(std::max_align_t);
+        void* const block = static_cast<char*>(p) - header;
+        test::heap_in_use -= *static_cast<std::size_t*>(block);
+        std::free(block);
+       }
+}
+
+void operator delete(void* const p, std::size_t) noexcept
+{
+    ::operator delete(p);
+}
+
+// The includes in main.cpp:
+#include "arguments.hpp"
+#include "issues_collector.hpp"
+#include "edit_text_file.hpp"
+#include "adapt_udt_file.hpp"
+#include "adapt_parax_file.hpp"
+#include "adapt_fleet.hpp"
+#include "jobs_manifest.hpp"
+#include "adapt_server.hpp"
+#include "watch_adapt.hpp"
+#include "filter_adapt.hpp"
+#include "overlays_cache.hpp"
+#include "query_db.hpp"
+#include "db_coverage.hpp"
+#include "macotec_parameters_database.hpp"
+#include "handle_output_file.hpp"
+
+int main()
+{
+    ut::expect(true);
+}
@@ -12,6 +12,15 @@ namespace ut = boost::ut;
 #include "edit_text_file.hpp"
 #include "adapt_udt_file.hpp"
 #include "adapt_parax_file.hpp"
+#include "adapt_fleet.hpp"
+#include "jobs_manifest.hpp"
+#include "adapt_server.hpp"
+#include "watch_adapt.hpp"
+#include "filter_adapt.hpp"
+#include "overlays_cache.hpp"
+#include "query_db.hpp"
+#include "db_coverage.hpp"
+#include "macotec_parameters_database.hpp"
 #include "handle_output_file.hpp"
 
 int main()
@@ -278,4 +278,15 @@ class TemporaryDirectory final : public Directory
        }
 };
 
+
+//---------------------------------------------------------------------------
+// Seconds taken by some runs of a function, for the benchmarks
+template<typename F>
+[[nodiscard]] double seconds_taken(const std::size_t runs, F const& fn)
+{
+    const auto start = std::chrono::steady_clock::now();
+    for( std::size_t i=0; i<runs; ++i ) fn();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
 }//::::::::::::::::::::::::::::::::: test :::::::::::::::::::::::::::::::::::